@@ -0,0 +1,75 @@
+#include <vector>
+
+#include "benchmarks/harness.h"
+#include "hop/core/function.h"
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "nth/container/stack.h"
+
+// This benchmark measures the overhead of invoking a small predicate once per
+// row of a large input, comparing a loop over `Function<Set>::invoke` with a
+// single call to `Function<Set>::invoke_batch`. The predicate computes whether
+// `3 * x + 1 < 1000`, so almost all of the time spent is invocation overhead.
+// Results are reported per row.
+//
+// Usage:
+//
+//     batch [--filter=<substring>] [--min_time_ms=<ms>] [--json=<path>]
+
+using Instructions =
+    hop::MakeInstructionSet<hop::Push<uint64_t>, hop::Add<uint64_t>,
+                            hop::Multiply<uint64_t>, hop::LessThan<uint64_t>>;
+
+constexpr size_t Rows = 1'000'000;
+
+void BuildPredicate(hop::Function<Instructions>& func) {
+  func.append<hop::Push<uint64_t>>(3);
+  func.append<hop::Multiply<uint64_t>>();
+  func.append<hop::Push<uint64_t>>(1);
+  func.append<hop::Add<uint64_t>>();
+  func.append<hop::Push<uint64_t>>(1000);
+  func.append<hop::LessThan<uint64_t>>();
+  func.append<hop::Return>();
+}
+
+int main(int argc, char const* argv[]) {
+  benchmarks::Options options = benchmarks::ParseOptions(argc, argv);
+  if (not benchmarks::NoUnparsedArguments(options)) { return 1; }
+
+  hop::Function<Instructions> func(1, 1);
+  BuildPredicate(func);
+
+  std::vector<hop::Value> arguments;
+  arguments.reserve(Rows);
+  for (size_t i = 0; i < Rows; ++i) { arguments.push_back(uint64_t{i % 1000}); }
+  std::vector<hop::Value> results(Rows, hop::Value::Uninitialized());
+
+  std::vector<benchmarks::Benchmark> benchmarks = {
+      {
+          .name       = "batch/invoke",
+          .operations = Rows,
+          .run =
+              [&](uint64_t repetitions) {
+                for (uint64_t i = 0; i < repetitions; ++i) {
+                  for (size_t j = 0; j < Rows; ++j) {
+                    nth::stack<hop::Value> stack = {arguments[j]};
+                    func.invoke(stack);
+                    results[j] = stack.top();
+                  }
+                }
+              },
+      },
+      {
+          .name       = "batch/invoke_batch",
+          .operations = Rows,
+          .run =
+              [&](uint64_t repetitions) {
+                for (uint64_t i = 0; i < repetitions; ++i) {
+                  func.invoke_batch(arguments, results);
+                }
+              },
+      },
+  };
+  return benchmarks::RunBenchmarks(benchmarks, options);
+}
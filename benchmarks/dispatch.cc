@@ -0,0 +1,98 @@
+#include <vector>
+
+#include "benchmarks/harness.h"
+#include "hop/core/function.h"
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "hop/testing/fibonacci.h"
+#include "nth/container/interval.h"
+#include "nth/container/stack.h"
+
+// This benchmark compares the two dispatch strategies available to the
+// interpreter on the same bytecode: tail-calls between instructions, and a
+// single loop per instruction set dispatching with computed gotos (see
+// "hop/core/internal/dispatch_loop.h"). Each is run on the recursive Fibonacci
+// implementation from "examples/fibonacci.cc", which is dominated by calls,
+// and on an iterative countdown, which is dominated by backward branches.
+//
+// Regardless of the `//hop/configuration:dispatch` flag, both strategies are
+// measured by invoking them directly.
+//
+// Usage:
+//
+//     dispatch [--filter=<substring>] [--min_time_ms=<ms>] [--json=<path>]
+
+using Instructions = hop::MakeInstructionSet<
+    hop::Duplicate, hop::Swap, hop::Push<uint64_t>,
+    hop::Push<hop::Function<>*>, hop::LessThan<uint64_t>, hop::Add<uint64_t>,
+    hop::Subtract<uint64_t>>;
+
+using frame_type =
+    hop::internal::Frame<hop::internal::FunctionState<Instructions>>;
+
+constexpr uint64_t N = 25;
+// Roughly as many dispatches as computing the `N`th Fibonacci number.
+constexpr uint64_t Count = uint64_t{1} << (N * 7 / 10);
+
+// Counts down from its argument to zero, returning zero.
+void BuildCountdown(hop::Function<Instructions>& func) {
+  nth::interval<hop::InstructionIndex> loop =
+      func.append<hop::Push<uint64_t>>(1);
+  func.append<hop::Subtract<uint64_t>>();
+  func.append<hop::Duplicate>();
+  func.append<hop::Push<uint64_t>>(0);
+  func.append<hop::Swap>();
+  func.append<hop::LessThan<uint64_t>>();
+  nth::interval<hop::InstructionIndex> jump =
+      func.append_with_placeholders<hop::JumpIf>();
+  func.append<hop::Return>();
+  func.set_value(jump, 0, loop.lower_bound() - jump.lower_bound());
+}
+
+void TailCall(hop::Function<Instructions> const& func,
+              nth::stack<hop::Value>& stack) {
+  nth::stack<frame_type> call_stack;
+  hop::internal::InvokeThreaded<Instructions>(stack, call_stack, func.entry());
+}
+
+void ComputedGoto(hop::Function<Instructions> const& func,
+                  nth::stack<hop::Value>& stack) {
+  nth::stack<frame_type> call_stack;
+  hop::internal::InvokeDispatchLoop<Instructions>(stack, call_stack,
+                                                  func.entry());
+}
+
+template <typename F>
+benchmarks::Benchmark Run(char const* name,
+                          hop::Function<Instructions> const& func,
+                          uint64_t argument, F f) {
+  return {
+      .name = name,
+      .run =
+          [&func, argument, f](uint64_t repetitions) {
+            for (uint64_t i = 0; i < repetitions; ++i) {
+              nth::stack<hop::Value> stack = {argument};
+              f(func, stack);
+            }
+          },
+  };
+}
+
+int main(int argc, char const* argv[]) {
+  benchmarks::Options options = benchmarks::ParseOptions(argc, argv);
+  if (not benchmarks::NoUnparsedArguments(options)) { return 1; }
+
+  hop::Function<Instructions> fibonacci(1, 1);
+  hop::BuildFibonacci(fibonacci);
+  hop::Function<Instructions> countdown(1, 1);
+  BuildCountdown(countdown);
+
+  std::vector<benchmarks::Benchmark> benchmarks = {
+      Run("dispatch/fibonacci/tail-call", fibonacci, N, TailCall),
+      Run("dispatch/fibonacci/computed-goto", fibonacci, N, ComputedGoto),
+      Run("dispatch/countdown/tail-call", countdown, Count, TailCall),
+      Run("dispatch/countdown/computed-goto", countdown, Count, ComputedGoto),
+  };
+  return benchmarks::RunBenchmarks(benchmarks, options);
+}
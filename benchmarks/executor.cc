@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <atomic>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmarks/harness.h"
+#include "hop/core/executor.h"
+#include "hop/core/function.h"
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "hop/testing/fibonacci.h"
+
+// This benchmark measures how the throughput of an `Executor` scales with its
+// number of workers, from one up to the hardware concurrency in powers of two.
+// Each job computes a small Fibonacci number, so that the time spent
+// submitting and claiming jobs is a significant fraction of the total, and
+// contention in the executor itself limits scaling. Results are reported per
+// job, including the time to start and join the workers.
+//
+// Usage:
+//
+//     executor [--filter=<substring>] [--min_time_ms=<ms>] [--json=<path>]
+
+using Instructions = hop::MakeInstructionSet<
+    hop::Duplicate, hop::Swap, hop::Push<hop::Function<>*>,
+    hop::Push<uint64_t>, hop::LessThan<uint64_t>, hop::Add<uint64_t>,
+    hop::Subtract<uint64_t>>;
+
+constexpr size_t Jobs = 100'000;
+constexpr uint64_t N  = 10;
+
+int main(int argc, char const* argv[]) {
+  benchmarks::Options options = benchmarks::ParseOptions(argc, argv);
+  if (not benchmarks::NoUnparsedArguments(options)) { return 1; }
+
+  hop::Function<Instructions> func(1, 1);
+  hop::BuildFibonacci(func);
+
+  size_t max_workers =
+      std::max(size_t{std::thread::hardware_concurrency()}, size_t{1});
+  std::vector<benchmarks::Benchmark> benchmarks;
+  for (size_t workers = 1; workers <= max_workers; workers *= 2) {
+    benchmarks.push_back({
+        .name       = "executor/workers:" + std::to_string(workers),
+        .operations = Jobs,
+        .run =
+            [&func, workers](uint64_t repetitions) {
+              std::atomic<uint64_t> sum = 0;
+              for (uint64_t i = 0; i < repetitions; ++i) {
+                hop::Executor<Instructions> executor(workers);
+                for (size_t j = 0; j < Jobs; ++j) {
+                  executor.submit(
+                      {.function = &func, .arguments = {N}},
+                      [&](std::span<hop::Value const> results) {
+                        sum.fetch_add(results[0].as<uint64_t>(),
+                                      std::memory_order_relaxed);
+                      });
+                }
+                // Destroying the executor waits for all submitted jobs.
+              }
+            },
+    });
+  }
+  return benchmarks::RunBenchmarks(benchmarks, options);
+}
@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <vector>
+
+#include "benchmarks/harness.h"
+#include "hop/core/function.h"
+#include "hop/core/metadata.h"
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "hop/testing/fibonacci.h"
+#include "hop/transform/fuse.h"
+#include "nth/container/stack.h"
+
+// This benchmark measures the effect of superinstruction fusion on the
+// recursive Fibonacci implementation from "examples/fibonacci.cc". The same
+// function is built twice in an instruction set containing superinstructions,
+// and one copy is rewritten by `hop::FuseInstructions`. We report the time per
+// instruction dispatch for each.
+//
+// Usage:
+//
+//     fusion [--filter=<substring>] [--min_time_ms=<ms>] [--json=<path>]
+
+using Instructions = hop::MakeInstructionSet<
+    hop::Duplicate, hop::Swap, hop::Push<uint64_t>,
+    hop::Push<hop::Function<>*>, hop::LessThan<uint64_t>, hop::Add<uint64_t>,
+    hop::Subtract<uint64_t>,
+    hop::Fused<hop::Push<uint64_t>, hop::LessThan<uint64_t>, hop::JumpIf>,
+    hop::Fused<hop::Push<uint64_t>, hop::Subtract<uint64_t>>>;
+
+constexpr uint64_t N = 25;
+
+// Returns the number of dispatches required to compute the `n`th Fibonacci
+// number with `func`. Calls with `n < 2` execute each instruction up to and
+// including the first branch, followed by `Return`. All other calls execute
+// every instruction in the function exactly once. There are `fib(n + 1)` calls
+// of the first kind and `fib(n + 1) - 1` of the second.
+uint64_t DispatchCount(hop::Function<Instructions> const& func, uint64_t n) {
+  auto const& metadata       = hop::Metadata<Instructions>();
+  uint64_t instruction_count = 0;
+  uint64_t base_case_count   = 0;
+  std::span insts            = func.raw_instructions();
+  while (not insts.empty()) {
+    ++instruction_count;
+    auto op_code = insts[0].as<hop::internal::exec_fn_type>();
+    if (base_case_count == 0 and
+        (op_code == &hop::JumpIf::ExecuteImpl<Instructions> or
+         op_code == &hop::Fused<hop::Push<uint64_t>, hop::LessThan<uint64_t>,
+                                hop::JumpIf>::ExecuteImpl<Instructions>)) {
+      base_case_count = instruction_count + 1;
+    }
+    insts = insts.subspan(
+        1 + metadata.metadata(metadata.opcode(insts[0])).immediate_value_count);
+  }
+
+  uint64_t a = 0, b = 1;
+  for (uint64_t i = 0; i <= n; ++i) {
+    uint64_t c = a + b;
+    a          = b;
+    b          = c;
+  }
+  uint64_t leaves = a;
+  return leaves * base_case_count + (leaves - 1) * instruction_count;
+}
+
+benchmarks::Benchmark Fibonacci(char const* name,
+                                hop::Function<Instructions> const& func) {
+  return {
+      .name       = name,
+      .operations = DispatchCount(func, N),
+      .run =
+          [&func](uint64_t repetitions) {
+            for (uint64_t i = 0; i < repetitions; ++i) {
+              nth::stack<hop::Value> stack = {N};
+              func.invoke(stack);
+            }
+          },
+  };
+}
+
+int main(int argc, char const* argv[]) {
+  benchmarks::Options options = benchmarks::ParseOptions(argc, argv);
+  if (not benchmarks::NoUnparsedArguments(options)) { return 1; }
+
+  hop::Function<Instructions> unfused(1, 1);
+  hop::BuildFibonacci(unfused);
+
+  hop::Function<Instructions> fused(1, 1);
+  hop::BuildFibonacci(fused);
+  size_t removed = hop::FuseInstructions(fused);
+  std::fprintf(stderr, "Fused %zu instructions away.\n", removed);
+
+  std::vector<benchmarks::Benchmark> benchmarks = {
+      Fibonacci("fusion/unfused", unfused),
+      Fibonacci("fusion/fused", fused),
+  };
+  return benchmarks::RunBenchmarks(benchmarks, options);
+}
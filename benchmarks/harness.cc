@@ -0,0 +1,118 @@
+#include "benchmarks/harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+namespace benchmarks {
+namespace {
+
+void WriteJsonString(std::string_view s, std::FILE *file) {
+  std::fputc('"', file);
+  for (char c : s) {
+    switch (c) {
+      case '"': std::fputs("\\\"", file); break;
+      case '\\': std::fputs("\\\\", file); break;
+      case '\n': std::fputs("\\n", file); break;
+      default: std::fputc(c, file); break;
+    }
+  }
+  std::fputc('"', file);
+}
+
+}  // namespace
+
+Options ParseOptions(int argc, char const *argv[]) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view argument = argv[i];
+    if (argument.starts_with("--filter=")) {
+      options.filter = argument.substr(9);
+    } else if (argument.starts_with("--min_time_ms=")) {
+      options.min_time =
+          std::chrono::milliseconds(std::atoll(argv[i] + 14));
+    } else if (argument.starts_with("--json=")) {
+      options.json = argument.substr(7);
+    } else {
+      options.unparsed.push_back(argument);
+    }
+  }
+  return options;
+}
+
+bool NoUnparsedArguments(Options const &options) {
+  for (std::string_view argument : options.unparsed) {
+    std::fprintf(stderr, "Unrecognized argument: %.*s\n",
+                 static_cast<int>(argument.size()), argument.data());
+  }
+  return options.unparsed.empty();
+}
+
+Result Measure(Benchmark const &benchmark, std::chrono::milliseconds min_time) {
+  uint64_t repetitions = 1;
+  while (true) {
+    auto start = std::chrono::steady_clock::now();
+    benchmark.run(repetitions);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (elapsed >= min_time) {
+      return {
+          .name        = benchmark.name,
+          .repetitions = repetitions,
+          .operations  = benchmark.operations,
+          .elapsed =
+              std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed),
+      };
+    }
+    repetitions *= 2;
+  }
+}
+
+void WriteJson(std::span<Result const> results, std::FILE *file) {
+  std::fputs("{\n  \"benchmarks\": [", file);
+  for (size_t i = 0; i < results.size(); ++i) {
+    Result const &result = results[i];
+    std::fputs(i == 0 ? "\n    {\"name\": " : ",\n    {\"name\": ", file);
+    WriteJsonString(result.name, file);
+    std::fprintf(file,
+                 ", \"repetitions\": %" PRIu64 ", \"operations\": %" PRIu64
+                 ", \"elapsed_ns\": %" PRId64
+                 ", \"ns_per_operation\": %.3f}",
+                 result.repetitions, result.operations,
+                 static_cast<int64_t>(result.elapsed.count()),
+                 result.nanoseconds_per_operation());
+  }
+  std::fputs("\n  ]\n}\n", file);
+}
+
+int RunBenchmarks(std::span<Benchmark const> benchmarks,
+                  Options const &options) {
+  std::vector<Result> results;
+  std::fprintf(stderr, "%-40s %14s %14s\n", "benchmark", "repetitions",
+               "ns/op");
+  for (Benchmark const &benchmark : benchmarks) {
+    if (benchmark.name.find(options.filter) == std::string::npos) { continue; }
+    Result const &result =
+        results.emplace_back(Measure(benchmark, options.min_time));
+    std::fprintf(stderr, "%-40s %14" PRIu64 " %14.3f\n", result.name.c_str(),
+                 result.repetitions, result.nanoseconds_per_operation());
+  }
+
+  if (options.json.empty()) { return 0; }
+  if (options.json == "-") {
+    WriteJson(results, stdout);
+    return 0;
+  }
+  std::FILE *file = std::fopen(options.json.c_str(), "w");
+  if (not file) {
+    std::fprintf(stderr, "Failed to open %s.\n", options.json.c_str());
+    return 1;
+  }
+  WriteJson(results, file);
+  return std::fclose(file) == 0 ? 0 : 1;
+}
+
+}  // namespace benchmarks
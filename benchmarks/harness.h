@@ -0,0 +1,75 @@
+#ifndef JASMIN_BENCHMARKS_HARNESS_H
+#define JASMIN_BENCHMARKS_HARNESS_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace benchmarks {
+
+// A single benchmark. Each invocation of `run` performs the measured work
+// `repetitions` times, and each repetition performs `operations` operations,
+// so that results may be reported per operation.
+struct Benchmark {
+  std::string name;
+  uint64_t operations = 1;
+  std::function<void(uint64_t repetitions)> run;
+};
+
+// The measurement of a single benchmark.
+struct Result {
+  std::string name;
+  uint64_t repetitions;
+  uint64_t operations;
+  std::chrono::nanoseconds elapsed;
+
+  double nanoseconds_per_operation() const {
+    return static_cast<double>(elapsed.count()) /
+           static_cast<double>(repetitions * operations);
+  }
+};
+
+struct Options {
+  // Only benchmarks whose name contains `filter` are run.
+  std::string filter;
+  // Each benchmark is repeated until it has run for at least `min_time`.
+  std::chrono::milliseconds min_time = std::chrono::milliseconds(500);
+  // If non-empty, results are written as JSON to the file at this path, or to
+  // standard output if the path is "-".
+  std::string json;
+  // Command-line arguments not recognized by `ParseOptions`.
+  std::vector<std::string_view> unparsed;
+};
+
+// Parses the flags `--filter=`, `--min_time_ms=`, and `--json=` from the
+// command-line. All other arguments are left in `Options::unparsed`.
+Options ParseOptions(int argc, char const *argv[]);
+
+// Reports each argument in `options.unparsed` as unrecognized on standard
+// error. Returns whether there were none, for binaries which accept no
+// arguments beyond those parsed by `ParseOptions`.
+bool NoUnparsedArguments(Options const &options);
+
+// Runs `benchmark`, doubling the number of repetitions until the elapsed time
+// is at least `min_time`.
+Result Measure(Benchmark const &benchmark, std::chrono::milliseconds min_time);
+
+// Writes `results` to `file` as a JSON object with a single "benchmarks" key
+// holding an array with one object per result.
+void WriteJson(std::span<Result const> results, std::FILE *file);
+
+// Runs each benchmark in `benchmarks` selected by `options`, printing a table
+// of results to standard error and, if requested, writing them as JSON.
+// Returns zero on success and a non-zero value if the JSON file could not be
+// written.
+int RunBenchmarks(std::span<Benchmark const> benchmarks,
+                  Options const &options);
+
+}  // namespace benchmarks
+
+#endif  // JASMIN_BENCHMARKS_HARNESS_H
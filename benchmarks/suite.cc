@@ -0,0 +1,444 @@
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "benchmarks/harness.h"
+#include "examples/brainfuck/build.h"
+#include "examples/brainfuck/file.h"
+#include "examples/brainfuck/instructions.h"
+#include "examples/brainfuck/x64_code_generator.h"
+#include "hop/compile/compiled_function.h"
+#include "hop/core/function.h"
+#include "hop/core/function_builder.h"
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/bool.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "hop/instructions/stack.h"
+#include "hop/ssa/ssa.h"
+#include "nth/container/interval.h"
+#include "nth/container/stack.h"
+#include "nth/dynamic/jit_function.h"
+
+// This binary runs a suite of benchmarks covering the interpreter's hot paths.
+// Microbenchmarks each invoke a function whose body repeats a short sequence
+// of instructions `Unroll` times, and report the time per sequence. Where an
+// instruction cannot be executed in isolation without changing the size of the
+// value stack, the sequence includes the instructions needed to restore it
+// (e.g., "common/Push+Drop"); these may be compared against one another to
+// estimate the cost of each instruction. Macrobenchmarks run whole programs:
+// recursive and dynamic-programming Fibonacci implementations from
+// "examples/fibonacci.cc", and "examples/brainfuck/mandelbrot.bf" through both
+// the interpreter and the x64 JIT. Build benchmarks measure the construction
+// of functions, both via `hop::Function::append` and `hop::FunctionBuilder`.
+//
+// Usage:
+//
+//     suite [--filter=<substring>] [--min_time_ms=<ms>] [--json=<path>]
+//           [--mandelbrot=<path>]
+//
+// A table of results is written to standard error. With `--json`, results are
+// also written as JSON to `<path>`, or to standard output if `<path>` is "-".
+// Note that the Brainfuck programs write their output to standard output.
+
+namespace {
+
+using benchmarks::Benchmark;
+
+constexpr uint64_t Unroll = 64;
+
+struct UpdateFibonacci : hop::Instruction<UpdateFibonacci> {
+  static void consume(hop::Input<int64_t, int64_t, int64_t> in,
+                      hop::Output<int64_t, int64_t, int64_t> out) {
+    out.set<0>(in.get<0>() - 1);
+    out.set<1>(in.get<2>());
+    out.set<2>(in.get<1>() + in.get<2>());
+  }
+};
+
+using Instructions = hop::MakeInstructionSet<
+    hop::Push<int64_t>, hop::Push<bool>, hop::Push<hop::Function<> *>,
+    hop::Drop, hop::Swap, hop::Rotate, hop::Duplicate, hop::DuplicateAt,
+    hop::Add<int64_t>, hop::Subtract<int64_t>, hop::Multiply<int64_t>,
+    hop::Divide<int64_t>, hop::Mod<int64_t>, hop::Negate<int64_t>,
+    hop::LessThan<int64_t>, hop::Equal<int64_t>, hop::Not, hop::And, hop::Or,
+    hop::Xor, UpdateFibonacci>;
+
+// Instructions with function state are kept in their own instruction set, so
+// that the state is not constructed for every frame in other benchmarks.
+using StatefulInstructions =
+    hop::MakeInstructionSet<hop::StackAllocate, hop::StackOffset, hop::Drop>;
+
+template <typename Set>
+using FunctionPtr = std::shared_ptr<hop::Function<Set>>;
+
+// Returns a function with `parameters` parameters and as many return values,
+// whose body consists of `prologue`, followed by `Unroll` repetitions of
+// `body`, followed by `Return`.
+template <typename Set>
+FunctionPtr<Set> Unrolled(uint32_t parameters, auto prologue, auto body) {
+  auto f = std::make_shared<hop::Function<Set>>(parameters, parameters);
+  prologue(*f);
+  for (uint64_t i = 0; i < Unroll; ++i) { body(*f); }
+  f->template append<hop::Return>();
+  return f;
+}
+
+// Returns a benchmark invoking `f` on `arguments` once per repetition. `f` must
+// return as many values as it accepts, so that the value stack may be reused.
+template <typename Set>
+Benchmark Invocation(std::string name, FunctionPtr<Set> f,
+                     std::vector<hop::Value> arguments,
+                     uint64_t operations = Unroll) {
+  return {
+      .name       = std::move(name),
+      .operations = operations,
+      .run =
+          [f, arguments = std::move(arguments)](uint64_t repetitions) {
+            nth::stack<hop::Value> stack;
+            for (hop::Value argument : arguments) { stack.push(argument); }
+            for (uint64_t i = 0; i < repetitions; ++i) { f->invoke(stack); }
+          },
+  };
+}
+
+// Adds a benchmark invoking a function on `arguments` whose body repeats
+// `body` `Unroll` times.
+template <typename Set = Instructions>
+void AddUnrolled(std::vector<Benchmark> &benchmarks, std::string name,
+                 std::vector<hop::Value> arguments, auto body) {
+  uint32_t parameters = arguments.size();
+  benchmarks.push_back(Invocation(
+      std::move(name),
+      Unrolled<Set>(parameters, [](hop::Function<Set> &) {}, body),
+      std::move(arguments)));
+}
+
+using F = hop::Function<Instructions>;
+
+// Appends instructions computing `x op k` for the integer `x` on top of the
+// value stack.
+template <typename Op>
+void Binary(F &f, int64_t k) {
+  f.append<hop::Push<int64_t>>(k);
+  f.append<Op>();
+}
+
+void AddBuiltins(std::vector<Benchmark> &benchmarks) {
+  auto empty = [](F &) {};
+  benchmarks.push_back(Invocation("builtin/Return",
+                                  Unrolled<Instructions>(0, empty, empty), {},
+                                  /*operations=*/1));
+
+  AddUnrolled(benchmarks, "builtin/Jump", {}, [](F &f) {
+    auto jump = f.append_with_placeholders<hop::Jump>();
+    f.set_value(jump, 0, jump.upper_bound() - jump.lower_bound());
+  });
+  AddUnrolled(benchmarks, "builtin/Push+JumpIf/taken", {}, [](F &f) {
+    f.append<hop::Push<bool>>(true);
+    f.append<hop::JumpIf>(2);
+  });
+  AddUnrolled(benchmarks, "builtin/Push+JumpIf/not-taken", {}, [](F &f) {
+    f.append<hop::Push<bool>>(false);
+    f.append<hop::JumpIf>(2);
+  });
+
+  // Referenced by the bytecode of the benchmarks below, which may run for the
+  // remainder of the program.
+  static FunctionPtr<Instructions> const callee =
+      Unrolled<Instructions>(0, empty, empty);
+  AddUnrolled(benchmarks, "builtin/Push+Call+Return", {}, [](F &f) {
+    f.append<hop::Push<hop::Function<> *>>(callee.get());
+    f.append<hop::Call>(hop::InstructionSpecification{});
+  });
+  AddUnrolled(benchmarks, "builtin/CallDirect+Return", {}, [](F &f) {
+    f.append<hop::CallDirect>(hop::InstructionSpecification{}, callee.get());
+  });
+
+  // Each call site calls the deeper of the two functions passed as arguments.
+  // In the polymorphic benchmark, the prologue swaps the arguments, which are
+  // returned in their new order, so that every call site alternates between
+  // the two callees on successive invocations.
+  static FunctionPtr<Instructions> const other =
+      Unrolled<Instructions>(0, empty, empty);
+  std::vector<hop::Value> callees = {
+      static_cast<hop::Function<> *>(callee.get()),
+      static_cast<hop::Function<> *>(other.get()),
+  };
+  auto call_deeper = [](F &f) {
+    f.append<hop::DuplicateAt>(
+        hop::InstructionSpecification{.parameters = 2, .returns = 1});
+    f.append<hop::Call>(hop::InstructionSpecification{});
+  };
+  benchmarks.push_back(
+      Invocation("builtin/DuplicateAt+Call+Return/monomorphic",
+                 Unrolled<Instructions>(2, empty, call_deeper), callees));
+  benchmarks.push_back(Invocation(
+      "builtin/DuplicateAt+Call+Return/polymorphic",
+      Unrolled<Instructions>(
+          2, [](F &f) { f.append<hop::Swap>(); }, call_deeper),
+      callees));
+}
+
+void AddInstructions(std::vector<Benchmark> &benchmarks) {
+  hop::Value const x = int64_t{12345};
+  AddUnrolled(benchmarks, "arithmetic/Push+Add", {x},
+              [](F &f) { Binary<hop::Add<int64_t>>(f, 3); });
+  AddUnrolled(benchmarks, "arithmetic/Push+Subtract", {x},
+              [](F &f) { Binary<hop::Subtract<int64_t>>(f, 3); });
+  AddUnrolled(benchmarks, "arithmetic/Push+Multiply", {x},
+              [](F &f) { Binary<hop::Multiply<int64_t>>(f, 1); });
+  AddUnrolled(benchmarks, "arithmetic/Push+Divide", {x},
+              [](F &f) { Binary<hop::Divide<int64_t>>(f, 1); });
+  AddUnrolled(benchmarks, "arithmetic/Push+Mod", {x},
+              [](F &f) { Binary<hop::Mod<int64_t>>(f, 1'000'003); });
+  AddUnrolled(benchmarks, "arithmetic/Negate", {x},
+              [](F &f) { f.append<hop::Negate<int64_t>>(); });
+
+  AddUnrolled(benchmarks, "compare/Duplicate+Push+LessThan+Drop", {x},
+              [](F &f) {
+                f.append<hop::Duplicate>();
+                Binary<hop::LessThan<int64_t>>(f, 7);
+                f.append<hop::Drop>();
+              });
+  AddUnrolled(benchmarks, "compare/Duplicate+Push+Equal+Drop", {x}, [](F &f) {
+    f.append<hop::Duplicate>();
+    Binary<hop::Equal<int64_t>>(f, 7);
+    f.append<hop::Drop>();
+  });
+
+  AddUnrolled(benchmarks, "bool/Not", {true},
+              [](F &f) { f.append<hop::Not>(); });
+  AddUnrolled(benchmarks, "bool/Push+And", {true}, [](F &f) {
+    f.append<hop::Push<bool>>(true);
+    f.append<hop::And>();
+  });
+  AddUnrolled(benchmarks, "bool/Push+Or", {true}, [](F &f) {
+    f.append<hop::Push<bool>>(false);
+    f.append<hop::Or>();
+  });
+  AddUnrolled(benchmarks, "bool/Push+Xor", {true}, [](F &f) {
+    f.append<hop::Push<bool>>(false);
+    f.append<hop::Xor>();
+  });
+
+  AddUnrolled(benchmarks, "common/Push+Drop", {}, [](F &f) {
+    f.append<hop::Push<int64_t>>(1);
+    f.append<hop::Drop>();
+  });
+  AddUnrolled(benchmarks, "common/Duplicate+Drop", {x}, [](F &f) {
+    f.append<hop::Duplicate>();
+    f.append<hop::Drop>();
+  });
+  AddUnrolled(benchmarks, "common/Swap", {x, x},
+              [](F &f) { f.append<hop::Swap>(); });
+}
+
+// Instructions whose effect on the value stack is determined by their
+// immediate values rather than by their signature.
+void AddImmediateValueInstructions(std::vector<Benchmark> &benchmarks) {
+  std::vector<hop::Value> values = {int64_t{1}, int64_t{2}, int64_t{3},
+                                    int64_t{4}};
+  AddUnrolled(benchmarks, "immediate/Rotate", values, [](F &f) {
+    f.append<hop::Rotate>(
+        hop::InstructionSpecification{.parameters = 4, .returns = 0}, 1);
+  });
+  AddUnrolled(benchmarks, "immediate/DuplicateAt+Drop", values, [](F &f) {
+    f.append<hop::DuplicateAt>(
+        hop::InstructionSpecification{.parameters = 4, .returns = 1});
+    f.append<hop::Drop>();
+  });
+}
+
+void AddStatefulInstructions(std::vector<Benchmark> &benchmarks) {
+  using G = hop::Function<StatefulInstructions>;
+  benchmarks.push_back(Invocation(
+      "stateful/StackOffset+Drop",
+      Unrolled<StatefulInstructions>(
+          0, [](G &f) { f.append<hop::StackAllocate>(8); },
+          [](G &f) {
+            f.append<hop::StackOffset>(0);
+            f.append<hop::Drop>();
+          }),
+      {}));
+}
+
+FunctionPtr<Instructions> RecursiveFibonacci() {
+  auto f = std::make_shared<hop::Function<Instructions>>(1, 1);
+  f->append<hop::Duplicate>();
+  f->append<hop::Push<int64_t>>(2);
+  f->append<hop::LessThan<int64_t>>();
+  nth::interval<hop::InstructionIndex> jump =
+      f->append_with_placeholders<hop::JumpIf>();
+  f->append<hop::Duplicate>();
+  f->append<hop::Push<int64_t>>(1);
+  f->append<hop::Subtract<int64_t>>();
+  f->append<hop::Push<hop::Function<> *>>(f.get());
+  f->append<hop::Call>(
+      hop::InstructionSpecification{.parameters = 1, .returns = 1});
+  f->append<hop::Swap>();
+  f->append<hop::Push<int64_t>>(2);
+  f->append<hop::Subtract<int64_t>>();
+  f->append<hop::Push<hop::Function<> *>>(f.get());
+  f->append<hop::Call>(
+      hop::InstructionSpecification{.parameters = 1, .returns = 1});
+  f->append<hop::Add<int64_t>>();
+  nth::interval<hop::InstructionIndex> ret = f->append<hop::Return>();
+  f->set_value(jump, 0, ret.lower_bound() - jump.lower_bound());
+  return f;
+}
+
+FunctionPtr<Instructions> DynamicFibonacci() {
+  auto f = std::make_shared<hop::Function<Instructions>>(1, 1);
+  f->append<hop::Push<int64_t>>(1);
+  f->append<hop::Push<int64_t>>(0);
+  nth::interval<hop::InstructionIndex> loop_start =
+      f->append<hop::DuplicateAt>(
+          hop::InstructionSpecification{.parameters = 3, .returns = 1});
+  f->append<hop::Push<int64_t>>(0);
+  f->append<hop::Equal<int64_t>>();
+  nth::interval<hop::InstructionIndex> jump =
+      f->append_with_placeholders<hop::JumpIf>();
+  f->append<UpdateFibonacci>();
+  nth::interval<hop::InstructionIndex> loop_end =
+      f->append_with_placeholders<hop::Jump>();
+  // Leaves only the result on the stack.
+  nth::interval<hop::InstructionIndex> exit = f->append<hop::Swap>();
+  f->append<hop::Drop>();
+  f->append<hop::Swap>();
+  f->append<hop::Drop>();
+  f->append<hop::Return>();
+  f->set_value(loop_end, 0, loop_start.lower_bound() - loop_end.lower_bound());
+  f->set_value(jump, 0, exit.lower_bound() - jump.lower_bound());
+  return f;
+}
+
+void AddBuilds(std::vector<Benchmark> &benchmarks) {
+  constexpr uint64_t Count = 4096;
+  benchmarks.push_back({
+      .name       = "build/append",
+      .operations = Count,
+      .run =
+          [](uint64_t repetitions) {
+            for (uint64_t i = 0; i < repetitions; ++i) {
+              F f(1, 1);
+              for (uint64_t j = 0; j < Count; ++j) {
+                f.append<hop::Push<int64_t>>(j);
+                f.append<hop::Add<int64_t>>();
+              }
+              f.append<hop::Return>();
+            }
+          },
+  });
+  benchmarks.push_back({
+      .name       = "build/builder",
+      .operations = Count,
+      .run =
+          [](uint64_t repetitions) {
+            for (uint64_t i = 0; i < repetitions; ++i) {
+              hop::FunctionBuilder<Instructions> builder(1, 1, 3 * Count + 1);
+              for (uint64_t j = 0; j < Count; ++j) {
+                builder.append<hop::Push<int64_t>>(j);
+                builder.append<hop::Add<int64_t>>();
+              }
+              builder.append<hop::Return>();
+              F f = std::move(builder).finalize();
+            }
+          },
+  });
+}
+
+void AddPrograms(std::vector<Benchmark> &benchmarks,
+                 std::string_view mandelbrot) {
+  auto run_fibonacci = [](FunctionPtr<Instructions> f, int64_t n) {
+    return [f, n](uint64_t repetitions) {
+      for (uint64_t i = 0; i < repetitions; ++i) {
+        nth::stack<hop::Value> stack = {n};
+        f->invoke(stack);
+      }
+    };
+  };
+  benchmarks.push_back({
+      .name = "program/fibonacci/recursive",
+      .run  = run_fibonacci(RecursiveFibonacci(), 25),
+  });
+  benchmarks.push_back({
+      .name = "program/fibonacci/dynamic",
+      .run  = run_fibonacci(DynamicFibonacci(), 90),
+  });
+
+  std::string contents = bf::LoadFileContentsOrDie(mandelbrot);
+  benchmarks.push_back({
+      .name = "build/mandelbrot",
+      .run =
+          [contents](uint64_t repetitions) {
+            for (uint64_t i = 0; i < repetitions; ++i) {
+              auto fn_or_parse_error = bf::BuildHopFunction(contents);
+            }
+          },
+  });
+
+  std::variant fn_or_parse_error = bf::BuildHopFunction(contents);
+  if (auto *error = std::get_if<bf::parse_error>(&fn_or_parse_error)) {
+    std::fprintf(stderr, "Parse error on line %d (column %d).\n", error->line,
+                 error->column);
+    std::abort();
+  }
+  auto program = std::make_shared<hop::Function<bf::Instructions>>(
+      std::move(std::get<hop::Function<bf::Instructions>>(fn_or_parse_error)));
+
+  benchmarks.push_back({
+      .name = "program/mandelbrot/interpreter",
+      .run =
+          [program](uint64_t repetitions) {
+            for (uint64_t i = 0; i < repetitions; ++i) {
+              nth::stack<hop::Value> stack;
+              program->invoke(stack);
+            }
+          },
+  });
+
+  auto code = std::make_shared<hop::CompiledFunction>();
+  {
+    bf::X64CodeGenerator gen;
+    hop::x64::FunctionEmitter emitter(nth::type<bf::Instructions>, gen);
+    emitter.emit(hop::SsaFunction(*program), *code);
+  }
+  auto jitted = std::make_shared<nth::jit_function<void()>>(*code);
+  benchmarks.push_back({
+      .name = "program/mandelbrot/jit",
+      .run =
+          [code, jitted](uint64_t repetitions) {
+            for (uint64_t i = 0; i < repetitions; ++i) { (*jitted)(); }
+          },
+  });
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+  benchmarks::Options options = benchmarks::ParseOptions(argc, argv);
+  std::string_view mandelbrot = "examples/brainfuck/mandelbrot.bf";
+  for (std::string_view argument : options.unparsed) {
+    if (argument.starts_with("--mandelbrot=")) {
+      mandelbrot = argument.substr(13);
+    } else {
+      std::fprintf(stderr, "Unrecognized argument: %.*s\n",
+                   static_cast<int>(argument.size()), argument.data());
+      return 1;
+    }
+  }
+
+  std::vector<Benchmark> benchmarks;
+  AddBuiltins(benchmarks);
+  AddInstructions(benchmarks);
+  AddImmediateValueInstructions(benchmarks);
+  AddStatefulInstructions(benchmarks);
+  AddBuilds(benchmarks);
+  AddPrograms(benchmarks, mandelbrot);
+  return benchmarks::RunBenchmarks(benchmarks, options);
+}
@@ -0,0 +1,80 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmarks/harness.h"
+#include "hop/core/function.h"
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "hop/testing/fibonacci.h"
+#include "nth/container/stack.h"
+
+// This benchmark measures the cost of preparing the top-of-stack cache when
+// invoking a function. The recursive Fibonacci implementation from
+// "examples/fibonacci.cc" is invoked many times on a value stack which already
+// holds `depth` values beneath the argument, as it would when invoked from a
+// host holding intermediate results on the same stack. We compare placing a
+// placeholder beneath the entire stack on each invocation, which moves every
+// value on the stack, with reusing the values already beneath the argument.
+// Only the former depends on `depth`.
+//
+// Regardless of the `//hop/configuration:dispatch` flag, invocations are made
+// by tail-calls between instructions.
+//
+// Usage:
+//
+//     top_of_stack [--filter=<substring>] [--min_time_ms=<ms>] [--json=<path>]
+
+using Instructions =
+    hop::MakeInstructionSet<hop::Duplicate, hop::Swap, hop::Push<uint64_t>,
+                            hop::Push<hop::Function<>*>,
+                            hop::LessThan<uint64_t>, hop::Add<uint64_t>,
+                            hop::Subtract<uint64_t>>;
+
+using frame_type =
+    hop::internal::Frame<hop::internal::FunctionState<Instructions>>;
+
+constexpr uint64_t N = 10;
+
+// The stacks an invocation runs on, prepared once per benchmark so that only
+// the invocations themselves are measured.
+struct Stacks {
+  nth::stack<hop::Value> values;
+  nth::stack<frame_type> calls;
+};
+
+benchmarks::Benchmark Run(char const* name,
+                          hop::Function<Instructions> const& func,
+                          size_t depth, bool reserved) {
+  auto stacks = std::make_shared<Stacks>();
+  for (size_t i = 0; i < depth; ++i) { stacks->values.push(uint64_t{0}); }
+  return {
+      .name = std::string("top_of_stack/") + name +
+              "/depth:" + std::to_string(depth),
+      .run =
+          [&func, stacks, reserved](uint64_t repetitions) {
+            for (uint64_t i = 0; i < repetitions; ++i) {
+              stacks->values.push(N);
+              hop::internal::InvokeThreaded<Instructions>(
+                  stacks->values, stacks->calls, func.entry(), reserved);
+              stacks->values.pop();
+            }
+          },
+  };
+}
+
+int main(int argc, char const* argv[]) {
+  benchmarks::Options options = benchmarks::ParseOptions(argc, argv);
+  if (not benchmarks::NoUnparsedArguments(options)) { return 1; }
+
+  hop::Function<Instructions> func(1, 1);
+  hop::BuildFibonacci(func);
+
+  std::vector<benchmarks::Benchmark> benchmarks;
+  for (size_t depth : {1, 100, 10'000, 1'000'000}) {
+    benchmarks.push_back(Run("placeholder", func, depth, /*reserved=*/false));
+    benchmarks.push_back(Run("reserved", func, depth, /*reserved=*/true));
+  }
+  return benchmarks::RunBenchmarks(benchmarks, options);
+}
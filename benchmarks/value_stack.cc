@@ -0,0 +1,76 @@
+#include <vector>
+
+#include "benchmarks/harness.h"
+#include "hop/core/function.h"
+#include "hop/core/guarded_value_stack.h"
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "hop/testing/fibonacci.h"
+#include "nth/container/stack.h"
+
+// This benchmark compares the two value stack backends on the recursive
+// Fibonacci implementation from "examples/fibonacci.cc". An `nth::stack<Value>`
+// starts small and is reallocated as instructions discover it is full, whereas
+// a `hop::GuardedValueStack` reserves its entire capacity up front and is never
+// reallocated. We also report a third configuration in which the
+// `nth::stack<Value>` is reserved ahead of time, isolating the cost of growth
+// from the cost of checking whether growth is necessary.
+//
+// Usage:
+//
+//     value_stack [--filter=<substring>] [--min_time_ms=<ms>] [--json=<path>]
+
+using Instructions =
+    hop::MakeInstructionSet<hop::Duplicate, hop::Swap, hop::Push<uint64_t>,
+                            hop::Push<hop::Function<>*>,
+                            hop::LessThan<uint64_t>, hop::Add<uint64_t>,
+                            hop::Subtract<uint64_t>>;
+
+constexpr uint64_t N = 25;
+
+int main(int argc, char const* argv[]) {
+  benchmarks::Options options = benchmarks::ParseOptions(argc, argv);
+  if (not benchmarks::NoUnparsedArguments(options)) { return 1; }
+
+  hop::Function<Instructions> func(1, 1);
+  hop::BuildFibonacci(func);
+  hop::GuardedValueStack guarded;
+
+  std::vector<benchmarks::Benchmark> benchmarks = {
+      {
+          .name = "value_stack/nth::stack",
+          .run =
+              [&](uint64_t repetitions) {
+                for (uint64_t i = 0; i < repetitions; ++i) {
+                  nth::stack<hop::Value> stack = {N};
+                  func.invoke(stack);
+                }
+              },
+      },
+      {
+          .name = "value_stack/nth::stack+reserve",
+          .run =
+              [&](uint64_t repetitions) {
+                for (uint64_t i = 0; i < repetitions; ++i) {
+                  nth::stack<hop::Value> stack;
+                  stack.reserve(1 << 16);
+                  stack.push(N);
+                  func.invoke(stack);
+                }
+              },
+      },
+      {
+          .name = "value_stack/guarded",
+          .run =
+              [&](uint64_t repetitions) {
+                for (uint64_t i = 0; i < repetitions; ++i) {
+                  guarded.push(N);
+                  func.invoke(guarded);
+                  guarded.pop();
+                }
+              },
+      },
+  };
+  return benchmarks::RunBenchmarks(benchmarks, options);
+}
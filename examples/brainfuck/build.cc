@@ -1,13 +1,23 @@
 #include "examples/brainfuck/build.h"
+
+#include <utility>
+
 #include "examples/brainfuck/instructions.h"
+#include "hop/core/function_builder.h"
 
 namespace bf {
 
 std::variant<hop::Function<Instructions>, parse_error> BuildHopFunction(
     std::string_view contents) {
-  hop::Function<Instructions> f(0, 0);
+  // Each character is encoded in at most three values: a bracket's `Zero` and
+  // its jump.
+  hop::FunctionBuilder<Instructions> f(0, 0, 3 * contents.size() + 2);
   f.append<Initialize>();
-  std::vector<nth::interval<hop::InstructionIndex>> open_brackets;
+  struct Loop {
+    hop::FunctionBuilder<Instructions>::Label body;
+    hop::FunctionBuilder<Instructions>::Label exit;
+  };
+  std::vector<Loop> open_brackets;
   int line   = 1;
   int column = 0;
   for (char c : contents) {
@@ -17,19 +27,21 @@ std::variant<hop::Function<Instructions>, parse_error> BuildHopFunction(
       case '<': f.append<Left>(); break;
       case '>': f.append<Right>(); break;
       case '[': {
+        Loop loop{.body = f.label(), .exit = f.label()};
         f.append<Zero>();
-        open_brackets.push_back(f.append_with_placeholders<hop::JumpIf>());
+        f.append<hop::JumpIf>(loop.exit);
+        f.bind(loop.body);
+        open_brackets.push_back(loop);
       } break;
       case ']': {
         if (open_brackets.empty()) {
           return parse_error{.line = line, .column = column};
         }
-        f.append<Zero>();
-        auto loc = open_brackets.back();
+        Loop loop = open_brackets.back();
         open_brackets.pop_back();
-        auto land = f.append_with_placeholders<hop::JumpIfNot>();
-        f.set_value(loc, 0, land.lower_bound() - loc.lower_bound() + 2);
-        f.set_value(land, 0, loc.lower_bound() - land.lower_bound() + 2);
+        f.append<Zero>();
+        f.append<hop::JumpIfNot>(loop.body);
+        f.bind(loop.exit);
       } break;
       case ',': f.append<Input>(); break;
       case '.': f.append<Output>(); break;
@@ -47,7 +59,7 @@ std::variant<hop::Function<Instructions>, parse_error> BuildHopFunction(
   }
 
   f.append<hop::Return>();
-  return f;
+  return std::move(f).finalize();
 }
 
 }  // namespace bf
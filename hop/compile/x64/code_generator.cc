@@ -20,6 +20,15 @@ void CodeGenerator::mov(Register destination, Register source) {
                               8 * static_cast<uint8_t>(source))});
 }
 
+void CodeGenerator::write_imm64(uint64_t n) {
+  write({
+      static_cast<uint8_t>(n),       static_cast<uint8_t>(n >> 8),
+      static_cast<uint8_t>(n >> 16), static_cast<uint8_t>(n >> 24),
+      static_cast<uint8_t>(n >> 32), static_cast<uint8_t>(n >> 40),
+      static_cast<uint8_t>(n >> 48), static_cast<uint8_t>(n >> 56),
+  });
+}
+
 void CodeGenerator::syscall() { write({0x0f, 0x05}); }
 
 void CodeGenerator::ret() { write({0xc3}); }
@@ -59,6 +68,39 @@ void CodeGenerator::function(SsaFunction const &fn, CompiledFunction &c) {
       case SsaBranchKind::Unconditional: {
         NTH_UNIMPLEMENTED();
       } break;
+      case SsaBranchKind::Switch: {
+        auto const &s = block.branch().AsSwitch();
+        // As with `Conditional`, the key is expected in rax, where the
+        // instruction producing it leaves its result. rcx is used as a scratch
+        // register, so neither may hold a value live into any successor.
+        write({0x48, 0xb9});  // movabs rcx, minimum
+        write_imm64(s.minimum);
+        write({0x48, 0x29, 0xc8});  // sub rax, rcx
+        write({0x48, 0xb9});        // movabs rcx, count
+        write_imm64(s.blocks.size() - 1);
+        write({
+            0x48, 0x39, 0xc8,                    // cmp rax, rcx
+            0x0f, 0x83, 0x00, 0x00, 0x00, 0x00,  // jae __
+        });
+        block_jumps_.emplace(fn_->size(), s.blocks.back());
+        // The table of 32-bit offsets from its own start to each block
+        // immediately follows the indirect jump.
+        write({
+            0x48, 0x8d, 0x0d, 0x09, 0x00, 0x00, 0x00,  // lea rcx, [rip + 9]
+            0x48, 0x63, 0x04, 0x81,  // movsxd rax, dword ptr [rcx + 4 * rax]
+            0x48, 0x01, 0xc8,        // add rax, rcx
+            0xff, 0xe0,              // jmp rax
+        });
+        size_t table = fn_->size();
+        for (size_t i = 0; i + 1 < s.blocks.size(); ++i) {
+          table_entries_.push_back({
+              .offset = fn_->size(),
+              .table  = table,
+              .block  = s.blocks[i],
+          });
+          write({0x00, 0x00, 0x00, 0x00});
+        }
+      } break;
       case SsaBranchKind::Unreachable: break;
     }
   }
@@ -67,6 +109,10 @@ void CodeGenerator::function(SsaFunction const &fn, CompiledFunction &c) {
     fn_->write_at(offset - 4,
                   static_cast<uint32_t>(block_starts_[block_number] - offset));
   }
+  for (auto const &[offset, table, block_number] : table_entries_) {
+    fn_->write_at(offset,
+                  static_cast<uint32_t>(block_starts_[block_number] - table));
+  }
 
   fn_ = nullptr;
 }
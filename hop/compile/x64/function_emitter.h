@@ -50,9 +50,20 @@ struct FunctionEmitter {
   static auto Generate(nth::Type auto t)
       -> void (*)(void *, FunctionEmitter &, LocationMap const &);
 
+  void write_imm64(uint64_t n);
+
+  // An entry of a jump table emitted for a `Switch` branch, which is to hold
+  // the offset of the start of `block` from the start of the table.
+  struct TableEntry {
+    size_t offset;
+    size_t table;
+    size_t block;
+  };
+
   CompiledFunction *fn_ = nullptr;
   std::vector<size_t> block_starts_;
   absl::flat_hash_map<size_t, size_t> block_jumps_;
+  std::vector<TableEntry> table_entries_;
   InstructionSetMetadata const &metadata_;
   void *generator_;
   std::vector<void (*)(void *, FunctionEmitter &, LocationMap const &)>
@@ -66,14 +77,24 @@ auto FunctionEmitter::Generate(nth::Type auto t)
     -> void (*)(void *, FunctionEmitter &, LocationMap const &) {
   if constexpr (t == nth::type<Call>) {
     return nullptr;
+  } else if constexpr (t == nth::type<CallDirect>) {
+    return nullptr;
   } else if constexpr (t == nth::type<Jump>) {
     return nullptr;
   } else if constexpr (t == nth::type<JumpIf>) {
     return nullptr;
   } else if constexpr (t == nth::type<JumpIfNot>) {
     return nullptr;
+  } else if constexpr (t == nth::type<Switch>) {
+    return nullptr;
   } else if constexpr (t == nth::type<Return>) {
     return nullptr;
+  } else if constexpr (t == nth::type<TailCall>) {
+    return nullptr;
+  } else if constexpr (t == nth::type<Yield>) {
+    return nullptr;
+  } else if constexpr (internal::FusedInstruction<nth::type_t<t>>()) {
+    return nullptr;
   } else {
     return +[](void *gen, FunctionEmitter &cg, LocationMap const &map) {
       (*reinterpret_cast<Generator *>(gen))(decltype(t){}, cg, map);
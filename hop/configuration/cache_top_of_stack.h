@@ -0,0 +1 @@
+#define JASMIN_INTERNAL_CONFIGURATION_CACHE_TOP_OF_STACK
@@ -0,0 +1 @@
+#define JASMIN_INTERNAL_CONFIGURATION_COMPUTED_GOTO
@@ -13,10 +13,34 @@
 #include "hop/configuration/harden.h"
 #endif
 
+#if __has_include("hop/configuration/profile.h")
+#include "hop/configuration/profile.h"
+#endif
+
 #if __has_include("hop/configuration/optimize.h")
 #include "hop/configuration/optimize.h"
 #endif
 
+#if __has_include("hop/configuration/cache_top_of_stack.h")
+#include "hop/configuration/cache_top_of_stack.h"
+#endif
+
+#if __has_include("hop/configuration/meter_fuel.h")
+#include "hop/configuration/meter_fuel.h"
+#endif
+
+#if __has_include("hop/configuration/computed_goto.h")
+#include "hop/configuration/computed_goto.h"
+#endif
+
+#if __has_include("hop/configuration/sampling.h")
+#include "hop/configuration/sampling.h"
+#endif
+
+#if __has_include("hop/configuration/measure_latency.h")
+#include "hop/configuration/measure_latency.h"
+#endif
+
 namespace hop::internal {
 
 #if defined(JASMIN_INTERNAL_CONFIGURATION_DEBUG)
@@ -31,6 +55,56 @@ inline constexpr bool harden = true;
 inline constexpr bool harden = false;
 #endif  // defined(JASMIN_INTERNAL_CONFIGURATION_HARDEN)
 
+// When enabled, each instruction increments a counter of its executions (see
+// "hop/core/execution_counts.h").
+#if defined(JASMIN_INTERNAL_CONFIGURATION_PROFILE)
+inline constexpr bool profile = true;
+#else   // defined(JASMIN_INTERNAL_CONFIGURATION_PROFILE)
+inline constexpr bool profile = false;
+#endif  // defined(JASMIN_INTERNAL_CONFIGURATION_PROFILE)
+
+// When enabled, the interpreter holds the value on top of the value stack in a
+// parameter of each instruction's execution function, rather than in memory.
+#if defined(JASMIN_INTERNAL_CONFIGURATION_CACHE_TOP_OF_STACK)
+inline constexpr bool cache_top_of_stack = true;
+#else   // defined(JASMIN_INTERNAL_CONFIGURATION_CACHE_TOP_OF_STACK)
+inline constexpr bool cache_top_of_stack = false;
+#endif  // defined(JASMIN_INTERNAL_CONFIGURATION_CACHE_TOP_OF_STACK)
+
+// When enabled, backward jumps and calls executed by resumable executions
+// consume fuel, and executions are suspended when their fuel is exhausted.
+#if defined(JASMIN_INTERNAL_CONFIGURATION_METER_FUEL)
+inline constexpr bool meter_fuel = true;
+#else   // defined(JASMIN_INTERNAL_CONFIGURATION_METER_FUEL)
+inline constexpr bool meter_fuel = false;
+#endif  // defined(JASMIN_INTERNAL_CONFIGURATION_METER_FUEL)
+
+// When enabled, functions are invoked by a loop dispatching between
+// instructions with computed gotos rather than by tail-calls between
+// instructions (see "hop/core/internal/dispatch_loop.h").
+#if defined(JASMIN_INTERNAL_CONFIGURATION_COMPUTED_GOTO)
+inline constexpr bool computed_goto = true;
+#else   // defined(JASMIN_INTERNAL_CONFIGURATION_COMPUTED_GOTO)
+inline constexpr bool computed_goto = false;
+#endif  // defined(JASMIN_INTERNAL_CONFIGURATION_COMPUTED_GOTO)
+
+// When enabled, executing functions publish the instruction being executed and
+// the extent of their call stack for the sampling profiler (see
+// "hop/core/sampling_profiler.h").
+#if defined(JASMIN_INTERNAL_CONFIGURATION_SAMPLING)
+inline constexpr bool sampling = true;
+#else   // defined(JASMIN_INTERNAL_CONFIGURATION_SAMPLING)
+inline constexpr bool sampling = false;
+#endif  // defined(JASMIN_INTERNAL_CONFIGURATION_SAMPLING)
+
+// When enabled, each call records the time spent in its callee in a latency
+// histogram (see "hop/core/latency_histogram.h").
+#if defined(JASMIN_INTERNAL_CONFIGURATION_MEASURE_LATENCY)
+inline constexpr bool measure_latency = true;
+#else   // defined(JASMIN_INTERNAL_CONFIGURATION_MEASURE_LATENCY)
+inline constexpr bool measure_latency = false;
+#endif  // defined(JASMIN_INTERNAL_CONFIGURATION_MEASURE_LATENCY)
+
 }  // namespace hop::internal
 
 #endif  // JASMIN_CONFIGURATION_CONFIGURATION_H
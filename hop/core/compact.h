@@ -0,0 +1,489 @@
+#ifndef JASMIN_CORE_COMPACT_H
+#define JASMIN_CORE_COMPACT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "hop/core/function.h"
+#include "hop/core/instruction.h"
+#include "hop/core/internal/frame.h"
+#include "hop/core/internal/function_base.h"
+#include "hop/core/internal/instruction_traits.h"
+#include "hop/core/metadata.h"
+#include "hop/core/value.h"
+#include "nth/base/attributes.h"
+#include "nth/base/indestructible.h"
+#include "nth/container/stack.h"
+#include "nth/debug/debug.h"
+
+namespace hop {
+
+// Encodes the instructions of `f` compactly and arranges for subsequent calls
+// to `f.invoke` to execute the compact encoding. In the compact encoding each
+// op-code occupies 32 bits, each immediate value occupies only as many bytes
+// as its type requires, and jump offsets occupy 32 bits. The original encoding
+// is left intact so that `f` may still be inspected, serialized, or converted
+// to SSA form. Any modification of `f` discards its compact encoding, after
+// which `f` must be compacted again to benefit from it.
+//
+// Fused superinstructions and `Yield` have no compact encoding, so functions
+// containing them are left unchanged. Returns whether `f` was compacted.
+// Compacted functions may call functions which have not been compacted, though
+// each such call executes the callee as a separate invocation of its original
+// encoding, and so is considerably slower.
+template <InstructionSetType Set>
+bool Compact(Function<Set> &f);
+
+namespace internal {
+
+using compact_exec_fn_type = void (*)(Value *, size_t, std::byte const *,
+                                      FrameBase *, uint64_t);
+
+// Compact op-codes are offsets from the address of this function, which is
+// never called.
+inline void CompactAnchor(Value *, size_t, std::byte const *, FrameBase *,
+                          uint64_t) {}
+
+template <typename T>
+T CompactLoad(std::byte const *p) {
+  T t;
+  std::memcpy(&t, p, sizeof(T));
+  return t;
+}
+
+template <typename T>
+void CompactStore(std::byte *&p, T const &t) {
+  std::memcpy(p, &t, sizeof(T));
+  p += sizeof(T);
+}
+
+inline compact_exec_fn_type CompactHandler(std::byte const *ip) {
+  return reinterpret_cast<compact_exec_fn_type>(
+      reinterpret_cast<intptr_t>(&CompactAnchor) + CompactLoad<int32_t>(ip));
+}
+
+inline int32_t CompactOpCode(compact_exec_fn_type handler) {
+  intptr_t offset = reinterpret_cast<intptr_t>(handler) -
+                    reinterpret_cast<intptr_t>(&CompactAnchor);
+  NTH_REQUIRE((harden), offset >= std::numeric_limits<int32_t>::min());
+  NTH_REQUIRE((harden), offset <= std::numeric_limits<int32_t>::max());
+  return static_cast<int32_t>(offset);
+}
+
+// Returns the number of bytes occupied by the instruction `I`, including its
+// op-code, in the compact encoding.
+template <typename I>
+constexpr size_t CompactSize() {
+  if constexpr (nth::any_of<I, Call, Return, TailCall>) {
+    return sizeof(int32_t);
+  } else if constexpr (nth::type<I> == nth::type<CallDirect>) {
+    return sizeof(int32_t) + sizeof(FunctionBase const *);
+  } else if constexpr (nth::any_of<I, Jump, JumpIf, JumpIfNot>) {
+    return 2 * sizeof(int32_t);
+  } else if constexpr (nth::type<I> == nth::type<Switch>) {
+    return sizeof(int32_t) + sizeof(uint64_t) + sizeof(size_t);
+  } else if constexpr (::hop::ImmediateValueDetermined<I>()) {
+    return sizeof(int32_t) + sizeof(InstructionSpecification) +
+           PackedImmediateValueBytes<I>();
+  } else {
+    return sizeof(int32_t) + PackedImmediateValueBytes<I>();
+  }
+}
+
+template <typename T>
+void CompactDecodeOne(std::byte const *&p, Value *&out) {
+  using type = std::remove_cvref_t<T>;
+  *out++     = CompactLoad<type>(p);
+  p += sizeof(type);
+}
+
+template <typename T>
+void CompactEncodeOne(Value const *&in, std::byte *&p) {
+  CompactStore(p, (in++)->as<std::remove_cvref_t<T>>());
+}
+
+// Unpacks the immediate values of `I` (other than any
+// `InstructionSpecification`) starting at `p` into `out`.
+template <typename I>
+void CompactDecode(std::byte const *p, Value *out) {
+  ImmediateValueTypes<I>().reduce([&](auto... ts) {
+    (CompactDecodeOne<nth::type_t<ts>>(p, out), ...);
+    return 0;
+  });
+}
+
+// Packs the immediate values of `I` (other than any `InstructionSpecification`)
+// starting at `in` into `p`.
+template <typename I>
+void CompactEncode(Value const *in, std::byte *p) {
+  ImmediateValueTypes<I>().reduce([&](auto... ts) {
+    (CompactEncodeOne<nth::type_t<ts>>(in, p), ...);
+    return 0;
+  });
+}
+
+inline void CompactReallocateValueStack(Value *value_stack_head,
+                                        size_t capacity_left,
+                                        std::byte const *ip,
+                                        FrameBase *call_stack,
+                                        uint64_t cap_and_left) {
+  {
+    // Scope is necessary to ensure destruction of `v` occurs before the
+    // tail-call, even though the destruction will be a no-op due to the
+    // move+release.
+    auto v =
+        nth::stack<Value>::reconstitute_from(value_stack_head, capacity_left);
+    v.reserve(v.capacity() * 2);
+    std::tie(value_stack_head, capacity_left) = std::move(v).release();
+  }
+
+  NTH_ATTRIBUTE(tailcall)
+  return CompactHandler(ip)(value_stack_head, capacity_left, ip, call_stack,
+                            cap_and_left);
+}
+
+// Executes `f`, which has no compact encoding, by invoking its original
+// encoding on the value stack whose head is `value_stack_head` with `vs_left`
+// values of capacity remaining, updating both accordingly.
+inline void CompactInvokeWide(FunctionBase const *f, Value *&value_stack_head,
+                              size_t &vs_left) {
+  CallLatency latency;
+  EnterCall(latency, f);
+  {
+    auto v = nth::stack<Value>::reconstitute_from(value_stack_head, vs_left);
+    f->invoke(v);
+    std::tie(value_stack_head, vs_left) = std::move(v).release();
+  }
+  ExitCall(latency);
+}
+
+template <typename FrameType>
+inline void CompactReallocateCallStack(Value *value_stack_head,
+                                       size_t capacity_left,
+                                       std::byte const *ip, FrameBase *cs_head,
+                                       uint64_t cs_left) {
+  {
+    // Scope is necessary to ensure destruction of `c` occurs before the
+    // tail-call, even though the destruction will be a no-op due to the
+    // move+release.
+    auto c = nth::stack<FrameType>::reconstitute_from(
+        static_cast<FrameType *>(cs_head), cs_left);
+    c.reserve(c.size() * 2);
+    std::tie(cs_head, cs_left) = std::move(c).release();
+  }
+
+  NTH_ATTRIBUTE(tailcall)
+  return CompactHandler(ip)(value_stack_head, capacity_left, ip, cs_head,
+                            cs_left);
+}
+
+// The compact counterpart to `Instruction<Inst>::ExecuteImpl<Set>`. Immediate
+// values are unpacked into `Value`s so that instruction bodies are shared with
+// the wide encoding. Frames on the call stack store the address of the
+// instruction to which `Return` resumes, rather than that of the `Call`.
+template <typename Inst, typename Set>
+void CompactExecute(Value *value_stack_head, size_t vs_left,
+                    std::byte const *ip, FrameBase *call_stack,
+                    uint64_t cs_left) {
+  using frame_type = Frame<FunctionState<Set>>;
+  CountExecution<Inst, Set>();
+  if constexpr (nth::type<Inst> == nth::type<Call>) {
+    if (cs_left == 0) [[unlikely]] {
+      NTH_ATTRIBUTE(tailcall)
+      return CompactReallocateCallStack<frame_type>(value_stack_head, vs_left,
+                                                    ip, call_stack, cs_left);
+    } else {
+      --value_stack_head;
+      ++vs_left;
+      auto const *f = value_stack_head->as<FunctionBase const *>();
+      if (f->compact_entry() == nullptr) [[unlikely]] {
+        CompactInvokeWide(f, value_stack_head, vs_left);
+        ip += CompactSize<Call>();
+        NTH_ATTRIBUTE(tailcall)
+        return CompactHandler(ip)(value_stack_head, vs_left, ip, call_stack,
+                                  cs_left);
+      }
+      auto *p    = new (static_cast<frame_type *>(call_stack)) frame_type;
+      p->ip      = reinterpret_cast<Value const *>(ip + CompactSize<Call>());
+      call_stack = p + 1;
+      ip         = f->compact_entry();
+      EnterCall(p->latency, f);
+      NTH_ATTRIBUTE(tailcall)
+      return CompactHandler(ip)(value_stack_head, vs_left, ip, call_stack,
+                                cs_left - 1);
+    }
+  } else if constexpr (nth::type<Inst> == nth::type<CallDirect>) {
+    if (cs_left == 0) [[unlikely]] {
+      NTH_ATTRIBUTE(tailcall)
+      return CompactReallocateCallStack<frame_type>(value_stack_head, vs_left,
+                                                    ip, call_stack, cs_left);
+    } else {
+      auto const *f = CompactLoad<FunctionBase const *>(ip + sizeof(int32_t));
+      if (f->compact_entry() == nullptr) [[unlikely]] {
+        CompactInvokeWide(f, value_stack_head, vs_left);
+        ip += CompactSize<CallDirect>();
+        NTH_ATTRIBUTE(tailcall)
+        return CompactHandler(ip)(value_stack_head, vs_left, ip, call_stack,
+                                  cs_left);
+      }
+      auto *p = new (static_cast<frame_type *>(call_stack)) frame_type;
+      p->ip = reinterpret_cast<Value const *>(ip + CompactSize<CallDirect>());
+      call_stack = p + 1;
+      ip         = f->compact_entry();
+      EnterCall(p->latency, f);
+      NTH_ATTRIBUTE(tailcall)
+      return CompactHandler(ip)(value_stack_head, vs_left, ip, call_stack,
+                                cs_left - 1);
+    }
+  } else if constexpr (nth::type<Inst> == nth::type<TailCall>) {
+    --value_stack_head;
+    ++vs_left;
+    auto const *f = value_stack_head->as<FunctionBase const *>();
+    if (f->compact_entry() == nullptr) [[unlikely]] {
+      // The callee's results are those of the current function, which returns
+      // as soon as the callee has been executed.
+      CompactInvokeWide(f, value_stack_head, vs_left);
+      NTH_ATTRIBUTE(tailcall)
+      return CompactExecute<Return, Set>(value_stack_head, vs_left, ip,
+                                         call_stack, cs_left);
+    }
+    auto *frame = static_cast<frame_type *>(call_stack) - 1;
+    ExitCall(frame->latency);
+    ResetState(*frame);
+    EnterCall(frame->latency, f);
+    ip = f->compact_entry();
+    NTH_ATTRIBUTE(tailcall)
+    return CompactHandler(ip)(value_stack_head, vs_left, ip, call_stack,
+                              cs_left);
+  } else if constexpr (nth::type<Inst> == nth::type<Jump>) {
+    ip += CompactLoad<int32_t>(ip + sizeof(int32_t));
+    NTH_ATTRIBUTE(tailcall)
+    return CompactHandler(ip)(value_stack_head, vs_left, ip, call_stack,
+                              cs_left);
+  } else if constexpr (nth::any_of<Inst, JumpIf, JumpIfNot>) {
+    constexpr bool JumpWhen = (nth::type<Inst> == nth::type<JumpIf>);
+    --value_stack_head;
+    if (value_stack_head->as<bool>() == JumpWhen) {
+      ip += CompactLoad<int32_t>(ip + sizeof(int32_t));
+    } else {
+      ip += CompactSize<Inst>();
+    }
+    NTH_ATTRIBUTE(tailcall)
+    return CompactHandler(ip)(value_stack_head, vs_left + 1, ip, call_stack,
+                              cs_left);
+  } else if constexpr (nth::type<Inst> == nth::type<Switch>) {
+    --value_stack_head;
+    uint64_t index = value_stack_head->raw_value() -
+                     CompactLoad<uint64_t>(ip + sizeof(int32_t));
+    size_t count =
+        CompactLoad<size_t>(ip + sizeof(int32_t) + sizeof(uint64_t));
+    if (index > count) { index = count; }
+    // Each entry of the jump table is a compactly encoded `Jump`.
+    std::byte const *entry =
+        ip + CompactSize<Switch>() + index * CompactSize<Jump>();
+    ip = entry + CompactLoad<int32_t>(entry + sizeof(int32_t));
+    NTH_ATTRIBUTE(tailcall)
+    return CompactHandler(ip)(value_stack_head, vs_left + 1, ip, call_stack,
+                              cs_left);
+  } else if constexpr (nth::type<Inst> == nth::type<Return>) {
+    auto *frame = static_cast<frame_type *>(call_stack) - 1;
+    ip          = reinterpret_cast<std::byte const *>(frame->ip);
+    ExitCall(frame->latency);
+    frame->~frame_type();
+    NTH_ATTRIBUTE(tailcall)
+    return CompactHandler(ip)(value_stack_head, vs_left, ip, frame,
+                              cs_left + 1);
+  } else if constexpr (::hop::ImmediateValueDetermined<Inst>()) {
+    auto spec = CompactLoad<InstructionSpecification>(ip + sizeof(int32_t));
+    if (vs_left < spec.returns) [[unlikely]] {
+      NTH_ATTRIBUTE(tailcall)
+      return CompactReallocateValueStack(value_stack_head, vs_left, ip,
+                                         call_stack, cs_left);
+    }
+    Value immediates[::hop::ImmediateValueCount<Inst>()];
+    immediates[0] = spec;
+    CompactDecode<Inst>(
+        ip + sizeof(int32_t) + sizeof(InstructionSpecification),
+        immediates + 1);
+    value_stack_head = ExecuteDeterminedBody<Inst, Set>(
+        value_stack_head, immediates, call_stack);
+    if constexpr (::hop::ConsumesInput<Inst>()) { vs_left += spec.parameters; }
+    vs_left -= spec.returns;
+    ip += CompactSize<Inst>();
+    NTH_ATTRIBUTE(tailcall)
+    return CompactHandler(ip)(value_stack_head, vs_left, ip, call_stack,
+                              cs_left);
+  } else {
+    constexpr size_t InputCount  = ::hop::ParameterCount<Inst>();
+    constexpr size_t OutputCount = ::hop::ReturnCount<Inst>();
+    if (vs_left < OutputCount) [[unlikely]] {
+      NTH_ATTRIBUTE(tailcall)
+      return CompactReallocateValueStack(value_stack_head, vs_left, ip,
+                                         call_stack, cs_left);
+    }
+    Value immediates[::hop::ImmediateValueCount<Inst>() + 1];
+    CompactDecode<Inst>(ip + sizeof(int32_t), immediates);
+    value_stack_head =
+        ExecuteBody<Inst, Set>(value_stack_head, immediates, call_stack);
+    if constexpr (::hop::ConsumesInput<Inst>()) { vs_left += InputCount; }
+    vs_left -= OutputCount;
+    ip += CompactSize<Inst>();
+    NTH_ATTRIBUTE(tailcall)
+    return CompactHandler(ip)(value_stack_head, vs_left, ip, call_stack,
+                              cs_left);
+  }
+}
+
+template <typename StateType>
+void CompactFinishExecution(Value *value_stack_head, size_t vs_left,
+                            std::byte const *ip, FrameBase *call_stack,
+                            uint64_t cs_remaining) {
+  ip += sizeof(int32_t);
+  *CompactLoad<Value **>(ip)                    = value_stack_head;
+  *CompactLoad<size_t *>(ip + sizeof(Value **)) = vs_left;
+  nth::stack<Frame<StateType>>::reconstitute_from(
+      static_cast<Frame<StateType> *>(call_stack), cs_remaining);
+}
+
+template <typename Set>
+void InvokeCompact(nth::stack<Value> &value_stack, std::byte const *ip) {
+  using frame_type = Frame<FunctionState<Set>>;
+  nth::stack<frame_type> call_stack;
+  call_stack.emplace();
+
+  auto [top, remaining] = std::move(value_stack).release();
+  std::byte landing_pad[sizeof(int32_t) + sizeof(Value **) + sizeof(size_t *)];
+  std::byte *p = landing_pad;
+  CompactStore(p, CompactOpCode(&CompactFinishExecution<FunctionState<Set>>));
+  CompactStore(p, &top);
+  CompactStore(p, &remaining);
+  call_stack.top().ip = reinterpret_cast<Value const *>(landing_pad);
+
+  auto [cs_top, cs_remaining] = std::move(call_stack).release();
+  CompactHandler(ip)(top, remaining, ip, cs_top, cs_remaining);
+  value_stack = nth::stack<Value>::reconstitute_from(top, remaining);
+}
+
+// Describes how a single instruction is translated to the compact encoding.
+struct CompactEncoding {
+  compact_exec_fn_type handler;
+  size_t size;
+  bool jumps;
+  bool determined;
+  void (*encode)(Value const *, std::byte *);
+};
+
+template <typename I, typename Set>
+constexpr CompactEncoding CompactEncodingFor() {
+  if constexpr (FusedInstruction<I>() or nth::type<I> == nth::type<Yield>) {
+    return {.handler = nullptr};
+  } else if constexpr (nth::type<I> == nth::type<CallDirect>) {
+    // The `InstructionSpecification` is not needed for execution, so only the
+    // callee is encoded.
+    return {
+        .handler    = &CompactExecute<I, Set>,
+        .size       = CompactSize<I>(),
+        .jumps      = false,
+        .determined = false,
+        .encode     = [](Value const *in, std::byte *p) {
+          CompactStore(p, in[1].as<FunctionBase const *>());
+        },
+    };
+  } else if constexpr (nth::type<I> == nth::type<Switch>) {
+    return {
+        .handler    = &CompactExecute<I, Set>,
+        .size       = CompactSize<I>(),
+        .jumps      = false,
+        .determined = false,
+        .encode     = [](Value const *in, std::byte *p) {
+          CompactStore(p, in[0].as<uint64_t>());
+          CompactStore(p, in[1].as<size_t>());
+        },
+    };
+  } else if constexpr (BuiltinInstruction<I>()) {
+    return {
+        .handler    = &CompactExecute<I, Set>,
+        .size       = CompactSize<I>(),
+        .jumps      = nth::any_of<I, Jump, JumpIf, JumpIfNot>,
+        .determined = false,
+        .encode     = nullptr,
+    };
+  } else {
+    return {
+        .handler    = &CompactExecute<I, Set>,
+        .size       = CompactSize<I>(),
+        .jumps      = false,
+        .determined = ::hop::ImmediateValueDetermined<I>(),
+        .encode     = &CompactEncode<I>,
+    };
+  }
+}
+
+// Returns the compact encoding of each instruction in `Set`, indexed by the
+// op-codes given by `Metadata<Set>()`.
+template <InstructionSetType Set>
+std::vector<CompactEncoding> const &CompactEncodings() {
+  static nth::indestructible<std::vector<CompactEncoding>> encodings =
+      Set::instructions.reduce([](auto... ts) {
+        return std::vector<CompactEncoding>{
+            CompactEncodingFor<nth::type_t<ts>, Set>()...};
+      });
+  return encodings;
+}
+
+}  // namespace internal
+
+template <InstructionSetType Set>
+bool Compact(Function<Set> &f) {
+  auto const &metadata  = Metadata<Set>();
+  auto const &encodings = internal::CompactEncodings<Set>();
+  std::span insts        = f.raw_instructions();
+
+  // Determine the byte offset of each instruction so that jumps may be
+  // relocated.
+  std::vector<size_t> byte_offsets(insts.size() + 1);
+  size_t size = 0;
+  for (size_t i = 0; i < insts.size();) {
+    uint16_t op_code = metadata.opcode(insts[i]);
+    // Fused instructions and `Yield` have no compact encoding.
+    if (encodings[op_code].handler == nullptr) { return false; }
+    byte_offsets[i] = size;
+    size += encodings[op_code].size;
+    i += 1 + metadata.metadata(op_code).immediate_value_count;
+  }
+  byte_offsets.back() = size;
+
+  std::vector<std::byte> bytes(size);
+  for (size_t i = 0; i < insts.size();) {
+    uint16_t op_code                          = metadata.opcode(insts[i]);
+    internal::CompactEncoding const &encoding = encodings[op_code];
+    std::byte *p                              = bytes.data() + byte_offsets[i];
+    internal::CompactStore(p, internal::CompactOpCode(encoding.handler));
+    if (encoding.jumps) {
+      size_t target = i + insts[i + 1].as<ptrdiff_t>();
+      internal::CompactStore(
+          p, static_cast<int32_t>(static_cast<ptrdiff_t>(byte_offsets[target]) -
+                                  static_cast<ptrdiff_t>(byte_offsets[i])));
+    } else if (encoding.encode) {
+      Value const *immediates = &insts[i + 1];
+      if (encoding.determined) {
+        internal::CompactStore(
+            p, (immediates++)->as<InstructionSpecification>());
+      }
+      encoding.encode(immediates, p);
+    }
+    i += 1 + metadata.metadata(op_code).immediate_value_count;
+  }
+
+  f.set_compact_encoding(std::move(bytes), internal::InvokeCompact<Set>);
+  return true;
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_CORE_COMPACT_H
@@ -0,0 +1,151 @@
+#include "hop/core/compact.h"
+
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "hop/testing/fibonacci.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+// Replaces its inputs with their sum scaled by the immediate value.
+struct ScaledSum : Instruction<ScaledSum> {
+  static void consume(std::span<Value> in, std::span<Value> out,
+                      uint16_t scale) {
+    uint64_t total = 0;
+    for (Value v : in) { total += v.as<uint64_t>(); }
+    out[0] = total * scale;
+  }
+};
+
+using Instructions =
+    MakeInstructionSet<Duplicate, Swap, Push<uint64_t>, Push<Function<> *>,
+                       LessThan<uint64_t>, Add<uint64_t>, Subtract<uint64_t>,
+                       ScaledSum>;
+
+NTH_TEST("compact/recursion") {
+  Function<Instructions> f(1, 1);
+  BuildFibonacci(f);
+  NTH_ASSERT(f.compact_entry() == nullptr);
+  NTH_ASSERT(Compact(f));
+  NTH_ASSERT(f.compact_entry() != nullptr);
+  NTH_EXPECT(f.compact_instructions().size() <
+             f.raw_instructions().size() * sizeof(Value));
+
+  nth::stack<Value> stack = {uint64_t{20}};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{6765});
+}
+
+NTH_TEST("compact/call-direct") {
+  Function<Instructions> f(1, 1);
+  BuildFibonacci(f, FibonacciCall::Direct);
+  Compact(f);
+
+  nth::stack<Value> stack = {uint64_t{20}};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{6765});
+}
+
+NTH_TEST("compact/immediate-value-determined") {
+  Function<Instructions> f(0, 1);
+  f.append<Push<uint64_t>>(3);
+  f.append<Push<uint64_t>>(4);
+  f.append<Push<uint64_t>>(5);
+  f.append<ScaledSum>({.parameters = 3, .returns = 1}, 10);
+  f.append<Return>();
+  Compact(f);
+
+  nth::stack<Value> stack;
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{120});
+}
+
+NTH_TEST("compact/switch") {
+  // Maps 1 to 10 and 2 to 20, and every other key to 0.
+  Function<Instructions> f(1, 1);
+  f.append<Switch>(1, 2);
+  auto one       = f.append_with_placeholders<Jump>();
+  auto two       = f.append_with_placeholders<Jump>();
+  auto otherwise = f.append_with_placeholders<Jump>();
+  auto push_ten  = f.append<Push<uint64_t>>(10);
+  f.append<Return>();
+  auto push_twenty = f.append<Push<uint64_t>>(20);
+  f.append<Return>();
+  auto push_zero = f.append<Push<uint64_t>>(0);
+  f.append<Return>();
+  f.set_value(one, 0, push_ten.lower_bound() - one.lower_bound());
+  f.set_value(two, 0, push_twenty.lower_bound() - two.lower_bound());
+  f.set_value(otherwise, 0, push_zero.lower_bound() - otherwise.lower_bound());
+  Compact(f);
+
+  uint64_t expected[] = {0, 10, 20, 0};
+  for (uint64_t key = 0; key < 4; ++key) {
+    nth::stack<Value> stack = {key};
+    f.invoke(stack);
+    NTH_ASSERT(stack.size() == size_t{1});
+    NTH_EXPECT(stack.top().as<uint64_t>() == expected[key]);
+  }
+}
+
+NTH_TEST("compact/modification") {
+  Function<Instructions> f(0, 1);
+  auto push = f.append<Push<uint64_t>>(3);
+  f.append<Return>();
+  NTH_ASSERT(Compact(f));
+
+  f.set_value(push, 0, uint64_t{7});
+  NTH_EXPECT(f.compact_entry() == nullptr);
+  nth::stack<Value> stack;
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{7});
+
+  NTH_ASSERT(Compact(f));
+  f.append<Return>();
+  NTH_EXPECT(f.compact_entry() == nullptr);
+}
+
+NTH_TEST("compact/uncompacted-callee") {
+  Function<Instructions> fibonacci(1, 1);
+  BuildFibonacci(fibonacci, FibonacciCall::Direct);
+  InstructionSpecification spec{.parameters = 1, .returns = 1};
+
+  Function<Instructions> call(1, 1);
+  call.append<Push<Function<> *>>(&fibonacci);
+  call.append<Call>(spec);
+  call.append<Return>();
+
+  Function<Instructions> call_direct(1, 1);
+  call_direct.append<CallDirect>(spec, &fibonacci);
+  call_direct.append<Return>();
+
+  Function<Instructions> tail_call(1, 1);
+  tail_call.append<Push<Function<> *>>(&fibonacci);
+  tail_call.append<TailCall>(spec);
+
+  for (auto *f : {&call, &call_direct, &tail_call}) {
+    NTH_ASSERT(Compact(*f));
+    nth::stack<Value> stack = {uint64_t{10}};
+    f->invoke(stack);
+    NTH_ASSERT(stack.size() == size_t{1});
+    NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{55});
+  }
+}
+
+NTH_TEST("compact/no-compact-encoding") {
+  // `Yield` has no compact encoding, so the function is left unchanged.
+  Function<Instructions> f(0, 0);
+  f.append<Yield>();
+  f.append<Return>();
+  NTH_EXPECT(not Compact(f));
+  NTH_EXPECT(f.compact_entry() == nullptr);
+}
+
+}  // namespace
+}  // namespace hop
@@ -0,0 +1,233 @@
+#ifndef JASMIN_CORE_CONTINUATION_H
+#define JASMIN_CORE_CONTINUATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <utility>
+
+#include "hop/core/function.h"
+#include "hop/core/instruction.h"
+#include "hop/core/internal/frame.h"
+#include "hop/core/internal/function_state.h"
+#include "hop/core/value.h"
+#include "nth/container/stack.h"
+#include "nth/debug/debug.h"
+
+namespace hop {
+
+// A `Continuation` represents an execution of a function which may be
+// suspended by the `Yield` instruction and later resumed, possibly on a
+// different thread. While suspended, the execution's value stack may be
+// inspected and modified via `value_stack()`, which is how values are typically
+// exchanged with the host. A suspended execution holds no thread-specific
+// resources, so any number of continuations may be multiplexed onto a small
+// number of threads.
+//
+// When fuel is metered (see the `//hop/configuration:fuel` build flag), each
+// backward jump and each call consumes one unit of fuel. An execution resumed
+// with a limited amount of fuel suspends itself, without executing the
+// offending instruction, once its fuel is exhausted. The host may then resume
+// it later, or abort it by destroying the continuation. This allows many
+// long-running executions to be fairly time-sliced.
+//
+// ```
+// hop::Continuation<Set> c(fn, {argument});
+// c.resume();
+// while (not c.done()) {
+//   c.value_stack().push(AwaitHostRequest(c.value_stack().top()));
+//   c.resume();
+// }
+// ```
+template <InstructionSetType Set>
+struct Continuation {
+  // The value stack of a suspended or completed execution. Beneath its values
+  // lies one more, reserved for the top-of-stack cache, so that resuming the
+  // execution never requires moving the values already on the stack.
+  struct ValueStack {
+    size_t size() const { return values_.size() - 1; }
+    bool empty() const { return size() == 0; }
+
+    Value &top() { return values_.top(); }
+    Value const &top() const { return values_.top(); }
+
+    std::span<Value> top_span(size_t n) {
+      NTH_REQUIRE((harden), n <= size());
+      return values_.top_span(n);
+    }
+    std::span<Value const> top_span(size_t n) const {
+      NTH_REQUIRE((harden), n <= size());
+      return values_.top_span(n);
+    }
+
+    void push(Value v) { values_.push(v); }
+    void pop() {
+      NTH_REQUIRE((harden), not empty());
+      values_.pop();
+    }
+
+   private:
+    friend Continuation;
+
+    nth::stack<Value> values_ = {Value::Uninitialized()};
+  };
+
+  // Constructs a continuation which, when first resumed, begins executing
+  // `fn` with `arguments`.
+  explicit Continuation(Function<Set> const &fn,
+                        nth::stack<Value> arguments = {});
+
+  Continuation(Continuation &&)            = default;
+  Continuation &operator=(Continuation &&) = default;
+
+  ~Continuation();
+
+  // Returns whether the function has returned. Once done, `value_stack()`
+  // holds the function's return values.
+  bool done() const { return state_->done; }
+
+  // Returns the value stack of a suspended or completed execution. An
+  // execution suspended because it exhausted its fuel may be in the midst of
+  // a finalized function, whose instructions do not check the stack's
+  // capacity. Resuming therefore first ensures that at least as much capacity
+  // remains above the top of the stack as did when it was suspended, so values
+  // pushed in the meantime never overflow it.
+  ValueStack &value_stack() { return state_->value_stack; }
+  ValueStack const &value_stack() const { return state_->value_stack; }
+
+  // Continues execution until the function either executes `Yield` or
+  // returns. Requires that the execution is not `done()`.
+  void resume() { resume(std::numeric_limits<uint64_t>::max()); }
+
+  // Continues execution until the function either executes `Yield`, returns,
+  // or, if fuel is metered, attempts to execute a backward jump or call after
+  // having executed `fuel` of them. Requires that the execution is not
+  // `done()`.
+  void resume(uint64_t fuel);
+
+  // Returns whether the most recent call to `resume` suspended the execution
+  // because it exhausted its fuel, rather than because of a `Yield`.
+  bool out_of_fuel() const { return state_->out_of_fuel; }
+
+ private:
+  using frame_type = internal::Frame<internal::FunctionState<Set>>;
+
+  struct State {
+    ValueStack value_stack;
+    Value const *ip;
+    // The call stack of a suspended execution, or null if execution has not
+    // yet begun.
+    internal::FrameBase *call_stack = nullptr;
+    uint64_t cs_left                = 0;
+    bool done                       = false;
+    bool out_of_fuel                = false;
+    // The number of values which could be pushed onto the value stack of the
+    // suspended execution before it had to grow, when it was suspended.
+    size_t headroom = 0;
+
+    // Written by `internal::FinishExecution` when the function returns.
+    Value *finished_top;
+    size_t finished_remaining;
+    internal::CachedValue finished_cached;
+    internal::FrameBase *finished_call_stack;
+    uint64_t finished_cs_left;
+    Value landing_pad[6];
+  };
+
+  // Held indirectly so that the pointers held by frames into `landing_pad` and
+  // by `landing_pad` into the state remain valid when continuations move.
+  std::unique_ptr<State> state_;
+};
+
+template <InstructionSetType Set>
+Continuation<Set>::Continuation(Function<Set> const &fn,
+                                nth::stack<Value> arguments)
+    : state_(std::make_unique<State>()) {
+  NTH_REQUIRE((harden), arguments.size() == fn.parameter_count());
+  State &s                = *state_;
+  nth::stack<Value> &values = s.value_stack.values_;
+  values.reserve(1 + std::max(fn.parameter_count(), fn.max_stack_depth()));
+  for (Value v : arguments.top_span(arguments.size())) { values.push(v); }
+  s.ip = fn.entry();
+  s.landing_pad[0] = &internal::FinishExecution;
+  s.landing_pad[1] = &s.finished_top;
+  s.landing_pad[2] = &s.finished_remaining;
+  s.landing_pad[3] = &s.finished_cached;
+  s.landing_pad[4] = &s.finished_call_stack;
+  s.landing_pad[5] = &s.finished_cs_left;
+}
+
+template <InstructionSetType Set>
+Continuation<Set>::~Continuation() {
+  // Destroy the frames of an execution which was suspended and never resumed
+  // to completion.
+  if (state_ and state_->call_stack and not state_->done) {
+    nth::stack<frame_type>::reconstitute_from(
+        static_cast<frame_type *>(state_->call_stack), state_->cs_left);
+  }
+}
+
+template <InstructionSetType Set>
+void Continuation<Set>::resume(uint64_t fuel) {
+  State &s = *state_;
+  NTH_REQUIRE((harden), not s.done);
+  nth::stack<frame_type> call_stack;
+  if (s.call_stack == nullptr) {
+    call_stack.emplace();
+    call_stack.top().ip = &s.landing_pad[0];
+  } else {
+    call_stack = nth::stack<frame_type>::reconstitute_from(
+        static_cast<frame_type *>(s.call_stack), s.cs_left);
+  }
+  // The outermost frame is at the bottom of the call stack, which may have
+  // moved since execution was last suspended.
+  frame_type const *frames_begin = &call_stack.top() + 1 - call_stack.size();
+  std::tie(s.call_stack, s.cs_left) = std::move(call_stack).release();
+
+  internal::CachedValue cached;
+  nth::stack<Value> &values = s.value_stack.values_;
+  internal::MoveTopToCache(values, cached, /*reserved=*/true);
+  values.reserve(values.size() + s.headroom);
+  auto [top, remaining] = internal::ReleaseValueStack(values);
+
+  internal::Suspension suspension;
+  suspension.suspended = false;
+  suspension.fuel      = fuel;
+  internal::Suspension *previous =
+      std::exchange(internal::active_suspension, &suspension);
+  {
+    internal::SampledExecutionScope<frame_type> sampled(frames_begin);
+    s.ip->as<internal::exec_fn_type>()(top, remaining, s.ip, s.call_stack,
+                                       s.cs_left, cached);
+  }
+  internal::active_suspension = previous;
+
+  s.out_of_fuel = suspension.suspended and suspension.out_of_fuel;
+  if (suspension.suspended) {
+    top          = suspension.value_stack_head;
+    remaining    = suspension.vs_left;
+    cached       = suspension.top;
+    s.ip         = suspension.ip;
+    s.call_stack = suspension.call_stack;
+    s.cs_left    = suspension.cs_left;
+    s.headroom   = remaining;
+  } else {
+    top       = s.finished_top;
+    remaining = s.finished_remaining;
+    cached    = s.finished_cached;
+    // Releases the memory held by the now empty call stack.
+    nth::stack<frame_type>::reconstitute_from(
+        static_cast<frame_type *>(s.finished_call_stack), s.finished_cs_left);
+    s.done = true;
+  }
+  internal::RestoreValueStack(values, top, remaining);
+  internal::MoveCacheToTop(values, cached, /*placeholder=*/false);
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_CORE_CONTINUATION_H
@@ -0,0 +1,194 @@
+#include "hop/core/continuation.h"
+
+#include <vector>
+
+#include "hop/core/function.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+struct Add : Instruction<Add> {
+  static constexpr void consume(Input<int, int> in, Output<int> out) {
+    out.set<0>(in.get<0>() + in.get<1>());
+  }
+};
+
+struct PushFunction : Instruction<PushFunction> {
+  static constexpr void execute(Input<>, Output<Function<> const *> out,
+                                Function<> const *f) {
+    out.set<0>(f);
+  }
+};
+
+struct Decrement : Instruction<Decrement> {
+  static constexpr void consume(Input<int> in, Output<int> out) {
+    out.set<0>(in.get<0>() - 1);
+  }
+};
+
+struct NonZero : Instruction<NonZero> {
+  static constexpr void execute(Input<int> in, Output<bool> out) {
+    out.set<0>(in.get<0>() != 0);
+  }
+};
+
+using Instructions =
+    MakeInstructionSet<Add, PushFunction, Decrement, NonZero>;
+
+NTH_TEST("continuation/no-yield") {
+  Function<Instructions> f(2, 1);
+  f.append<Add>();
+  f.append<Return>();
+
+  Continuation<Instructions> c(f, {1, 2});
+  NTH_EXPECT(not c.done());
+  c.resume();
+  NTH_ASSERT(c.done());
+  NTH_ASSERT(c.value_stack().size() == size_t{1});
+  NTH_EXPECT(c.value_stack().top().as<int>() == 3);
+}
+
+NTH_TEST("continuation/yield") {
+  // Yields twice, expecting the host to push a value each time, and returns
+  // the sum of its argument and both values.
+  Function<Instructions> f(1, 1);
+  f.append<Yield>();
+  f.append<Add>();
+  f.append<Yield>();
+  f.append<Add>();
+  f.append<Return>();
+
+  Continuation<Instructions> c(f, {1});
+  c.resume();
+  NTH_ASSERT(not c.done());
+  NTH_ASSERT(c.value_stack().size() == size_t{1});
+  NTH_EXPECT(c.value_stack().top().as<int>() == 1);
+  c.value_stack().push(10);
+
+  c.resume();
+  NTH_ASSERT(not c.done());
+  NTH_EXPECT(c.value_stack().top().as<int>() == 11);
+  c.value_stack().push(100);
+
+  c.resume();
+  NTH_ASSERT(c.done());
+  NTH_ASSERT(c.value_stack().size() == size_t{1});
+  NTH_EXPECT(c.value_stack().top().as<int>() == 111);
+}
+
+NTH_TEST("continuation/finalize") {
+  // The value pushed by the host while suspended is not accounted for by the
+  // function's instructions, so the function must not be finalized.
+  Function<Instructions> f(1, 1);
+  f.append<Yield>();
+  f.append<Add>();
+  f.append<Return>();
+  f.finalize();
+  NTH_EXPECT(f.max_stack_depth() == 0u);
+
+  Continuation<Instructions> c(f, {1});
+  c.resume();
+  NTH_ASSERT(not c.done());
+  c.value_stack().push(10);
+  c.resume();
+  NTH_ASSERT(c.done());
+  NTH_ASSERT(c.value_stack().size() == size_t{1});
+  NTH_EXPECT(c.value_stack().top().as<int>() == 11);
+}
+
+NTH_TEST("continuation/yield-from-callee") {
+  Function<Instructions> g(1, 1);
+  g.append<Yield>();
+  g.append<Add>();
+  g.append<Return>();
+
+  Function<Instructions> f(1, 1);
+  f.append<PushFunction>(&g);
+  f.append<Call>({.parameters = 1, .returns = 1});
+  f.append<PushFunction>(&g);
+  f.append<Call>({.parameters = 1, .returns = 1});
+  f.append<Return>();
+
+  // Interleave several suspended executions.
+  std::vector<Continuation<Instructions>> continuations;
+  for (int i = 0; i < 3; ++i) { continuations.emplace_back(f, nth::stack<Value>{i}); }
+  for (int round = 0; round < 2; ++round) {
+    for (auto &c : continuations) {
+      c.resume();
+      NTH_ASSERT(not c.done());
+      c.value_stack().push(10);
+    }
+  }
+  for (int i = 0; i < 3; ++i) {
+    auto &c = continuations[i];
+    c.resume();
+    NTH_ASSERT(c.done());
+    NTH_EXPECT(c.value_stack().top().as<int>() == 20 + i);
+  }
+}
+
+NTH_TEST("continuation/abandoned") {
+  Function<Instructions> f(0, 0);
+  f.append<Yield>();
+  f.append<Return>();
+
+  Continuation<Instructions> c(f);
+  c.resume();
+  NTH_EXPECT(not c.done());
+}
+
+NTH_TEST("continuation/fuel") {
+  // Decrements its argument until it reaches zero.
+  Function<Instructions> f(1, 1);
+  auto loop = f.append<Decrement>();
+  f.append<NonZero>();
+  auto jump = f.append_with_placeholders<JumpIf>();
+  f.append<Return>();
+  f.set_value(jump, 0, loop.lower_bound() - jump.lower_bound());
+
+  Continuation<Instructions> c(f, {100});
+  int resumptions = 0;
+  do {
+    c.resume(10);
+    ++resumptions;
+    NTH_ASSERT(c.done() or c.out_of_fuel());
+  } while (not c.done());
+  NTH_EXPECT(not c.out_of_fuel());
+  NTH_ASSERT(c.value_stack().size() == size_t{1});
+  NTH_EXPECT(c.value_stack().top().as<int>() == 0);
+  // Each resumption executes the backward jump ten times, and the last
+  // resumption completes the final iteration.
+  NTH_EXPECT(resumptions == (internal::meter_fuel ? 10 : 1));
+}
+
+NTH_TEST("continuation/fuel-host-values") {
+  // Decrements the value on top of the stack until it reaches zero.
+  Function<Instructions> f(1, 1);
+  auto loop = f.append<Decrement>();
+  f.append<NonZero>();
+  auto jump = f.append_with_placeholders<JumpIf>();
+  f.append<Return>();
+  f.set_value(jump, 0, loop.lower_bound() - jump.lower_bound());
+  f.finalize();
+
+  Continuation<Instructions> c(f, {100});
+  c.resume(10);
+  if constexpr (not internal::meter_fuel) {
+    NTH_EXPECT(c.done());
+    return;
+  }
+  NTH_ASSERT(c.out_of_fuel());
+  // The execution is suspended in the midst of a finalized function, which
+  // does not check capacity, so the values pushed here must not consume the
+  // capacity it relies upon.
+  for (int i = 0; i < 64; ++i) { c.value_stack().push(1); }
+  c.resume();
+  NTH_ASSERT(c.done());
+  NTH_ASSERT(c.value_stack().size() == size_t{65});
+  NTH_EXPECT(c.value_stack().top().as<int>() == 0);
+}
+
+}  // namespace
+}  // namespace hop
@@ -20,6 +20,9 @@ struct Debugger {
   explicit Debugger(ProgramFragment<Set> &program NTH_ATTRIBUTE(lifetimebound))
       : program_(program) {}
 
+  // Arranges for `response` to be invoked each time the function named `name`
+  // is called. The function is replaced in place, so calls made via either
+  // `Call` or `CallDirect` trigger the breakpoint.
   void set_function_breakpoint(std::string name,
                                std::function<void()> response);
 
@@ -35,16 +38,29 @@ Debugger(ProgramFragment<Set> &) -> Debugger<Set>;
 
 namespace internal {
 
+// Executed in place of the first instruction of a function with a breakpoint.
+// Callers reserve only the capacity required by the function holding this
+// instruction, which requires none, so the original function, which may have
+// been finalized, is entered only once the value stack has the capacity its
+// entry requires.
 template <InstructionSetType Set>
 void DebugImpl(Value *vs_head, size_t vs_remaining, Value const *ip,
-               FrameBase *cs, uint64_t cs_remaining) {
+               FrameBase *cs, uint64_t cs_remaining, CachedValue top) {
   auto &[fn, response] =
       *(ip + 1)->as<std::pair<Function<Set>, std::function<void()>> *>();
+  if (not HasEntryCapacity(&fn, vs_remaining)) [[unlikely]] {
+    // Execution resumes at this instruction once the stack has grown, so the
+    // response is only invoked once capacity suffices.
+    NTH_ATTRIBUTE(tailcall)
+    return ReallocateValueStack(vs_head, vs_remaining, ip, cs, cs_remaining,
+                                top);
+  }
   response();
   ip = fn.entry();
 
   NTH_ATTRIBUTE(tailcall)
-  return ip->as<exec_fn_type>()(vs_head, vs_remaining, ip, cs, cs_remaining);
+  return ip->as<exec_fn_type>()(vs_head, vs_remaining, ip, cs, cs_remaining,
+                                top);
 }
 
 }  // namespace internal
@@ -58,7 +74,8 @@ void Debugger<Set>::set_function_breakpoint(std::string name,
       std::move(response));
   NTH_REQUIRE((harden), inserted);
   iter->second.first = std::move(f);
-  f                  = Function<Set>(0, 0);
+  f = Function<Set>(iter->second.first.parameter_count(),
+                    iter->second.first.return_count());
   f.raw_append(internal::DebugImpl<Set>);
   f.raw_append(&iter->second);
 }
@@ -0,0 +1,38 @@
+#include "hop/core/debugger.h"
+
+#include "hop/core/program_fragment.h"
+#include "hop/instructions/common.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+using Instructions = MakeInstructionSet<Push<uint64_t>, Drop>;
+
+NTH_TEST("debugger/function-breakpoint") {
+  ProgramFragment<Instructions> program;
+  auto &f = program.declare("f", 1, 1).function;
+  for (int i = 0; i < 64; ++i) { f.append<Push<uint64_t>>(i); }
+  for (int i = 0; i < 64; ++i) { f.append<Drop>(); }
+  f.append<Return>();
+  f.finalize();
+
+  Debugger debugger(program);
+  int hits = 0;
+  debugger.set_function_breakpoint("f", [&] { ++hits; });
+  Function<Instructions> const &g = program.function("f");
+  NTH_EXPECT(g.parameter_count() == 1u);
+  NTH_EXPECT(g.return_count() == 1u);
+
+  // The finalized function requires far more capacity than is reserved for
+  // the function replacing it.
+  nth::stack<Value> stack = {uint64_t{3}};
+  g.invoke(stack);
+  NTH_EXPECT(hits == 1);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{3});
+}
+
+}  // namespace
+}  // namespace hop
@@ -0,0 +1,68 @@
+#ifndef JASMIN_CORE_EXECUTION_CONTEXT_H
+#define JASMIN_CORE_EXECUTION_CONTEXT_H
+
+#include <span>
+
+#include "hop/core/function.h"
+#include "hop/core/instruction.h"
+#include "hop/core/internal/frame.h"
+#include "hop/core/internal/function_state.h"
+#include "hop/core/value.h"
+#include "nth/container/stack.h"
+#include "nth/debug/debug.h"
+
+namespace hop {
+
+// An `ExecutionContext` owns the value stack and call stack used to execute
+// functions over the instruction set `Set`. Both stacks retain their capacity
+// between invocations, so that once a context has executed a function,
+// subsequent executions of functions no deeper than it perform no heap
+// allocations. Contexts are not thread-safe; a context may be used for only one
+// invocation at a time.
+template <InstructionSetType Set>
+struct ExecutionContext {
+  // Invokes `fn` with `args...` as its arguments, returning the values
+  // returned by `fn`. The returned span is valid until the next invocation
+  // with this context. Compact encodings (see "hop/core/compact.h") are not
+  // used.
+  std::span<Value const> invoke(Function<Set> const &fn, auto... args) {
+    NTH_REQUIRE((harden), sizeof...(args) == fn.parameter_count());
+    Prepare(fn);
+    (value_stack_.push(Value(args)), ...);
+    return Run(fn);
+  }
+
+  // Invokes `fn` with `arguments`, returning the values returned by `fn`. The
+  // returned span is valid until the next invocation with this context.
+  std::span<Value const> invoke(Function<Set> const &fn,
+                                std::span<Value const> arguments) {
+    NTH_REQUIRE((harden), arguments.size() == fn.parameter_count());
+    Prepare(fn);
+    for (Value v : arguments) { value_stack_.push(v); }
+    return Run(fn);
+  }
+
+ private:
+  void Prepare(Function<Set> const &fn) {
+    while (value_stack_.size() != 1) { value_stack_.pop(); }
+    if (fn.max_stack_depth() > fn.parameter_count()) {
+      value_stack_.reserve(1 + fn.max_stack_depth());
+    }
+  }
+
+  std::span<Value const> Run(Function<Set> const &fn) {
+    internal::Invoke<Set>(value_stack_, call_stack_, fn.entry(),
+                          /*reserved=*/true);
+    return value_stack_.top_span(fn.return_count());
+  }
+
+  // The bottom-most value is never used by the caller. It lies beneath the
+  // arguments of every invocation, so that the top-of-stack cache may be
+  // populated without moving them (see `internal::MoveTopToCache`).
+  nth::stack<Value> value_stack_ = {Value::Uninitialized()};
+  nth::stack<internal::Frame<internal::FunctionState<Set>>> call_stack_;
+};
+
+}  // namespace hop
+
+#endif  // JASMIN_CORE_EXECUTION_CONTEXT_H
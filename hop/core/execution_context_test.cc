@@ -0,0 +1,60 @@
+#include "hop/core/execution_context.h"
+
+#include "hop/core/function.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+struct Add : Instruction<Add> {
+  static constexpr void consume(Input<int, int> in, Output<int> out) {
+    out.set<0>(in.get<0>() + in.get<1>());
+  }
+};
+
+struct PushFunction : Instruction<PushFunction> {
+  static constexpr void execute(Input<>, Output<Function<> const *> out,
+                                Function<> const *f) {
+    out.set<0>(f);
+  }
+};
+
+using Instructions = MakeInstructionSet<Add, PushFunction>;
+
+NTH_TEST("execution-context/invoke") {
+  Function<Instructions> f(2, 1);
+  f.append<Add>();
+  f.append<Return>();
+
+  ExecutionContext<Instructions> context;
+  std::span results = context.invoke(f, 3, 4);
+  NTH_ASSERT(results.size() == size_t{1});
+  NTH_EXPECT(results[0].as<int>() == 7);
+
+  results = context.invoke(f, 5, 6);
+  NTH_ASSERT(results.size() == size_t{1});
+  NTH_EXPECT(results[0].as<int>() == 11);
+}
+
+NTH_TEST("execution-context/nested-calls") {
+  Function<Instructions> g(2, 1);
+  g.append<Add>();
+  g.append<Return>();
+
+  Function<Instructions> f(3, 1);
+  f.append<PushFunction>(&g);
+  f.append<Call>({.parameters = 2, .returns = 1});
+  f.append<PushFunction>(&g);
+  f.append<Call>({.parameters = 2, .returns = 1});
+  f.append<Return>();
+
+  ExecutionContext<Instructions> context;
+  for (int i = 0; i < 3; ++i) {
+    std::span results = context.invoke(f, 1, 2, i);
+    NTH_ASSERT(results.size() == size_t{1});
+    NTH_EXPECT(results[0].as<int>() == 3 + i);
+  }
+}
+
+}  // namespace
+}  // namespace hop
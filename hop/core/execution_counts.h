@@ -0,0 +1,81 @@
+#ifndef JASMIN_CORE_EXECUTION_COUNTS_H
+#define JASMIN_CORE_EXECUTION_COUNTS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+#include "hop/core/instruction.h"
+#include "hop/core/metadata.h"
+
+namespace hop {
+
+// The number of times an instruction has been executed.
+struct InstructionCount {
+  // The op-code of the instruction, as given by `InstructionSetMetadata`.
+  uint16_t opcode;
+  // The name of the instruction, as given by `InstructionMetadata`.
+  std::string_view name;
+  uint64_t count;
+};
+
+// Returns the number of times each instruction in `Set` has been executed
+// since the program began or since the counts were last reset, indexed by
+// op-code. Executions are only counted when the `//hop/configuration` flag is
+// set to "profile"; otherwise every count is zero. An instruction which must
+// grow the value stack or call stack before executing is counted twice.
+template <InstructionSetType Set>
+std::vector<InstructionCount> ExecutionCounts() {
+  auto const &metadata = Metadata<Set>();
+  std::vector<InstructionCount> counts;
+  counts.reserve(metadata.size());
+  for (uint16_t opcode = 0; opcode < metadata.size(); ++opcode) {
+    uint64_t count = 0;
+    if constexpr (internal::profile) {
+      count = internal::execution_counts<Set>[opcode].load(
+          std::memory_order_relaxed);
+    }
+    counts.push_back({
+        .opcode = opcode,
+        .name   = metadata.metadata(opcode).name,
+        .count  = count,
+    });
+  }
+  return counts;
+}
+
+// Resets the number of executions of each instruction in `Set` to zero.
+template <InstructionSetType Set>
+void ResetExecutionCounts() {
+  if constexpr (internal::profile) {
+    for (auto &count : internal::execution_counts<Set>) {
+      count.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+// Writes the name and number of executions of each instruction in `Set` that
+// has been executed to `file`, one per line, in decreasing order of execution
+// count.
+template <InstructionSetType Set>
+void DumpExecutionCounts(std::FILE *file = stderr) {
+  std::vector<InstructionCount> counts = ExecutionCounts<Set>();
+  std::stable_sort(counts.begin(), counts.end(),
+                   [](InstructionCount const &l, InstructionCount const &r) {
+                     return l.count > r.count;
+                   });
+  for (auto const &[opcode, name, count] : counts) {
+    if (count == 0) { break; }
+    std::fprintf(file, "%14" PRIu64 " %5u %.*s\n", count,
+                 static_cast<unsigned>(opcode), static_cast<int>(name.size()),
+                 name.data());
+  }
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_CORE_EXECUTION_COUNTS_H
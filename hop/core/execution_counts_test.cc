@@ -0,0 +1,57 @@
+#include "hop/core/execution_counts.h"
+
+#include "hop/core/function.h"
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+using Instructions =
+    MakeInstructionSet<Duplicate, Push<uint64_t>, Add<uint64_t>>;
+
+NTH_TEST("execution-counts/names") {
+  auto counts = ExecutionCounts<Instructions>();
+  NTH_ASSERT(counts.size() == Metadata<Instructions>().size());
+  for (auto const &count : counts) {
+    NTH_EXPECT(count.name ==
+               Metadata<Instructions>().metadata(count.opcode).name);
+  }
+}
+
+NTH_TEST("execution-counts/count") {
+  Function<Instructions> f(1, 1);
+  f.append<Duplicate>();
+  f.append<Add<uint64_t>>();
+  f.append<Push<uint64_t>>(1);
+  f.append<Add<uint64_t>>();
+  f.append<Return>();
+
+  ResetExecutionCounts<Instructions>();
+  for (int i = 0; i < 3; ++i) {
+    nth::stack<Value> stack = {uint64_t{1}};
+    f.invoke(stack);
+  }
+
+  auto const &metadata = Metadata<Instructions>();
+  auto counts          = ExecutionCounts<Instructions>();
+  auto count_of        = [&](auto f) {
+    return counts[metadata.opcode(f)].count;
+  };
+  uint64_t n = internal::profile ? 3 : 0;
+  NTH_EXPECT(count_of(&Duplicate::ExecuteImpl<Instructions>) == n);
+  NTH_EXPECT(count_of(&Add<uint64_t>::ExecuteImpl<Instructions>) == 2 * n);
+  NTH_EXPECT(count_of(&Push<uint64_t>::ExecuteImpl<Instructions>) == n);
+  NTH_EXPECT(count_of(&Return::ExecuteImpl<Instructions>) == n);
+  NTH_EXPECT(count_of(&Call::ExecuteImpl<Instructions>) == uint64_t{0});
+
+  ResetExecutionCounts<Instructions>();
+  for (auto const &count : ExecutionCounts<Instructions>()) {
+    NTH_EXPECT(count.count == uint64_t{0});
+  }
+}
+
+}  // namespace
+}  // namespace hop
@@ -0,0 +1,316 @@
+#ifndef JASMIN_CORE_EXECUTOR_H
+#define JASMIN_CORE_EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "hop/core/execution_context.h"
+#include "hop/core/function.h"
+#include "hop/core/internal/work_stealing_deque.h"
+#include "hop/core/value.h"
+
+namespace hop {
+
+// An `Executor` invokes functions over the instruction set `Set` on a pool of
+// worker threads. Each worker owns an `ExecutionContext`, so workers share no
+// interpreter state, and steady-state execution does not allocate stacks.
+// Submitted jobs are distributed across per-worker inboxes; a worker moves the
+// contents of its inbox into a deque of its own, and a worker with nothing to
+// do steals from the inboxes and deques of others. None of these operations
+// takes a lock, and workers with nothing to do sleep until woken by a
+// submission. Functions must not be modified while jobs invoking them are
+// outstanding, and instructions executed concurrently must be safe to execute
+// concurrently.
+template <InstructionSetType Set>
+struct Executor {
+  struct Job {
+    Function<Set> const *function;
+    std::vector<Value> arguments;
+  };
+
+  // Invoked on a worker thread with the values returned by a job. The span is
+  // only valid for the duration of the call.
+  using Callback = absl::AnyInvocable<void(std::span<Value const>) &&>;
+
+  // Constructs an executor with `worker_count` worker threads.
+  explicit Executor(size_t worker_count = std::thread::hardware_concurrency());
+
+  Executor(Executor const &)            = delete;
+  Executor &operator=(Executor const &) = delete;
+
+  // Waits for all submitted jobs to complete and then joins each worker.
+  ~Executor();
+
+  size_t worker_count() const { return workers_.size(); }
+
+  // Schedules `job` for execution, invoking `done` with its results.
+  void submit(Job job, Callback done);
+
+  // Schedules `job` for execution, returning a future holding its results.
+  std::future<std::vector<Value>> submit(Job job);
+
+  // Schedules each job in `jobs` for execution, returning futures holding
+  // their results in the same order. Jobs are divided into contiguous ranges,
+  // one per worker, so that each worker begins with work of its own.
+  std::vector<std::future<std::vector<Value>>> submit(std::vector<Job> jobs);
+
+ private:
+  struct Task {
+    Job job;
+    Callback done;
+    // The next task in an inbox.
+    Task *next = nullptr;
+  };
+
+  struct Worker {
+    // Tasks owned by this worker, which other workers may steal.
+    internal::WorkStealingDeque<Task> tasks;
+    // A lock-free stack of tasks submitted to this worker, linked through
+    // `Task::next`. Submitters push onto it, and workers take the entire stack
+    // at once, so no task is ever removed individually.
+    std::atomic<Task *> inbox = nullptr;
+    // Incremented to wake the worker while it is sleeping.
+    std::atomic<uint32_t> wake = 0;
+    std::atomic<bool> sleeping = false;
+    ExecutionContext<Set> context;
+    std::thread thread;
+  };
+
+  static Task *MakeTask(Job job, std::promise<std::vector<Value>> promise);
+
+  // Returns the worker to which the next job submitted from this thread is
+  // sent. Each submitting thread cycles through the workers independently, so
+  // that submitters do not contend on a shared counter.
+  Worker &NextWorker();
+
+  // Pushes the tasks `first` through `last`, linked through `Task::next`, onto
+  // the inbox of `worker`, and ensures that some worker will take them.
+  void Enqueue(Worker &worker, Task *first, Task *last);
+
+  // Takes the entire inbox `inbox`, moving all but one of its tasks into the
+  // deque of `self` and returning the remaining task, or null if the inbox is
+  // empty.
+  Task *Adopt(Worker &self, std::atomic<Task *> &inbox);
+
+  // Pops a task from the deque of the worker at `index`, or failing that, from
+  // its inbox, or failing that, steals one from another worker. Returns null
+  // if no task was found.
+  Task *Take(size_t index);
+
+  // Blocks the worker at `index` until it can take a task, returning that
+  // task, or null if the executor is stopping and no tasks remain.
+  Task *Park(size_t index);
+
+  static void Wake(Worker &worker);
+
+  // Wakes some sleeping worker, if there is one.
+  void WakeOne();
+
+  void Run(size_t index);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  // The number of workers which are sleeping or about to sleep. Only modified
+  // when a worker runs out of tasks, so that submitters can cheaply determine
+  // whether anyone needs to be woken.
+  alignas(64) std::atomic<size_t> sleepers_ = 0;
+  std::atomic<bool> stopping_              = false;
+};
+
+template <InstructionSetType Set>
+Executor<Set>::Executor(size_t worker_count) {
+  if (worker_count == 0) { worker_count = 1; }
+  workers_.reserve(worker_count);
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers_[i]->thread = std::thread([this, i] { Run(i); });
+  }
+}
+
+template <InstructionSetType Set>
+Executor<Set>::~Executor() {
+  stopping_.store(true, std::memory_order_seq_cst);
+  for (auto &worker : workers_) { Wake(*worker); }
+  for (auto &worker : workers_) { worker->thread.join(); }
+}
+
+template <InstructionSetType Set>
+typename Executor<Set>::Task *Executor<Set>::MakeTask(
+    Job job, std::promise<std::vector<Value>> promise) {
+  return new Task{
+      .job  = std::move(job),
+      .done = [promise = std::move(promise)](
+                  std::span<Value const> results) mutable {
+        promise.set_value(std::vector<Value>(results.begin(), results.end()));
+      },
+  };
+}
+
+template <InstructionSetType Set>
+typename Executor<Set>::Worker &Executor<Set>::NextWorker() {
+  thread_local size_t next = 0;
+  return *workers_[next++ % workers_.size()];
+}
+
+template <InstructionSetType Set>
+void Executor<Set>::submit(Job job, Callback done) {
+  Task *task = new Task{.job = std::move(job), .done = std::move(done)};
+  Enqueue(NextWorker(), task, task);
+}
+
+template <InstructionSetType Set>
+std::future<std::vector<Value>> Executor<Set>::submit(Job job) {
+  std::promise<std::vector<Value>> promise;
+  std::future future = promise.get_future();
+  Task *task         = MakeTask(std::move(job), std::move(promise));
+  Enqueue(NextWorker(), task, task);
+  return future;
+}
+
+template <InstructionSetType Set>
+std::vector<std::future<std::vector<Value>>> Executor<Set>::submit(
+    std::vector<Job> jobs) {
+  std::vector<std::future<std::vector<Value>>> futures;
+  futures.reserve(jobs.size());
+  size_t per_worker = (jobs.size() + workers_.size() - 1) / workers_.size();
+  size_t start      = 0;
+  for (auto &worker : workers_) {
+    size_t end = std::min(start + per_worker, jobs.size());
+    if (start == end) { break; }
+    Task *first = nullptr;
+    Task *last  = nullptr;
+    for (size_t i = start; i < end; ++i) {
+      std::promise<std::vector<Value>> promise;
+      futures.push_back(promise.get_future());
+      Task *task = MakeTask(std::move(jobs[i]), std::move(promise));
+      (last ? last->next : first) = task;
+      last                        = task;
+    }
+    Enqueue(*worker, first, last);
+    start = end;
+  }
+  return futures;
+}
+
+template <InstructionSetType Set>
+void Executor<Set>::Enqueue(Worker &worker, Task *first, Task *last) {
+  Task *head = worker.inbox.load(std::memory_order_relaxed);
+  do {
+    last->next = head;
+  } while (not worker.inbox.compare_exchange_weak(
+      head, first, std::memory_order_seq_cst, std::memory_order_relaxed));
+
+  // A worker about to sleep marks itself as sleeping before checking every
+  // inbox one last time, and the push above precedes these loads, so either
+  // that check finds the tasks or these loads find the worker. If `worker` is
+  // awake it will find the tasks itself, but waking an idle worker lets them
+  // start sooner.
+  if (worker.sleeping.load(std::memory_order_seq_cst)) {
+    Wake(worker);
+  } else if (sleepers_.load(std::memory_order_seq_cst) != 0) {
+    WakeOne();
+  }
+}
+
+template <InstructionSetType Set>
+typename Executor<Set>::Task *Executor<Set>::Adopt(
+    Worker &self, std::atomic<Task *> &inbox) {
+  // Checking before exchanging avoids writing to the cache line of every empty
+  // inbox scanned.
+  if (inbox.load(std::memory_order_seq_cst) == nullptr) { return nullptr; }
+  Task *task = inbox.exchange(nullptr, std::memory_order_seq_cst);
+  if (task == nullptr or task->next == nullptr) { return task; }
+
+  // Once pushed, a task may be stolen, run, and destroyed, so its successor
+  // must be read first.
+  for (Task *t = task->next; t != nullptr;) {
+    Task *next = t->next;
+    self.tasks.push(t);
+    t = next;
+  }
+  // Other tasks are now available to steal, so share them with a sleeping
+  // worker if there is one.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleepers_.load(std::memory_order_relaxed) != 0) { WakeOne(); }
+  return task;
+}
+
+template <InstructionSetType Set>
+typename Executor<Set>::Task *Executor<Set>::Take(size_t index) {
+  Worker &self = *workers_[index];
+  if (Task *task = self.tasks.pop()) { return task; }
+  if (Task *task = Adopt(self, self.inbox)) { return task; }
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    Worker &victim = *workers_[(index + i) % workers_.size()];
+    if (Task *task = victim.tasks.steal()) { return task; }
+    if (Task *task = Adopt(self, victim.inbox)) { return task; }
+  }
+  return nullptr;
+}
+
+template <InstructionSetType Set>
+typename Executor<Set>::Task *Executor<Set>::Park(size_t index) {
+  Worker &self = *workers_[index];
+  while (true) {
+    uint32_t epoch = self.wake.load(std::memory_order_acquire);
+    self.sleeping.store(true, std::memory_order_seq_cst);
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+
+    Task *task = Take(index);
+    // Jobs may not be submitted once the executor is stopping, so if no task
+    // remains now, none ever will.
+    bool stop = task == nullptr and stopping_.load(std::memory_order_seq_cst);
+    if (task == nullptr and not stop) {
+      self.wake.wait(epoch, std::memory_order_acquire);
+    }
+
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    self.sleeping.store(false, std::memory_order_relaxed);
+    if (task != nullptr or stop) { return task; }
+  }
+}
+
+template <InstructionSetType Set>
+void Executor<Set>::Wake(Worker &worker) {
+  worker.wake.fetch_add(1, std::memory_order_release);
+  worker.wake.notify_one();
+}
+
+template <InstructionSetType Set>
+void Executor<Set>::WakeOne() {
+  for (auto &worker : workers_) {
+    if (worker->sleeping.load(std::memory_order_relaxed)) {
+      Wake(*worker);
+      return;
+    }
+  }
+}
+
+template <InstructionSetType Set>
+void Executor<Set>::Run(size_t index) {
+  Worker &worker = *workers_[index];
+  while (true) {
+    Task *task = Take(index);
+    if (task == nullptr and (task = Park(index)) == nullptr) { return; }
+
+    std::span results = worker.context.invoke(*task->job.function,
+                                              std::span<Value const>(
+                                                  task->job.arguments));
+    std::move(task->done)(results);
+    delete task;
+  }
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_CORE_EXECUTOR_H
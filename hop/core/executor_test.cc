@@ -0,0 +1,116 @@
+#include "hop/core/executor.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "hop/core/function.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+struct Multiply : Instruction<Multiply> {
+  static constexpr void consume(Input<int, int> in, Output<int> out) {
+    out.set<0>(in.get<0>() * in.get<1>());
+  }
+};
+
+using Instructions = MakeInstructionSet<Multiply>;
+
+NTH_TEST("executor/future") {
+  Function<Instructions> f(2, 1);
+  f.append<Multiply>();
+  f.append<Return>();
+
+  Executor<Instructions> executor(4);
+  NTH_EXPECT(executor.worker_count() == size_t{4});
+  std::future result = executor.submit({.function = &f, .arguments = {6, 7}});
+  std::vector<Value> values = result.get();
+  NTH_ASSERT(values.size() == size_t{1});
+  NTH_EXPECT(values[0].as<int>() == 42);
+}
+
+NTH_TEST("executor/batch") {
+  Function<Instructions> f(2, 1);
+  f.append<Multiply>();
+  f.append<Return>();
+
+  std::vector<Executor<Instructions>::Job> jobs;
+  for (int i = 0; i < 1000; ++i) {
+    jobs.push_back({.function = &f, .arguments = {i, 2}});
+  }
+
+  Executor<Instructions> executor(3);
+  std::vector futures = executor.submit(std::move(jobs));
+  NTH_ASSERT(futures.size() == size_t{1000});
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<Value> values = futures[i].get();
+    NTH_ASSERT(values.size() == size_t{1});
+    NTH_EXPECT(values[0].as<int>() == 2 * i);
+  }
+}
+
+NTH_TEST("executor/callback") {
+  Function<Instructions> f(2, 1);
+  f.append<Multiply>();
+  f.append<Return>();
+
+  std::atomic<int> sum = 0;
+  {
+    Executor<Instructions> executor(2);
+    for (int i = 1; i <= 100; ++i) {
+      executor.submit({.function = &f, .arguments = {i, 1}},
+                      [&](std::span<Value const> results) {
+                        sum += results[0].as<int>();
+                      });
+    }
+    // Destroying the executor waits for all submitted jobs.
+  }
+  NTH_EXPECT(sum.load() == 5050);
+}
+
+NTH_TEST("executor/idle") {
+  Function<Instructions> f(2, 1);
+  f.append<Multiply>();
+  f.append<Return>();
+
+  // Jobs submitted after the workers have gone to sleep wake them.
+  Executor<Instructions> executor(2);
+  for (int i = 0; i < 3; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::vector<Value> values =
+        executor.submit({.function = &f, .arguments = {i, 3}}).get();
+    NTH_ASSERT(values.size() == size_t{1});
+    NTH_EXPECT(values[0].as<int>() == 3 * i);
+  }
+}
+
+NTH_TEST("executor/concurrent-submit") {
+  Function<Instructions> f(2, 1);
+  f.append<Multiply>();
+  f.append<Return>();
+
+  std::atomic<int> sum = 0;
+  {
+    Executor<Instructions> executor(3);
+    std::vector<std::thread> submitters;
+    for (int t = 0; t < 4; ++t) {
+      submitters.emplace_back([&] {
+        for (int i = 1; i <= 100; ++i) {
+          executor.submit({.function = &f, .arguments = {i, 1}},
+                          [&](std::span<Value const> results) {
+                            sum += results[0].as<int>();
+                          });
+        }
+      });
+    }
+    for (auto &submitter : submitters) { submitter.join(); }
+  }
+  NTH_EXPECT(sum.load() == 4 * 5050);
+}
+
+}  // namespace
+}  // namespace hop
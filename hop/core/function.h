@@ -1,14 +1,25 @@
 #ifndef JASMIN_CORE_FUNCTION_H
 #define JASMIN_CORE_FUNCTION_H
 
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
 #include "hop/core/function_identifier.h"
+#include "hop/core/guarded_value_stack.h"
 #include "hop/core/instruction.h"
 #include "hop/core/instruction_index.h"
+#include "hop/core/internal/dispatch_loop.h"
 #include "hop/core/internal/frame.h"
 #include "hop/core/internal/function_base.h"
 #include "hop/core/internal/function_forward.h"
 #include "hop/core/internal/instruction_traits.h"
 #include "hop/core/metadata.h"
+#include "nth/base/indestructible.h"
 #include "nth/container/interval.h"
 #include "nth/format/format.h"
 #include "nth/io/serialize/serialize.h"
@@ -62,10 +73,22 @@ struct Function<void> : internal::FunctionBase {
 
  protected:
   explicit Function(uint32_t parameter_count, uint32_t return_count,
-                    void (*invoke)(nth::stack<Value> &, Value const *))
-      : FunctionBase(parameter_count, return_count, invoke) {}
+                    void (*invoke)(nth::stack<Value> &, Value const *, bool),
+                    void (*guarded_invoke)(GuardedValueStack &, Value const *,
+                                           bool))
+      : FunctionBase(parameter_count, return_count, invoke, guarded_invoke) {}
+  explicit Function(uint32_t parameter_count, uint32_t return_count,
+                    void (*invoke)(nth::stack<Value> &, Value const *, bool),
+                    void (*guarded_invoke)(GuardedValueStack &, Value const *,
+                                           bool),
+                    std::vector<Value> instructions)
+      : FunctionBase(parameter_count, return_count, invoke, guarded_invoke,
+                     std::move(instructions)) {}
 };
 
+template <InstructionSetType Set>
+struct FunctionBuilder;
+
 // A representation of a function that ties op-codes to instructions (via an
 // `InstructionSet` template parameter).
 template <typename Set>
@@ -93,6 +116,30 @@ struct Function : Function<> {
       constexpr nth::interval<InstructionIndex> append(
           InstructionSpecification spec, auto... vs);
 
+  // Computes the maximum stack depth of this function (see
+  // `max_stack_depth`) and replaces each instruction with a variant that does
+  // not check the capacity of the value stack. Instead, capacity for the
+  // entire function is ensured once, on entry. Finalization must be the last
+  // modification made to a function: Other than serialization, the
+  // transformations of "hop/transform" and "hop/ssa" only recognize
+  // unfinalized instructions. Requires that every path through the function
+  // reaching a given instruction does so with the same stack height. Functions
+  // built from untrusted bytecode should first be checked with `Verify` (see
+  // "hop/core/verifier.h"). Functions containing `Yield` are left unchanged:
+  // the host may push values while they are suspended, to be consumed once
+  // they resume, so their maximum stack depth cannot be known.
+  void finalize();
+
+  // Invokes this function once for each consecutive group of
+  // `parameter_count()` values in `arguments`, writing the `return_count()`
+  // values returned by each invocation to the corresponding group of
+  // consecutive values in `results`. The value stack, call stack, and other
+  // state needed by an invocation are constructed once and shared by each
+  // invocation in the batch. Requires that `arguments` and `results` describe
+  // the same number of invocations.
+  void invoke_batch(std::span<Value const> arguments,
+                    std::span<Value> results) const;
+
   // Appends an instruction followed by space for `placeholder_count` values
   // which are left uninitialized. They may be initialized later via calls to
   // `Function<...>::set_value`. Returns the corresponding
@@ -198,34 +245,417 @@ struct Function : Function<> {
       D &d, Function const *f) {
     return nth::io::deserialize(d, static_cast<Function<> const *&>(f));
   }
+
+ private:
+  friend FunctionBuilder<Set>;
+
+  // Constructs a function whose instructions are those in `instructions`
+  // after the first, which is a placeholder (see `FunctionBuilder`).
+  explicit Function(uint32_t parameter_count, uint32_t return_count,
+                    std::vector<Value> instructions);
 };
 
 namespace internal {
 
-template <typename StateType>
-void FinishExecution(Value *value_stack_head, size_t vs_left, Value const *ip,
-                     FrameBase *call_stack, uint64_t cs_remaining) {
-  *(ip + 1)->as<Value **>() = value_stack_head;
-  *(ip + 2)->as<size_t *>() = vs_left;
-  nth::stack<Frame<StateType>>::reconstitute_from(
-      static_cast<Frame<StateType> *>(call_stack), cs_remaining);
+// Executed when the outermost frame returns, writing the state of the value
+// stack and call stack to the locations given by the immediate values
+// following `ip` so that `Invoke` may take ownership of them.
+inline void FinishExecution(Value *value_stack_head, size_t vs_left,
+                            Value const *ip, FrameBase *call_stack,
+                            uint64_t cs_remaining, CachedValue top) {
+  *(ip + 1)->as<Value **>()      = value_stack_head;
+  *(ip + 2)->as<size_t *>()      = vs_left;
+  *(ip + 3)->as<CachedValue *>() = top;
+  *(ip + 4)->as<FrameBase **>()  = call_stack;
+  *(ip + 5)->as<uint64_t *>()    = cs_remaining;
 }
 
-template <typename Set>
-constexpr void Invoke(nth::stack<Value> &value_stack, Value const *ip) {
+// With the top-of-stack cache enabled, moves the top of `value_stack` into
+// `cached`. Instructions refill the cache from beneath the top of the stack
+// whenever they pop, so there must always be a value there to cache, even once
+// the executing function has consumed every value it may. `reserved` indicates
+// whether `value_stack` already holds such a value beneath all those the
+// function may consume. If not, an uninitialized value is placed beneath all
+// others on `value_stack`, which requires moving every value on it, and `true`
+// is returned.
+inline bool MoveTopToCache(auto &, NoCachedValue &, bool) { return false; }
+inline bool MoveTopToCache(auto &value_stack, Value &cached, bool reserved) {
+  if (not reserved) {
+    value_stack.push(Value::Uninitialized());
+    std::span values = value_stack.top_span(value_stack.size());
+    std::rotate(values.begin(), values.end() - 1, values.end());
+  }
+  cached = value_stack.top();
+  value_stack.pop();
+  return not reserved;
+}
+
+// Reverses the effect of a call to `MoveTopToCache` which returned
+// `placeholder`.
+inline void MoveCacheToTop(auto &, NoCachedValue, bool) {}
+inline void MoveCacheToTop(auto &value_stack, Value cached, bool placeholder) {
+  value_stack.push(cached);
+  if (placeholder) {
+    std::span values = value_stack.top_span(value_stack.size());
+    std::rotate(values.begin(), values.begin() + 1, values.end());
+    value_stack.pop();
+  }
+}
+
+// Hands the storage of `value_stack` to executing instructions as a pointer
+// one past the top value and the number of values that fit before the stack
+// must grow, and later takes it back. `GuardedValueStack` provides its own
+// overloads.
+inline std::pair<Value *, size_t> ReleaseValueStack(
+    nth::stack<Value> &value_stack) {
+  return std::move(value_stack).release();
+}
+inline void RestoreValueStack(nth::stack<Value> &value_stack, Value *top,
+                              size_t remaining) {
+  value_stack = nth::stack<Value>::reconstitute_from(top, remaining);
+}
+
+// Executes the function whose first instruction is `ip` with arguments from
+// `value_stack` by tail-calls between instructions, using `call_stack` (which
+// must be empty) for storage of frames. Upon completion, `call_stack` is again
+// empty, but retains its capacity. `reserved` indicates whether `value_stack`
+// holds at least one value beneath the arguments (see `MoveTopToCache`).
+template <typename Set, typename ValueStack>
+void InvokeThreaded(ValueStack &value_stack,
+                    nth::stack<Frame<FunctionState<Set>>> &call_stack,
+                    Value const *ip, bool reserved = false) {
   using frame_type = Frame<FunctionState<Set>>;
-  nth::stack<frame_type> call_stack;
   call_stack.emplace();
 
+  CachedValue cached;
+  bool placeholder = MoveTopToCache(value_stack, cached, reserved);
+
+  auto [top, remaining] = ReleaseValueStack(value_stack);
+  FrameBase *cs_top;
+  uint64_t cs_remaining;
+  Value landing_pad[6] = {&FinishExecution, &top,    &remaining,
+                          &cached,          &cs_top, &cs_remaining};
+  call_stack.top().ip  = &landing_pad[0];
+  std::tie(cs_top, cs_remaining) = std::move(call_stack).release();
+
+  // This execution is not resumable, even if invoked from an instruction
+  // executing within one that is.
+  Suspension *suspension = std::exchange(active_suspension, nullptr);
+  {
+    SampledExecutionScope<frame_type> sampled(
+        static_cast<frame_type *>(cs_top) - 1);
+    ip->as<exec_fn_type>()(top, remaining, ip, cs_top, cs_remaining, cached);
+  }
+  active_suspension = suspension;
+  call_stack = nth::stack<frame_type>::reconstitute_from(
+      static_cast<frame_type *>(cs_top), cs_remaining);
+  RestoreValueStack(value_stack, top, remaining);
+  MoveCacheToTop(value_stack, cached, placeholder);
+}
+
+// Executes the function whose first instruction is `ip` with arguments from
+// `value_stack` by the dispatch loop (see "hop/core/internal/dispatch_loop.h"),
+// using `call_stack` (which must be empty) for storage of frames. Upon
+// completion, `call_stack` is again empty, but retains its capacity.
+template <typename Set, typename ValueStack>
+void InvokeDispatchLoop(ValueStack &value_stack,
+                        nth::stack<Frame<FunctionState<Set>>> &call_stack,
+                        Value const *ip) {
+  auto [top, remaining]  = ReleaseValueStack(value_stack);
+  Suspension *suspension = std::exchange(active_suspension, nullptr);
+  RunDispatchLoop<Set>(top, remaining, call_stack, ip);
+  active_suspension = suspension;
+  RestoreValueStack(value_stack, top, remaining);
+}
+
+// Executes the function whose first instruction is `ip` with arguments from
+// `value_stack`, using `call_stack` (which must be empty) for storage of frames.
+// Upon completion, `call_stack` is again empty, but retains its capacity. The
+// dispatch strategy is chosen by the `//hop/configuration:dispatch` flag.
+// `reserved` indicates whether `value_stack` holds at least one value beneath
+// the arguments (see `MoveTopToCache`).
+template <typename Set, typename ValueStack>
+void Invoke(ValueStack &value_stack,
+            nth::stack<Frame<FunctionState<Set>>> &call_stack, Value const *ip,
+            bool reserved = false) {
+  if constexpr (computed_goto) {
+    InvokeDispatchLoop<Set>(value_stack, call_stack, ip);
+  } else {
+    InvokeThreaded<Set>(value_stack, call_stack, ip, reserved);
+  }
+}
+
+template <typename Set, typename ValueStack>
+void Invoke(ValueStack &value_stack, Value const *ip, bool reserved) {
+  nth::stack<Frame<FunctionState<Set>>> call_stack;
+  Invoke<Set>(value_stack, call_stack, ip, reserved);
+}
+
+// Places `arguments` on the value stack whose head is `value_stack_head`. With
+// the top-of-stack cache enabled, the last argument is instead held in
+// `cached`, and a placeholder is placed beneath the arguments, exactly as
+// `MoveTopToCache` would arrange them.
+inline void PushArguments(Value *&value_stack_head, size_t &vs_left,
+                          std::span<Value const> arguments, NoCachedValue &) {
+  value_stack_head = std::copy(arguments.begin(), arguments.end(),
+                               value_stack_head);
+  vs_left -= arguments.size();
+}
+inline void PushArguments(Value *&value_stack_head, size_t &vs_left,
+                          std::span<Value const> arguments, Value &cached) {
+  *value_stack_head = Value::Uninitialized();
+  std::copy(arguments.begin(), arguments.end(), value_stack_head + 1);
+  cached = value_stack_head[arguments.size()];
+  value_stack_head += arguments.size();
+  vs_left -= arguments.size();
+}
+
+// Moves the top `results.size()` values from the value stack to `results`,
+// undoing the effect of a corresponding call to `PushArguments`.
+inline void PopResults(Value *&value_stack_head, size_t &vs_left,
+                       NoCachedValue, std::span<Value> results) {
+  value_stack_head -= results.size();
+  vs_left += results.size();
+  std::copy(value_stack_head, value_stack_head + results.size(),
+            results.begin());
+}
+inline void PopResults(Value *&value_stack_head, size_t &vs_left,
+                       Value cached, std::span<Value> results) {
+  if (results.empty()) { return; }
+  value_stack_head -= results.size();
+  vs_left += results.size();
+  std::copy(value_stack_head + 1, value_stack_head + results.size(),
+            results.begin());
+  results.back() = cached;
+}
+
+template <typename Set>
+void InvokeBatch(FunctionBase const &fn, std::span<Value const> arguments,
+                 std::span<Value> results) {
+  using frame_type  = Frame<FunctionState<Set>>;
+  size_t parameters = fn.parameter_count();
+  size_t returns    = fn.return_count();
+  size_t count      = parameters != 0 ? arguments.size() / parameters
+                      : returns != 0  ? results.size() / returns
+                                      : 0;
+  NTH_REQUIRE((harden), arguments.size() == count * parameters);
+  NTH_REQUIRE((harden), results.size() == count * returns);
+  if (count == 0) { return; }
+
+  nth::stack<Value> value_stack;
+  // Room for the arguments or results, the placeholder beneath them when the
+  // top-of-stack cache is enabled, and the function's own stack depth.
+  value_stack.reserve(1 + std::max<size_t>({parameters, returns,
+                                            fn.max_stack_depth()}));
+  nth::stack<frame_type> call_stack;
+  call_stack.reserve(1);
+
   auto [top, remaining] = std::move(value_stack).release();
-  Value landing_pad[5]  = {Value::Uninitialized(), Value::Uninitialized(),
-                           &FinishExecution<FunctionState<Set>>, &top,
-                           &remaining};
-  call_stack.top().ip   = &landing_pad[0];
+  CachedValue cached;
+  FrameBase *cs_top;
+  uint64_t cs_remaining;
+  std::tie(cs_top, cs_remaining) = std::move(call_stack).release();
+  Value landing_pad[6] = {&FinishExecution, &top,    &remaining,
+                          &cached,          &cs_top, &cs_remaining};
+
+  Suspension *suspension = std::exchange(active_suspension, nullptr);
+  Value const *entry     = fn.entry();
+  {
+    SampledExecutionScope<frame_type> sampled(
+        static_cast<frame_type *>(cs_top));
+    for (size_t i = 0; i < count; ++i) {
+      PushArguments(top, remaining,
+                    arguments.subspan(i * parameters, parameters), cached);
+      // Each invocation's outermost `Return` destroys the frame constructed
+      // here, leaving the call stack empty for the next.
+      auto *frame = new (static_cast<frame_type *>(cs_top)) frame_type;
+      frame->ip   = &landing_pad[0];
+      entry->as<exec_fn_type>()(top, remaining, entry, frame + 1,
+                                cs_remaining - 1, cached);
+      PopResults(top, remaining, cached,
+                 results.subspan(i * returns, returns));
+    }
+  }
+  active_suspension = suspension;
 
-  auto [cs_top, cs_remaining] = std::move(call_stack).release();
-  ip->as<exec_fn_type>()(top, remaining, ip, cs_top, cs_remaining);
-  value_stack = nth::stack<Value>::reconstitute_from(top, remaining);
+  nth::stack<frame_type>::reconstitute_from(static_cast<frame_type *>(cs_top),
+                                            cs_remaining);
+  nth::stack<Value>::reconstitute_from(top, remaining);
+}
+
+// Describes how an instruction changes the height of the value stack, for the
+// purpose of computing a function's maximum stack depth.
+struct DepthEffect {
+  enum Kind : uint8_t {
+    // The effect is described entirely by `max_growth` and `net`.
+    Static,
+    // The effect is given by the `InstructionSpecification` immediate value.
+    Determined,
+    // A call whose `InstructionSpecification` immediate value describes the
+    // arguments and returns, with the callee taken from the stack.
+    Call,
+    // A call whose `InstructionSpecification` immediate value describes the
+    // arguments and returns, with the callee held as an immediate value.
+    CallDirect,
+    // A `Switch`, which continues at the target of each entry of the jump
+    // table following it.
+    Switch,
+    // Execution of the function does not continue past this instruction.
+    Terminal,
+  } kind;
+  bool consumes_input;
+  bool falls_through;
+  // The number of values which must be present on the stack beforehand. Not
+  // meaningful for `Determined`, `Call`, `CallDirect` or `Terminal` effects,
+  // whose requirements depend on their `InstructionSpecification`.
+  ptrdiff_t required;
+  ptrdiff_t max_growth;
+  ptrdiff_t net;
+  // The index, relative to the op-code, of the immediate value holding a
+  // relative jump offset, or zero if the instruction does not jump.
+  size_t jump_index;
+  size_t immediate_value_count;
+  // The variant of the instruction which does not check capacity.
+  exec_fn_type unchecked;
+};
+
+template <typename Set>
+absl::flat_hash_map<exec_fn_type, DepthEffect> const &DepthEffects() {
+  static nth::indestructible<absl::flat_hash_map<exec_fn_type, DepthEffect>>
+      effects = [] {
+        absl::flat_hash_map<exec_fn_type, DepthEffect> effects;
+        Set::instructions.each([&](auto t) {
+          using T = nth::type_t<t>;
+          DepthEffect effect{
+              .kind                  = DepthEffect::Static,
+              .consumes_input        = false,
+              .falls_through         = true,
+              .required              = 0,
+              .max_growth            = 0,
+              .net                   = 0,
+              .jump_index            = 0,
+              .immediate_value_count = ImmediateValueCount<T>(),
+              .unchecked             = &T::template ExecuteImpl<Set, false>,
+          };
+          if constexpr (nth::any_of<T, Return, TailCall>) {
+            effect.kind = DepthEffect::Terminal;
+          } else if constexpr (nth::type<T> == nth::type<Call>) {
+            effect.kind = DepthEffect::Call;
+          } else if constexpr (nth::type<T> == nth::type<CallDirect>) {
+            effect.kind = DepthEffect::CallDirect;
+          } else if constexpr (nth::type<T> == nth::type<Switch>) {
+            effect.kind          = DepthEffect::Switch;
+            effect.falls_through = false;
+            effect.required      = 1;
+            effect.net           = -1;
+          } else if constexpr (nth::type<T> == nth::type<Yield>) {
+            // `Yield` is treated as leaving the stack unchanged, though the
+            // host may change it while the function is suspended. For this
+            // reason, functions containing `Yield` are never finalized.
+          } else if constexpr (nth::type<T> == nth::type<Jump>) {
+            effect.falls_through = false;
+            effect.jump_index    = 1;
+          } else if constexpr (nth::any_of<T, JumpIf, JumpIfNot>) {
+            effect.required   = 1;
+            effect.net        = -1;
+            effect.jump_index = 1;
+          } else if constexpr (FusedInstruction<T>()) {
+            constexpr StackEffect e = FusedStackEffect<T>();
+            constexpr auto fused    = T::fused_instructions;
+            using Last = nth::type_t<fused.template get<fused.size() - 1>()>;
+            effect.required      = e.required;
+            effect.max_growth    = e.max_growth;
+            effect.net           = e.net;
+            effect.falls_through = nth::type<Last> != nth::type<Jump>;
+            if constexpr (nth::any_of<Last, Jump, JumpIf, JumpIfNot>) {
+              effect.jump_index = ImmediateValueCount<T>();
+            }
+          } else if constexpr (ImmediateValueDetermined<T>()) {
+            effect.kind           = DepthEffect::Determined;
+            effect.consumes_input = ConsumesInput<T>();
+          } else {
+            ptrdiff_t in      = ParameterCount<T>();
+            ptrdiff_t out     = ReturnCount<T>();
+            effect.required   = in;
+            effect.net        = out - (ConsumesInput<T>() ? in : 0);
+            effect.max_growth = std::max<ptrdiff_t>(effect.net, 0);
+          }
+          effects.emplace(&T::template ExecuteImpl<Set>, effect);
+          effects.emplace(&T::template ExecuteImpl<Set, false>, effect);
+        });
+        return effects;
+      }();
+  return *effects;
+}
+
+// Returns the maximum number of values, including the `parameter_count`
+// parameters, held on the value stack at once by any execution of the
+// function whose instructions are `insts`. When the top-of-stack cache is
+// enabled, one extra value is accounted for, as immediate-value-determined
+// instructions spill the cached value.
+template <typename Set>
+uint32_t MaxStackDepth(std::span<Value const> insts, uint32_t parameter_count) {
+  auto const &effects = DepthEffects<Set>();
+  // The stack height on entry to each instruction, or -1 if the instruction
+  // has not yet been reached.
+  std::vector<ptrdiff_t> heights(insts.size(), -1);
+  std::vector<size_t> worklist;
+  ptrdiff_t max_depth = parameter_count;
+  auto reach          = [&](size_t index, ptrdiff_t height) {
+    NTH_REQUIRE((harden), index < insts.size());
+    if (heights[index] == -1) {
+      heights[index] = height;
+      worklist.push_back(index);
+    } else {
+      NTH_REQUIRE((harden), heights[index] == height);
+    }
+  };
+  if (not insts.empty()) { reach(0, parameter_count); }
+
+  while (not worklist.empty()) {
+    size_t index = worklist.back();
+    worklist.pop_back();
+    ptrdiff_t height          = heights[index];
+    DepthEffect const &effect = effects.at(insts[index].as<exec_fn_type>());
+
+    ptrdiff_t peak = height + effect.max_growth;
+    ptrdiff_t next = height + effect.net;
+    switch (effect.kind) {
+      case DepthEffect::Static: break;
+      case DepthEffect::Determined: {
+        auto spec = insts[index + 1].as<InstructionSpecification>();
+        peak      = height + spec.returns;
+        next      = height + spec.returns -
+               (effect.consumes_input ? spec.parameters : 0);
+      } break;
+      case DepthEffect::Call: {
+        auto spec = insts[index + 1].as<InstructionSpecification>();
+        next      = height - 1 - spec.parameters + spec.returns;
+      } break;
+      case DepthEffect::CallDirect: {
+        auto spec = insts[index + 1].as<InstructionSpecification>();
+        next      = height - spec.parameters + spec.returns;
+      } break;
+      case DepthEffect::Switch: {
+        // The jump table entries are only reached via the `Switch`, with the
+        // key already popped.
+        size_t count = insts[index + 2].as<size_t>();
+        for (size_t i = 0; i <= count; ++i) {
+          reach(index + 3 + 2 * i, next);
+        }
+      } break;
+      case DepthEffect::Terminal: continue;
+    }
+    max_depth = std::max({max_depth, peak, next});
+
+    if (effect.jump_index != 0) {
+      reach(index + insts[index + effect.jump_index].as<ptrdiff_t>(), next);
+    }
+    if (effect.falls_through) {
+      reach(index + 1 + effect.immediate_value_count, next);
+    }
+  }
+  return static_cast<uint32_t>(max_depth) + cache_top_of_stack;
 }
 
 }  // namespace internal
@@ -233,18 +663,54 @@ constexpr void Invoke(nth::stack<Value> &value_stack, Value const *ip) {
 template <typename Set>
 Function<Set>::Function(uint32_t parameter_count, uint32_t return_count)
     : Function<>(parameter_count, return_count,
-                 internal::Invoke<instruction_set>) {}
+                 internal::Invoke<instruction_set, nth::stack<Value>>,
+                 internal::Invoke<instruction_set, GuardedValueStack>) {}
+
+template <typename Set>
+Function<Set>::Function(uint32_t parameter_count, uint32_t return_count,
+                        std::vector<Value> instructions)
+    : Function<>(parameter_count, return_count,
+                 internal::Invoke<instruction_set, nth::stack<Value>>,
+                 internal::Invoke<instruction_set, GuardedValueStack>,
+                 std::move(instructions)) {}
 
 template <typename Set>
 Function<Set>::Function()
-    : Function<>(0, 0, internal::Invoke<instruction_set>) {}
+    : Function<>(0, 0, internal::Invoke<instruction_set, nth::stack<Value>>,
+                 internal::Invoke<instruction_set, GuardedValueStack>) {}
+
+template <typename Set>
+void Function<Set>::invoke_batch(std::span<Value const> arguments,
+                                 std::span<Value> results) const {
+  internal::InvokeBatch<Set>(*this, arguments, results);
+}
+
+template <typename Set>
+void Function<Set>::finalize() {
+  std::span insts     = raw_instructions();
+  auto const &effects = internal::DepthEffects<Set>();
+  internal::exec_fn_type yield = &Yield::ExecuteImpl<Set>;
+  for (size_t index = 0; index < insts.size();) {
+    auto op = insts[index].as<internal::exec_fn_type>();
+    if (op == yield) { return; }
+    index += 1 + effects.at(op).immediate_value_count;
+  }
+
+  set_max_stack_depth(internal::MaxStackDepth<Set>(insts, parameter_count()));
+  size_t index = 0;
+  while (index < insts.size()) {
+    auto const &effect = effects.at(insts[index].as<internal::exec_fn_type>());
+    insts[index]       = effect.unchecked;
+    index += 1 + effect.immediate_value_count;
+  }
+}
 
 template <typename Set>
 template <typename I>
 requires(Set::instructions.template contains<nth::type<I>>())  //
     constexpr nth::interval<InstructionIndex> Function<Set>::append(
         auto... vs) {
-  if constexpr (nth::type<I> == nth::type<Return>) {
+  if constexpr (nth::any_of<I, Return, Yield>) {
     return internal::FunctionBase::append({&I::template ExecuteImpl<Set>});
   } else if constexpr (nth::type<I> == nth::type<hop::Jump>) {
     static_assert(sizeof...(vs) == 0);
@@ -253,6 +719,19 @@ requires(Set::instructions.template contains<nth::type<I>>())  //
     static_assert(sizeof...(vs) == 1);
     return internal::FunctionBase::append(
         {&I::template ExecuteImpl<Set>, static_cast<size_t>(vs)...});
+  } else if constexpr (nth::type<I> == nth::type<hop::Switch>) {
+    return internal::ImmediateValueTypes<I>().reduce([&](auto... ts) {
+      static_assert(sizeof...(vs) == sizeof...(ts));
+      return internal::FunctionBase::append(
+          {&I::template ExecuteImpl<Set>,
+           Value(static_cast<nth::type_t<ts>>(vs))...});
+    });
+  } else if constexpr (internal::FusedInstruction<I>()) {
+    return internal::ImmediateValueTypes<I>().reduce([&](auto... ts) {
+      return internal::FunctionBase::append(
+          {&I::template ExecuteImpl<Set>,
+           Value(static_cast<nth::type_t<ts>>(vs))...});
+    });
   } else {
     constexpr size_t DropCount = internal::HasFunctionState<I> ? 3 : 2;
     return internal::InstructionFunctionType<I>()
@@ -299,12 +778,32 @@ InstructionSerializer(
     S s, std::span<Value const> v) requires std::is_lvalue_reference_v<S> {
   using result_type =
       nth::io::serializer_result_type<std::remove_reference_t<S>>;
-  if constexpr (nth::type<I> == nth::type<Return>) {
+  if constexpr (nth::any_of<I, Return, Yield>) {
     return result_type(true);
-  } else if constexpr (nth::type<I> == nth::type<Call>) {
+  } else if constexpr (nth::any_of<I, Call, TailCall>) {
     return nth::io::serialize(s, v[0].as<InstructionSpecification>());
+  } else if constexpr (nth::type<I> == nth::type<CallDirect>) {
+    result_type result =
+        nth::io::serialize(s, v[0].as<InstructionSpecification>());
+    if (not result) { return result; }
+    return nth::io::serialize(s, v[1].as<Function<> const *>());
   } else if constexpr (nth::any_of<I, Jump, JumpIf, JumpIfNot>) {
     return result_type(nth::format_integer(s, v[0].as<ptrdiff_t>()));
+  } else if constexpr (nth::type<I> == nth::type<Switch>) {
+    if (not nth::format_integer(s, v[0].as<uint64_t>())) {
+      return result_type(false);
+    }
+    return result_type(nth::format_integer(s, v[1].as<size_t>()));
+  } else if constexpr (internal::FusedInstruction<I>()) {
+    return internal::ImmediateValueTypes<I>().reduce([&](auto... ts) {
+      size_t i = 0;
+      result_type result(true);
+      (void)(static_cast<bool>(
+                 result = nth::io::serialize(
+                     s, v[i++].template as<nth::type_t<ts>>())) and
+             ...);
+      return result;
+    });
   } else {
     constexpr auto params = [] {
       if constexpr (requires { I::execute; }) {
@@ -333,20 +832,48 @@ InstructionDeserializer(D d,
                         Function<> &fn) requires std::is_lvalue_reference_v<D> {
   using result_type =
       nth::io::deserializer_result_type<std::remove_reference_t<D>>;
-  if constexpr (nth::type<I> == nth::type<Return>) {
+  if constexpr (nth::any_of<I, Return, Yield>) {
     return result_type(true);
-  } else if constexpr (nth::type<I> == nth::type<Call>) {
+  } else if constexpr (nth::any_of<I, Call, TailCall>) {
     InstructionSpecification spec;
     result_type result = nth::io::deserialize(d, spec);
     if (not result) { return result; }
     fn.raw_append(spec);
     return result_type(true);
-  } else if constexpr (nth::type<I> == nth::type<Jump> or
-                       nth::type<I> == nth::type<JumpIf>) {
+  } else if constexpr (nth::type<I> == nth::type<CallDirect>) {
+    InstructionSpecification spec;
+    result_type result = nth::io::deserialize(d, spec);
+    if (not result) { return result; }
+    Function<> const *callee;
+    result = nth::io::deserialize(d, callee);
+    if (not result) { return result; }
+    fn.raw_append(spec);
+    fn.raw_append(callee);
+    return result_type(true);
+  } else if constexpr (nth::any_of<I, Jump, JumpIf, JumpIfNot>) {
     ptrdiff_t amount;
     if (not nth::io::read_integer(d, amount)) { return result_type(false); }
     fn.raw_append(amount);
     return result_type(true);
+  } else if constexpr (nth::type<I> == nth::type<Switch>) {
+    uint64_t minimum;
+    size_t count;
+    if (not nth::io::read_integer(d, minimum)) { return result_type(false); }
+    if (not nth::io::read_integer(d, count)) { return result_type(false); }
+    fn.raw_append(minimum);
+    fn.raw_append(count);
+    return result_type(true);
+  } else if constexpr (internal::FusedInstruction<I>()) {
+    return internal::ImmediateValueTypes<I>().reduce([&](auto... ts) {
+      return ([&](auto t) {
+        nth::type_t<t> value;
+        result_type result = nth::io::deserialize(d, value);
+        if (not result) { return result; }
+        fn.raw_append(value);
+        return result_type(true);
+      }(ts) and
+              ...);
+    });
   } else {
     constexpr bool HasFunctionState = internal::HasFunctionState<I>;
     constexpr auto parameters =
@@ -0,0 +1,211 @@
+#ifndef JASMIN_CORE_FUNCTION_BUILDER_H
+#define JASMIN_CORE_FUNCTION_BUILDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "hop/core/function.h"
+#include "hop/core/instruction.h"
+#include "hop/core/internal/instruction_traits.h"
+#include "hop/core/value.h"
+#include "nth/debug/debug.h"
+#include "nth/meta/type.h"
+
+namespace hop {
+
+// A `FunctionBuilder` constructs a `Function<Set>` whose jumps are expressed in
+// terms of labels rather than relative offsets. Instructions are appended to a
+// buffer owned by the builder which may be sized ahead of time, and jump
+// offsets are resolved once, by `finalize`, after every label has been bound.
+// The buffer is then handed to the function rather than copied.
+//
+// Example:
+// ```
+// FunctionBuilder<Set> builder(1, 1);
+// auto done = builder.label();
+// builder.append<IsZero>();
+// builder.append<JumpIf>(done);
+// builder.append<Decrement>();
+// builder.bind(done);
+// builder.append<Return>();
+// Function<Set> f = std::move(builder).finalize();
+// ```
+template <InstructionSetType Set>
+struct FunctionBuilder {
+  // Identifies a position in the function being built, which may be the
+  // target of jumps appended before or after the label is bound.
+  struct Label {
+   private:
+    friend FunctionBuilder;
+    explicit constexpr Label(uint32_t n) : index_(n) {}
+    uint32_t index_;
+  };
+
+  // Constructs a builder for a function accepting `parameter_count`
+  // parameters and returning `return_count` values, with room for `capacity`
+  // op-codes and immediate values before its buffer must grow.
+  explicit FunctionBuilder(uint32_t parameter_count, uint32_t return_count,
+                           size_t capacity = 0)
+      : parameter_count_(parameter_count), return_count_(return_count) {
+    values_.reserve(capacity + 1);
+    values_.push_back(Value::Uninitialized());
+  }
+
+  // Returns a new label which is not yet bound to any position.
+  Label label() {
+    positions_.push_back(Unbound);
+    return Label(static_cast<uint32_t>(positions_.size() - 1));
+  }
+
+  // Binds `l` to the position at which the next instruction will be appended.
+  // Each label must be bound exactly once.
+  void bind(Label l) {
+    NTH_REQUIRE((harden), positions_[l.index_] == Unbound);
+    positions_[l.index_] = values_.size();
+  }
+
+  // Returns a new label bound to the position at which the next instruction
+  // will be appended.
+  Label bound_label() {
+    Label l = label();
+    bind(l);
+    return l;
+  }
+
+  // Appends the instruction `I` with immediate values `vs`.
+  template <typename I>
+  requires(Set::instructions.template contains<nth::type<I>>() and
+           not nth::any_of<I, Jump, JumpIf, JumpIfNot, Switch>)  //
+      void append(auto... vs);
+
+  // Appends the instruction `I`, which must accept an
+  // `InstructionSpecification`, with immediate values `spec` and `vs`.
+  template <typename I>
+  requires(Set::instructions.template contains<nth::type<I>>())  //
+      void append(InstructionSpecification spec, auto... vs);
+
+  // Appends the jump instruction `I` whose target is the position to which
+  // `target` is bound.
+  template <typename I>
+  requires(nth::any_of<I, Jump, JumpIf, JumpIfNot>)  //
+      void append(Label target);
+
+  // Appends a `Switch` instruction along with its jump table, such that a key
+  // of `minimum + i` continues at `cases[i]` and any other key continues at
+  // `otherwise`.
+  template <typename I>
+  requires(nth::type<I> == nth::type<Switch>)  //
+      void append(uint64_t minimum, std::span<Label const> cases,
+                  Label otherwise);
+
+  // Returns the number of op-codes and immediate values appended so far.
+  size_t size() const { return values_.size() - 1; }
+
+  // Resolves the offset of every jump and returns a function holding exactly
+  // the appended instructions, which takes over the builder's buffer. The
+  // buffer is only reallocated if more capacity was reserved than used.
+  // Requires that every label targeted by a jump has been bound. The returned
+  // function has not been finalized (see `Function<Set>::finalize`), so that
+  // it may still be transformed.
+  Function<Set> finalize() &&;
+
+ private:
+  static constexpr size_t Unbound = std::numeric_limits<size_t>::max();
+
+  // A jump whose offset is to be resolved by `finalize`.
+  struct Fixup {
+    // The index of the op-code of the jump.
+    size_t jump;
+    uint32_t label;
+  };
+
+  void append_jump(internal::exec_fn_type op_code, Label target) {
+    fixups_.push_back({.jump = values_.size(), .label = target.index_});
+    values_.push_back(op_code);
+    values_.push_back(Value::Uninitialized());
+  }
+
+  // The appended op-codes and immediate values, preceded by a placeholder
+  // which the function built from them uses internally. Positions and jump
+  // indices below are indices into this vector, so they include the
+  // placeholder, which cancels out of every jump offset.
+  std::vector<Value> values_;
+  // The position to which each label is bound, or `Unbound`.
+  std::vector<size_t> positions_;
+  std::vector<Fixup> fixups_;
+  uint32_t parameter_count_;
+  uint32_t return_count_;
+};
+
+template <InstructionSetType Set>
+template <typename I>
+requires(Set::instructions.template contains<nth::type<I>>() and
+         not nth::any_of<I, Jump, JumpIf, JumpIfNot, Switch>)  //
+    void FunctionBuilder<Set>::append(auto... vs) {
+  values_.push_back(&I::template ExecuteImpl<Set>);
+  if constexpr (nth::any_of<I, Return, Yield>) {
+    static_assert(sizeof...(vs) == 0);
+  } else {
+    internal::ImmediateValueTypes<I>().reduce([&](auto... ts) {
+      static_assert(sizeof...(vs) == sizeof...(ts));
+      (values_.push_back(Value(static_cast<nth::type_t<ts>>(vs))), ...);
+    });
+  }
+}
+
+template <InstructionSetType Set>
+template <typename I>
+requires(Set::instructions.template contains<nth::type<I>>())  //
+    void FunctionBuilder<Set>::append(InstructionSpecification spec,
+                                      auto... vs) {
+  constexpr size_t DropCount = internal::HasFunctionState<I> ? 3 : 2;
+  values_.push_back(&I::template ExecuteImpl<Set>);
+  values_.push_back(spec);
+  internal::InstructionFunctionType<I>()
+      .parameters()
+      .template drop<DropCount>()
+      .reduce([&](auto... ts) {
+        static_assert(sizeof...(vs) == sizeof...(ts));
+        (values_.push_back(Value(static_cast<nth::type_t<ts>>(vs))), ...);
+      });
+}
+
+template <InstructionSetType Set>
+template <typename I>
+requires(nth::any_of<I, Jump, JumpIf, JumpIfNot>)  //
+    void FunctionBuilder<Set>::append(Label target) {
+  append_jump(&I::template ExecuteImpl<Set>, target);
+}
+
+template <InstructionSetType Set>
+template <typename I>
+requires(nth::type<I> == nth::type<Switch>)  //
+    void FunctionBuilder<Set>::append(uint64_t minimum,
+                                      std::span<Label const> cases,
+                                      Label otherwise) {
+  values_.push_back(&Switch::ExecuteImpl<Set>);
+  values_.push_back(minimum);
+  values_.push_back(cases.size());
+  for (Label l : cases) { append_jump(&Jump::ExecuteImpl<Set>, l); }
+  append_jump(&Jump::ExecuteImpl<Set>, otherwise);
+}
+
+template <InstructionSetType Set>
+Function<Set> FunctionBuilder<Set>::finalize() && {
+  for (auto [jump, label] : fixups_) {
+    size_t position = positions_[label];
+    NTH_REQUIRE((harden), position != Unbound);
+    values_[jump + 1] = static_cast<ptrdiff_t>(position) -
+                        static_cast<ptrdiff_t>(jump);
+  }
+  values_.shrink_to_fit();
+  return Function<Set>(parameter_count_, return_count_, std::move(values_));
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_CORE_FUNCTION_BUILDER_H
@@ -0,0 +1,117 @@
+#include "hop/core/function_builder.h"
+
+#include <utility>
+#include <vector>
+
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+struct PushU64 : Instruction<PushU64> {
+  static constexpr void execute(Input<>, Output<uint64_t> out, uint64_t n) {
+    out.set<0>(n);
+  }
+};
+
+struct IsZero : Instruction<IsZero> {
+  static constexpr void execute(Input<uint64_t> in, Output<bool> out) {
+    out.set<0>(in.get<0>() == 0);
+  }
+};
+
+struct Decrement : Instruction<Decrement> {
+  static constexpr void consume(Input<uint64_t> in, Output<uint64_t> out) {
+    out.set<0>(in.get<0>() - 1);
+  }
+};
+
+struct Drop : Instruction<Drop> {
+  static constexpr void consume(Input<uint64_t>, Output<>) {}
+};
+
+using Instructions = MakeInstructionSet<PushU64, IsZero, Decrement, Drop>;
+
+NTH_TEST("function-builder/straight-line") {
+  FunctionBuilder<Instructions> builder(0, 1);
+  builder.append<PushU64>(3);
+  builder.append<Decrement>();
+  builder.append<Return>();
+  NTH_EXPECT(builder.size() == size_t{4});
+
+  Function<Instructions> f = std::move(builder).finalize();
+  NTH_EXPECT(f.raw_instructions().size() == size_t{4});
+  nth::stack<Value> stack;
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{2});
+}
+
+NTH_TEST("function-builder/labels") {
+  // Counts its argument down to zero.
+  FunctionBuilder<Instructions> builder(1, 1, 16);
+  auto done = builder.label();
+  auto loop = builder.bound_label();
+  builder.append<IsZero>();
+  builder.append<JumpIf>(done);
+  builder.append<Decrement>();
+  builder.append<Jump>(loop);
+  builder.bind(done);
+  builder.append<Return>();
+
+  Function<Instructions> f = std::move(builder).finalize();
+  NTH_ASSERT(f.raw_instructions().size() == size_t{7});
+  NTH_EXPECT(f.raw_instructions()[2].as<ptrdiff_t>() == ptrdiff_t{5});
+  NTH_EXPECT(f.raw_instructions()[5].as<ptrdiff_t>() == ptrdiff_t{-4});
+
+  nth::stack<Value> stack = {uint64_t{10}};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{0});
+}
+
+NTH_TEST("function-builder/switch") {
+  // Maps 5 to 50, 6 to 60, and every other key to 0.
+  FunctionBuilder<Instructions> builder(1, 1);
+  std::vector cases = {builder.label(), builder.label()};
+  auto otherwise    = builder.label();
+  builder.append<Switch>(5, cases, otherwise);
+  for (uint64_t n : {50, 60}) {
+    builder.bind(cases[n / 10 - 5]);
+    builder.append<PushU64>(n);
+    builder.append<Return>();
+  }
+  builder.bind(otherwise);
+  builder.append<PushU64>(0);
+  builder.append<Return>();
+
+  Function<Instructions> f = std::move(builder).finalize();
+  uint64_t expected[] = {0, 50, 60, 0};
+  for (uint64_t i = 0; i < 4; ++i) {
+    nth::stack<Value> stack = {i + 4};
+    f.invoke(stack);
+    NTH_ASSERT(stack.size() == size_t{1});
+    NTH_EXPECT(stack.top().as<uint64_t>() == expected[i]);
+  }
+}
+
+NTH_TEST("function-builder/finalize") {
+  FunctionBuilder<Instructions> builder(1, 0);
+  auto end = builder.label();
+  builder.append<Jump>(end);
+  builder.append<PushU64>(1);
+  builder.bind(end);
+  builder.append<Drop>();
+  builder.append<Return>();
+
+  Function<Instructions> f = std::move(builder).finalize();
+  f.finalize();
+  NTH_EXPECT(f.max_stack_depth() == 1u + internal::cache_top_of_stack);
+  nth::stack<Value> stack = {uint64_t{1}};
+  f.invoke(stack);
+  NTH_EXPECT(stack.empty());
+}
+
+}  // namespace
+}  // namespace hop
@@ -1,5 +1,8 @@
 #include "hop/core/function.h"
 
+#include <vector>
+
+#include "nth/container/stack.h"
 #include "nth/test/test.h"
 
 namespace hop {
@@ -15,8 +18,63 @@ struct ImmediateDetermined : hop::Instruction<ImmediateDetermined> {
   static constexpr void execute(std::span<Value>, std::span<Value>, int) {}
 };
 
+struct DropBool : hop::Instruction<DropBool> {
+  static constexpr void consume(Input<bool>, Output<>) {}
+};
+
+struct Not : hop::Instruction<Not> {
+  static constexpr void consume(Input<bool> in, Output<bool> out) {
+    out.set<0>(not in.get<0>());
+  }
+};
+
+struct IsZero : hop::Instruction<IsZero> {
+  static constexpr void execute(Input<uint64_t> in, Output<bool> out) {
+    out.set<0>(in.get<0>() == 0);
+  }
+};
+
+struct Decrement : hop::Instruction<Decrement> {
+  static constexpr void consume(Input<uint64_t> in, Output<uint64_t> out) {
+    out.set<0>(in.get<0>() - 1);
+  }
+};
+
+struct PushFunction : hop::Instruction<PushFunction> {
+  static constexpr void execute(Input<>, Output<Function<> const *> out,
+                                Function<> const *f) {
+    out.set<0>(f);
+  }
+};
+
+struct PushU64 : hop::Instruction<PushU64> {
+  static constexpr void execute(Input<>, Output<uint64_t> out, uint64_t n) {
+    out.set<0>(n);
+  }
+};
+
 using Instructions =
-    hop::MakeInstructionSet<PushImmediateBool, ImmediateDetermined>;
+    hop::MakeInstructionSet<PushImmediateBool, ImmediateDetermined, DropBool,
+                            Not, IsZero, Decrement, PushFunction, PushU64>;
+
+// Maps 3 to 10, 4 to 20, 6 to 30, and every other key to 0.
+void BuildSwitch(hop::Function<Instructions> &f) {
+  f.append<Switch>(3, 4);
+  std::vector<nth::interval<InstructionIndex>> table;
+  for (int i = 0; i < 5; ++i) {
+    table.push_back(f.append_with_placeholders<Jump>());
+  }
+  std::vector<nth::interval<InstructionIndex>> cases;
+  for (uint64_t n : {10, 20, 30, 0}) {
+    cases.push_back(f.append<PushU64>(n));
+    f.append<Return>();
+  }
+  size_t targets[] = {0, 1, 3, 2, 3};
+  for (size_t i = 0; i < 5; ++i) {
+    f.set_value(table[i], 0,
+                cases[targets[i]].lower_bound() - table[i].lower_bound());
+  }
+}
 
 NTH_TEST("function/append-incorrect-type") {
   bool converted = false;
@@ -41,5 +99,168 @@ NTH_TEST("function/append-incorrect-type") {
   NTH_EXPECT(converted);
 }
 
+NTH_TEST("function/invoke-empties-stack") {
+  hop::Function<Instructions> func(1, 2);
+  func.append<DropBool>();
+  func.append<PushImmediateBool>(false);
+  func.append<ImmediateDetermined>({.parameters = 1, .returns = 0}, 1);
+  func.append<PushImmediateBool>(true);
+  func.append<Return>();
+
+  nth::stack<Value> stack = {true};
+  func.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{2});
+  NTH_EXPECT(stack.top_span(2)[0].as<bool>() == false);
+  NTH_EXPECT(stack.top_span(2)[1].as<bool>() == true);
+
+  nth::stack<Value> deeper = {3, true};
+  func.invoke(deeper);
+  NTH_ASSERT(deeper.size() == size_t{3});
+  NTH_EXPECT(deeper.top_span(3)[0].as<int>() == 3);
+  NTH_EXPECT(deeper.top_span(3)[1].as<bool>() == false);
+  NTH_EXPECT(deeper.top_span(3)[2].as<bool>() == true);
+}
+
+NTH_TEST("function/call-direct") {
+  hop::Function<Instructions> g(1, 1);
+  g.append<Not>();
+  g.append<Return>();
+
+  hop::Function<Instructions> f(1, 2);
+  f.append<CallDirect>({.parameters = 1, .returns = 1}, &g);
+  f.append<PushImmediateBool>(true);
+  f.append<CallDirect>({.parameters = 1, .returns = 1}, &g);
+  f.append<Return>();
+  NTH_EXPECT(f.raw_instructions().size() == size_t{9});
+
+  nth::stack<Value> stack = {true};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{2});
+  NTH_EXPECT(stack.top_span(2)[0].as<bool>() == false);
+  NTH_EXPECT(stack.top_span(2)[1].as<bool>() == false);
+}
+
+NTH_TEST("function/tail-call") {
+  hop::Function<Instructions> f(1, 1);
+  f.append<IsZero>();
+  auto jump = f.append_with_placeholders<JumpIf>();
+  f.append<Decrement>();
+  f.append<PushFunction>(&f);
+  f.append<TailCall>({.parameters = 1, .returns = 1});
+  auto ret = f.append<Return>();
+  f.set_value(jump, 0, ret.lower_bound() - jump.lower_bound());
+
+  // Deep enough that the call stack would need to be reallocated many times
+  // were each call to push a new frame.
+  nth::stack<Value> stack = {uint64_t{1'000'000}};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{0});
+}
+
+NTH_TEST("function/finalize") {
+  hop::Function<Instructions> g(1, 1);
+  g.append<Not>();
+  g.append<Return>();
+  g.finalize();
+  NTH_EXPECT(g.max_stack_depth() == 1u + internal::cache_top_of_stack);
+
+  hop::Function<Instructions> f(1, 2);
+  f.append<CallDirect>({.parameters = 1, .returns = 1}, &g);
+  f.append<PushImmediateBool>(true);
+  f.append<CallDirect>({.parameters = 1, .returns = 1}, &g);
+  f.append<Return>();
+  NTH_EXPECT(f.max_stack_depth() == 0u);
+  f.finalize();
+  NTH_EXPECT(f.max_stack_depth() == 2u + internal::cache_top_of_stack);
+
+  nth::stack<Value> stack = {true};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{2});
+  NTH_EXPECT(stack.top_span(2)[0].as<bool>() == false);
+  NTH_EXPECT(stack.top_span(2)[1].as<bool>() == false);
+}
+
+NTH_TEST("function/finalize-branches") {
+  hop::Function<Instructions> f(1, 1);
+  f.append<IsZero>();
+  auto jump = f.append_with_placeholders<JumpIf>();
+  f.append<Decrement>();
+  f.append<PushFunction>(&f);
+  f.append<TailCall>({.parameters = 1, .returns = 1});
+  auto ret = f.append<Return>();
+  f.set_value(jump, 0, ret.lower_bound() - jump.lower_bound());
+  f.finalize();
+  NTH_EXPECT(f.max_stack_depth() == 2u + internal::cache_top_of_stack);
+
+  nth::stack<Value> stack = {uint64_t{1000}};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{0});
+}
+
+NTH_TEST("function/switch") {
+  hop::Function<Instructions> f(1, 1);
+  BuildSwitch(f);
+
+  uint64_t expected[] = {0, 0, 0, 10, 20, 0, 30, 0, 0};
+  for (uint64_t key = 0; key < std::size(expected); ++key) {
+    nth::stack<Value> stack = {key};
+    f.invoke(stack);
+    NTH_ASSERT(stack.size() == size_t{1});
+    NTH_EXPECT(stack.top().as<uint64_t>() == expected[key]);
+  }
+
+  nth::stack<Value> stack = {~uint64_t{0}};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{0});
+}
+
+NTH_TEST("function/finalize-switch") {
+  hop::Function<Instructions> f(1, 1);
+  BuildSwitch(f);
+  f.finalize();
+  NTH_EXPECT(f.max_stack_depth() == 1u + internal::cache_top_of_stack);
+
+  nth::stack<Value> stack = {uint64_t{6}};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{30});
+}
+
+NTH_TEST("function/invoke-batch") {
+  hop::Function<Instructions> f(1, 2);
+  f.append<IsZero>();
+  f.append<Return>();
+
+  std::vector<Value> arguments = {uint64_t{0}, uint64_t{3}, uint64_t{0}};
+  std::vector<Value> results(6, Value::Uninitialized());
+  f.invoke_batch(arguments, results);
+  for (size_t i = 0; i < 3; ++i) {
+    NTH_EXPECT(results[2 * i].as<uint64_t>() == arguments[i].as<uint64_t>());
+    NTH_EXPECT(results[2 * i + 1].as<bool>() ==
+               (arguments[i].as<uint64_t>() == 0));
+  }
+}
+
+NTH_TEST("function/guarded-invoke") {
+  hop::Function<Instructions> g(1, 1);
+  g.append<Not>();
+  g.append<Return>();
+
+  hop::Function<Instructions> f(1, 2);
+  f.append<CallDirect>({.parameters = 1, .returns = 1}, &g);
+  f.append<PushImmediateBool>(true);
+  f.append<CallDirect>({.parameters = 1, .returns = 1}, &g);
+  f.append<Return>();
+
+  GuardedValueStack stack = {true};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{2});
+  NTH_EXPECT(stack.top_span(2)[0].as<bool>() == false);
+  NTH_EXPECT(stack.top_span(2)[1].as<bool>() == false);
+}
+
 }  // namespace
 }  // namespace hop
@@ -0,0 +1,136 @@
+#include "hop/core/guarded_value_stack.h"
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace hop {
+namespace {
+
+// The address ranges of every live mapping. A slot whose `begin` is zero is
+// unused. Slots are only read from the fault handler, so they must be
+// lock-free atomics rather than a container guarded by a mutex.
+struct Region {
+  std::atomic<uintptr_t> begin;
+  std::atomic<uintptr_t> end;
+};
+constinit Region regions[64] = {};
+
+struct sigaction previous_action;
+
+void Register(void *mapping, size_t size) {
+  uintptr_t begin = reinterpret_cast<uintptr_t>(mapping);
+  for (auto &region : regions) {
+    uintptr_t expected = 0;
+    if (region.begin.compare_exchange_strong(expected, begin)) {
+      region.end.store(begin + size);
+      return;
+    }
+  }
+  // Every slot is in use. The stack remains usable, but an overflow will be
+  // reported as an ordinary segmentation fault.
+}
+
+void Unregister(void *mapping) {
+  uintptr_t begin = reinterpret_cast<uintptr_t>(mapping);
+  for (auto &region : regions) {
+    if (region.begin.load() == begin) {
+      region.end.store(0);
+      region.begin.store(0);
+      return;
+    }
+  }
+}
+
+void HandleFault(int signal, siginfo_t *info, void *context) {
+  uintptr_t address = reinterpret_cast<uintptr_t>(info->si_addr);
+  for (auto const &region : regions) {
+    if (region.begin.load() <= address and address < region.end.load()) {
+      static constexpr char Message[] = "Hop value stack overflow.\n";
+      [[maybe_unused]] auto written =
+          ::write(STDERR_FILENO, Message, sizeof(Message) - 1);
+      std::abort();
+    }
+  }
+
+  // The fault did not occur on a guard page, so defer to whichever handler
+  // was installed before ours.
+  if (previous_action.sa_flags & SA_SIGINFO) {
+    previous_action.sa_sigaction(signal, info, context);
+  } else if (previous_action.sa_handler != SIG_DFL and
+             previous_action.sa_handler != SIG_IGN) {
+    previous_action.sa_handler(signal);
+  } else {
+    // Returning re-executes the faulting instruction under the default
+    // disposition.
+    ::sigaction(signal, &previous_action, nullptr);
+  }
+}
+
+// Reports that `operation` failed to set up the memory backing a value stack of
+// `bytes` bytes, with the reason given by `error`, and aborts. Without its
+// memory there is nothing a `GuardedValueStack` can usefully do.
+[[noreturn]] void MappingFailed(char const *operation, size_t bytes,
+                                int error) {
+  std::fprintf(stderr,
+               "Failed to reserve a %zu-byte Hop value stack: %s failed: %s\n",
+               bytes, operation, std::strerror(error));
+  std::abort();
+}
+
+void InstallFaultHandler() {
+  static std::once_flag flag;
+  std::call_once(flag, [] {
+    struct sigaction action = {};
+    action.sa_sigaction     = HandleFault;
+    action.sa_flags         = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGSEGV, &action, &previous_action);
+  });
+}
+
+}  // namespace
+
+GuardedValueStack::GuardedValueStack(size_t capacity) {
+  size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  size_t bytes     = (capacity * sizeof(Value) + page_size - 1) / page_size *
+                 page_size;
+  mapping_size_ = bytes + 2 * page_size;
+  mapping_      = ::mmap(nullptr, mapping_size_, PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (mapping_ == MAP_FAILED) { MappingFailed("mmap", mapping_size_, errno); }
+
+  std::byte *usable = static_cast<std::byte *>(mapping_) + page_size;
+  if (::mprotect(usable, bytes, PROT_READ | PROT_WRITE) != 0) {
+    int error = errno;
+    ::munmap(mapping_, mapping_size_);
+    MappingFailed("mprotect", mapping_size_, error);
+  }
+
+  base_     = reinterpret_cast<Value *>(usable);
+  head_     = base_;
+  capacity_ = bytes / sizeof(Value);
+
+  InstallFaultHandler();
+  Register(mapping_, mapping_size_);
+}
+
+GuardedValueStack::GuardedValueStack(std::initializer_list<Value> values)
+    : GuardedValueStack() {
+  for (Value v : values) { push(v); }
+}
+
+GuardedValueStack::~GuardedValueStack() {
+  Unregister(mapping_);
+  ::munmap(mapping_, mapping_size_);
+}
+
+}  // namespace hop
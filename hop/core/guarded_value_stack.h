@@ -0,0 +1,82 @@
+#ifndef JASMIN_CORE_GUARDED_VALUE_STACK_H
+#define JASMIN_CORE_GUARDED_VALUE_STACK_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <limits>
+#include <span>
+#include <utility>
+
+#include "hop/core/value.h"
+
+namespace hop {
+
+// A `GuardedValueStack` is a value stack backed by a single large region of
+// reserved virtual memory, surrounded by inaccessible guard pages. Functions
+// invoked with a `GuardedValueStack` (see `Function<>::invoke`) never grow the
+// stack, so the capacity checks performed by instructions always succeed and
+// are perfectly predicted. Those checks are removed entirely from functions
+// which have been finalized (see `Function<Set>::finalize`), whose only
+// remaining checks are made on entry. Either way, writing past the end of the
+// region faults on a guard page, and the fault is reported as a value stack
+// overflow before the program aborts. Memory is only committed by the operating system as
+// pages are first touched, so reserving a generous capacity is inexpensive.
+struct GuardedValueStack {
+  // The default number of `Value`s reserved: 128MiB of address space.
+  static constexpr size_t DefaultCapacity = size_t{1} << 24;
+
+  // Constructs an empty stack with room for at least `capacity` values. If the
+  // operating system cannot provide the address space, a diagnostic is
+  // written to standard error and the program aborts.
+  explicit GuardedValueStack(size_t capacity = DefaultCapacity);
+
+  // Constructs a stack with the default capacity holding `values`, the last of
+  // which is on top.
+  GuardedValueStack(std::initializer_list<Value> values);
+
+  GuardedValueStack(GuardedValueStack const &)            = delete;
+  GuardedValueStack &operator=(GuardedValueStack const &) = delete;
+
+  ~GuardedValueStack();
+
+  // Returns the number of values that may be held before overflowing.
+  size_t capacity() const { return capacity_; }
+
+  size_t size() const { return head_ - base_; }
+  bool empty() const { return head_ == base_; }
+
+  void push(Value v) { *head_++ = v; }
+  void pop() { --head_; }
+
+  Value &top() { return head_[-1]; }
+  Value const &top() const { return head_[-1]; }
+
+  // Returns a span referencing the top `n` values on the stack.
+  std::span<Value> top_span(size_t n) { return std::span(head_ - n, n); }
+  std::span<Value const> top_span(size_t n) const {
+    return std::span(head_ - n, n);
+  }
+
+ private:
+  // The number of values reported as available to executing instructions.
+  // Large enough that no instruction ever asks to grow the stack, yet small
+  // enough that subtracting from it never wraps.
+  static constexpr size_t Unbounded = std::numeric_limits<size_t>::max() / 2;
+
+  friend std::pair<Value *, size_t> ReleaseValueStack(GuardedValueStack &s) {
+    return {s.head_, Unbounded};
+  }
+  friend void RestoreValueStack(GuardedValueStack &s, Value *head, size_t) {
+    s.head_ = head;
+  }
+
+  void *mapping_;
+  size_t mapping_size_;
+  Value *base_;
+  Value *head_;
+  size_t capacity_;
+};
+
+}  // namespace hop
+
+#endif  // JASMIN_CORE_GUARDED_VALUE_STACK_H
@@ -0,0 +1,32 @@
+#include "hop/core/guarded_value_stack.h"
+
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+NTH_TEST("guarded-value-stack/construction") {
+  GuardedValueStack empty(10);
+  NTH_EXPECT(empty.empty());
+  NTH_EXPECT(empty.capacity() >= size_t{10});
+
+  GuardedValueStack stack = {1, 2, 3};
+  NTH_ASSERT(stack.size() == size_t{3});
+  NTH_EXPECT(stack.top().as<int>() == 3);
+}
+
+NTH_TEST("guarded-value-stack/push-pop") {
+  GuardedValueStack stack(1);
+  // Capacity is rounded up to a whole number of pages, all of which are
+  // writable.
+  for (size_t i = 0; i < stack.capacity(); ++i) { stack.push(i); }
+  NTH_EXPECT(stack.size() == stack.capacity());
+  NTH_EXPECT(stack.top().as<size_t>() == stack.capacity() - 1);
+  std::span values = stack.top_span(2);
+  NTH_EXPECT(values[0].as<size_t>() == stack.capacity() - 2);
+  stack.pop();
+  NTH_EXPECT(stack.size() == stack.capacity() - 1);
+}
+
+}  // namespace
+}  // namespace hop
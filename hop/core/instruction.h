@@ -1,7 +1,15 @@
 #ifndef JASMIN_CORE_INSTRUCTION_H
 #define JASMIN_CORE_INSTRUCTION_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <concepts>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
 #include <limits>
 #include <span>
 #include <string>
@@ -12,6 +20,7 @@
 #include "hop/core/internal/function_base.h"
 #include "hop/core/internal/function_state.h"
 #include "hop/core/internal/instruction_traits.h"
+#include "hop/core/latency_histogram.h"
 #include "hop/core/output.h"
 #include "hop/core/value.h"
 #include "nth/base/attributes.h"
@@ -32,11 +41,17 @@ namespace hop {
 // ```
 // struct MyInstruction : hop::Instruction<MyInstruction> { ... };
 // ```
+//
+// `ExecuteImpl<Set>` is the function invoked by the interpreter to execute the
+// instruction. Each instruction checks that the value stack has room for its
+// outputs before executing, unless `CheckCapacity` is `false`. Those variants
+// are only used by finalized functions (see `Function<Set>::finalize`), whose
+// callers guarantee sufficient capacity on entry.
 template <typename>
 struct Instruction {
-  template <typename>
+  template <typename, bool CheckCapacity = true>
   static void ExecuteImpl(Value *, size_t, Value const *, internal::FrameBase *,
-                          uint64_t);
+                          uint64_t, internal::CachedValue);
 };
 
 // Every instruction `Inst` executable as part of Hop's stack machine
@@ -84,9 +99,20 @@ struct Instruction {
 //   of the spans provided to the corresponding `consume` or `execute` functions
 //   will match this specification.
 //
+// PURE INSTRUCTIONS:
+//   An instruction with an instruction-determined signature and no function
+//   state may declare `static constexpr bool pure = true;` to indicate that
+//   its outputs depend only on its inputs and immediate values, and that it
+//   has no other observable effect. Pure instructions whose inputs are known
+//   ahead of time may be evaluated before the function is ever executed (see
+//   `FoldConstants` in "hop/transform/fold.h"). Instructions whose execution
+//   may be undefined for some inputs (e.g., division) should not be marked
+//   pure, as such inputs may appear on paths which are never executed.
+//
 template <typename I>
 concept InstructionType = (std::derived_from<I, Instruction<I>> and
                            (internal::BuiltinInstruction<I>() or
+                            internal::FusedInstruction<I>() or
                             internal::UserDefinedInstruction<I>));
 
 // A concept indicating which types constitute instruction sets understandable
@@ -119,6 +145,11 @@ constexpr size_t ParameterCount();
 template <typename I>
 constexpr bool ConsumesInput();
 
+// Returns `true` if the instruction `I` has declared itself pure (see "PURE
+// INSTRUCTIONS" above) and `false` otherwise.
+template <typename I>
+constexpr bool PureInstruction();
+
 // Returns the number of return values produced by the instruction.
 template <typename I>
 constexpr size_t ReturnCount();
@@ -134,6 +165,14 @@ std::string_view InstructionName();
 // function pointer, and begins execution at that function's entry point.
 struct Call : Instruction<Call> {};
 
+// `CallDirect` is a built-in instruction, available automatically in every
+// instruction set. It accepts an `InstructionSpecification` and a
+// `Function<> const *` as immediate values and begins execution at that
+// function's entry point. It behaves as `Call` would had the function pointer
+// been pushed onto the stack immediately before, but requires only a single
+// dispatch.
+struct CallDirect : Instruction<CallDirect> {};
+
 // `Jump` is a built-in instruction, available automatically in every
 // instruction set. It accepts a single `std::ptrdiff_t` immediate value,
 // increments the instruction pointer by that amount and resumes execution.
@@ -153,17 +192,182 @@ struct JumpIf : Instruction<JumpIf> {};
 // incremented by the immediate value and execution resumes.
 struct JumpIfNot : Instruction<JumpIfNot> {};
 
+// `Switch` is a built-in instruction, available automatically in every
+// instruction set. It accepts a `uint64_t` minimum and a `size_t` count as
+// immediate values, and must be immediately followed by `count + 1` `Jump`
+// instructions forming its jump table. It pops the top value off the stack and
+// interprets its bits as a `uint64_t` key. If `minimum <= key` and
+// `key - minimum < count`, execution continues at the target of the jump table
+// entry at index `key - minimum`. Otherwise, execution continues at the target
+// of the final entry. The entries of the jump table are never themselves
+// executed, so that a switch of any size costs a single dispatch. Sparse
+// switches are expressed by directing unused entries to the same target as the
+// final entry.
+struct Switch : Instruction<Switch> {};
+
 // `Return` is a built-in instruction, available automatically in every
 // instruction set. It returns control back to the calling function at the
 // instruction pointer immediately following the `Call` instruction that invoked
 // this function.
 struct Return : Instruction<Return> {};
 
+// `TailCall` is a built-in instruction, available automatically in every
+// instruction set. It accepts an `InstructionSpecification` immediate value,
+// pops the top value off the stack, interprets it as a function pointer, and
+// begins execution at that function's entry point. Unlike `Call`, the current
+// function's frame is reused for the callee, so that when the callee returns,
+// control returns to the caller of the current function. Function state in the
+// frame is reset as though the frame were newly constructed.
+struct TailCall : Instruction<TailCall> {};
+
+// `Yield` is a built-in instruction, available automatically in every
+// instruction set. It suspends execution, returning control to the host with
+// the value stack intact. Execution continues with the following instruction
+// when resumed. Functions containing `Yield` must be executed via a
+// `Continuation` (see "hop/core/continuation.h"). While suspended, the host may
+// push or pop values for the function to consume once resumed, so functions
+// containing `Yield` are never finalized (see `Function<Set>::finalize`).
+struct Yield : Instruction<Yield> {};
+
+namespace internal {
+
+// Describes the effect a sequence of instructions has on the height of the
+// value stack, relative to the height before the sequence is executed.
+struct StackEffect {
+  // The number of values which must be present on the stack beforehand.
+  ptrdiff_t required;
+  // The maximum height, at any point during execution, of the stack above its
+  // initial height.
+  ptrdiff_t max_growth;
+  // The height of the stack after execution, less its initial height.
+  ptrdiff_t net;
+};
+
+// Returns the `StackEffect` of executing each of the instructions fused in the
+// superinstruction `I`.
+template <typename I>
+constexpr StackEffect FusedStackEffect();
+
+// Returns an `nth::Sequence` of the types of immediate values passed to `I`.
+// Requires that `I` not be immediate-value-determined.
+template <typename I>
+constexpr nth::Sequence auto ImmediateValueTypes();
+
+// Returns `true` if and only if the sequence of instructions `Is...` satisfies
+// the requirements documented on `Fused` below.
+template <typename... Is>
+constexpr bool FusableSequence();
+
+}  // namespace internal
+
+// `Fused<Is...>` is a superinstruction which executes each of the instructions
+// `Is...` in order with a single dispatch. Every instruction in `Is...` other
+// than the last must be a user-defined instruction whose number of parameters
+// and returns is statically known. The last instruction may additionally be
+// one of `Jump`, `JumpIf`, or `JumpIfNot`, in which case the jump offset is
+// measured from the fused instruction rather than from the jump itself. The
+// immediate values of a fused instruction are the concatenation of the
+// immediate values of each of `Is...`.
+//
+// Fused instructions are not typically appended directly, but are rather
+// introduced by `hop::FuseInstructions` (see "hop/transform/fuse.h"). For this
+// reason, any instruction set containing `Fused<Is...>` should also contain
+// each of `Is...`.
+template <typename... Is>
+struct Fused : Instruction<Fused<Is...>> {
+  static_assert(internal::FusableSequence<Is...>());
+  static constexpr auto fused_instructions = nth::type_sequence<Is...>;
+};
+
 namespace internal {
 
+// The state of an execution published for the sampling profiler (see
+// "hop/core/sampling_profiler.h"). Fields are written by the executing thread
+// and read by a signal handler on the same thread, so they are `volatile` to
+// ensure that they are written in program order.
+struct SampledExecution {
+  // The instruction being executed, or null if `frame_end` and `frames_begin`
+  // may not be consistent with one another or with the call stack, in which
+  // case no sample is taken.
+  Value const *volatile ip;
+  // A pointer one past the last frame on the call stack.
+  FrameBase *volatile frame_end;
+  // A pointer to the first frame on the call stack, which belongs to the
+  // outermost function.
+  std::byte const *volatile frames_begin;
+  // The size of each frame on the call stack.
+  size_t frame_size;
+  // The execution on this thread which invoked this one, if any.
+  SampledExecution *previous;
+};
+
+// The innermost execution published for sampling on this thread. Only
+// maintained when sampling is enabled.
+inline constinit thread_local SampledExecution *sampled_execution = nullptr;
+
+// Records that the instruction at `ip` is executing with call stack frames
+// ending at `frame_end`, if sampling is enabled. Otherwise does nothing.
+inline void PublishExecution(Value const *ip, FrameBase *frame_end) {
+  if constexpr (sampling) {
+    if (SampledExecution *s = sampled_execution) {
+      s->frame_end = frame_end;
+      s->ip        = ip;
+    }
+  }
+}
+
+// Records that the frames on the call stack are about to move, so that the
+// call stack must not be inspected until the next call to `PublishExecution`.
+inline void UnpublishExecution() {
+  if constexpr (sampling) {
+    if (SampledExecution *s = sampled_execution) { s->ip = nullptr; }
+  }
+}
+
+// Records that the first frame of the call stack now resides at `begin`.
+inline void PublishFramesBegin(void const *begin) {
+  if constexpr (sampling) {
+    if (SampledExecution *s = sampled_execution) {
+      s->frames_begin = static_cast<std::byte const *>(begin);
+    }
+  }
+}
+
+// Publishes an execution whose frames are each of type `FrameType` for
+// sampling for the duration of its lifetime, if sampling is enabled.
+// Otherwise does nothing.
+template <typename FrameType, bool = sampling>
+struct SampledExecutionScope {
+  explicit SampledExecutionScope(FrameType const *) {}
+};
+
+template <typename FrameType>
+struct SampledExecutionScope<FrameType, true> {
+  explicit SampledExecutionScope(FrameType const *frames_begin) {
+    execution_.ip           = nullptr;
+    execution_.frame_end    = nullptr;
+    execution_.frames_begin = static_cast<std::byte const *>(
+        static_cast<void const *>(frames_begin));
+    execution_.frame_size   = sizeof(FrameType);
+    execution_.previous     = sampled_execution;
+    // The signal handler must never observe `execution_` before it has been
+    // initialized.
+    std::atomic_signal_fence(std::memory_order_release);
+    sampled_execution = &execution_;
+  }
+
+  SampledExecutionScope(SampledExecutionScope const &)            = delete;
+  SampledExecutionScope &operator=(SampledExecutionScope const &) = delete;
+
+  ~SampledExecutionScope() { sampled_execution = execution_.previous; }
+
+ private:
+  SampledExecution execution_;
+};
+
 inline void ReallocateValueStack(Value *value_stack_head, size_t capacity_left,
                                  Value const *ip, FrameBase *call_stack,
-                                 uint64_t cap_and_left) {
+                                 uint64_t cap_and_left, CachedValue top) {
   {
     // Scope is necessary to ensure destruction of `v` occurs before the
     // tail-call, even though the destruction will be a no-op due to the
@@ -176,26 +380,341 @@ inline void ReallocateValueStack(Value *value_stack_head, size_t capacity_left,
 
   NTH_ATTRIBUTE(tailcall)
   return ip->template as<exec_fn_type>()(value_stack_head, capacity_left, ip,
-                                         call_stack, cap_and_left);
+                                         call_stack, cap_and_left, top);
 }
 
 template <typename FrameType>
 inline void ReallocateCallStack(Value *value_stack_head, size_t capacity_left,
                                 Value const *ip, FrameBase *cs_head,
-                                uint64_t cs_left) {
+                                uint64_t cs_left, CachedValue top) {
   {
     // Scope is necessary to ensure destruction of `c` occurs before the
     // tail-call, even though the destruction will be a no-op due to the
     // move+release.
     auto c = nth::stack<FrameType>::reconstitute_from(
         static_cast<FrameType *>(cs_head), cs_left);
-    c.reserve(c.size() * 2);
+    UnpublishExecution();
+    size_t depth = c.size();
+    c.reserve(depth * 2);
     std::tie(cs_head, cs_left) = std::move(c).release();
+    PublishFramesBegin(static_cast<FrameType *>(cs_head) - depth);
   }
 
   NTH_ATTRIBUTE(tailcall)
   return ip->template as<exec_fn_type>()(value_stack_head, capacity_left, ip,
-                                         cs_head, cs_left);
+                                         cs_head, cs_left, top);
+}
+
+// With the top-of-stack cache enabled, the value stack consists of the values
+// in memory followed by the cached value `top`. So that `top` is always
+// well-defined, `Invoke` places an uninitialized value beneath all others in
+// memory, which is removed when execution finishes.
+
+// Pops the value on top of the value stack and returns it.
+inline Value PopValue(Value *&value_stack_head, NoCachedValue &) {
+  return *--value_stack_head;
+}
+inline Value PopValue(Value *&value_stack_head, Value &top) {
+  Value v = top;
+  top     = *--value_stack_head;
+  return v;
+}
+
+// Returns the value on top of the value stack without removing it.
+inline Value PeekValue(Value const *value_stack_head, NoCachedValue) {
+  return value_stack_head[-1];
+}
+inline Value PeekValue(Value const *, Value top) { return top; }
+
+// Returns whether a call to `f` may begin when `vs_left` more values fit on
+// the value stack, which already holds the arguments to `f`. A finalized
+// function executes no capacity checks of its own, so its entire stack depth
+// must be available up front. Other functions always may be entered.
+inline bool HasEntryCapacity(FunctionBase const *f, size_t vs_left) {
+  return f->max_stack_depth() <= f->parameter_count() + vs_left;
+}
+
+// The state of an execution suspended by `Yield` or by exhausting its fuel,
+// sufficient to resume it.
+struct Suspension {
+  Value *value_stack_head;
+  size_t vs_left;
+  Value const *ip;
+  FrameBase *call_stack;
+  uint64_t cs_left;
+  CachedValue top;
+  bool suspended;
+  bool out_of_fuel;
+  // The number of backward jumps and calls which may still be executed before
+  // execution is suspended. Only consumed when `meter_fuel` is enabled.
+  uint64_t fuel;
+};
+
+// Points to the `Suspension` into which `Yield` records the state of the
+// resumable execution running on this thread, or null if the running
+// execution is not resumable.
+inline thread_local Suspension *active_suspension = nullptr;
+
+// Records the state of the running execution in `*active_suspension` so that
+// it will resume at `ip`. Callers must then return rather than dispatching
+// another instruction, so as to unwind the chain of tail-calls.
+inline void Suspend(Value *value_stack_head, size_t vs_left, Value const *ip,
+                    FrameBase *call_stack, uint64_t cs_left, CachedValue top,
+                    bool out_of_fuel) {
+  Suspension *suspension = active_suspension;
+  NTH_REQUIRE((harden), suspension != nullptr);
+  suspension->value_stack_head = value_stack_head;
+  suspension->vs_left          = vs_left;
+  suspension->ip               = ip;
+  suspension->call_stack       = call_stack;
+  suspension->cs_left          = cs_left;
+  suspension->top              = top;
+  suspension->suspended        = true;
+  suspension->out_of_fuel      = out_of_fuel;
+}
+
+// Consumes one unit of fuel from the running execution, if it is resumable and
+// fuel is metered. Returns `true` if no fuel remained, in which case the
+// execution must be suspended before executing the current instruction.
+inline bool ExhaustFuel() {
+  if constexpr (meter_fuel) {
+    Suspension *suspension = active_suspension;
+    if (suspension == nullptr) { return false; }
+    if (suspension->fuel == 0) [[unlikely]] { return true; }
+    --suspension->fuel;
+  }
+  return false;
+}
+
+// Returns a pointer to the entry in the jump table of the `Switch` instruction
+// at `ip` which is selected by `key`.
+inline Value const *SwitchEntry(Value const *ip, uint64_t key) {
+  uint64_t index = key - (ip + 1)->as<uint64_t>();
+  size_t count   = (ip + 2)->as<size_t>();
+  if (index > count) { index = count; }
+  return ip + 3 + 2 * index;
+}
+
+// Returns the op-code of `Inst` in the instruction set `Set`, which is its
+// index in `Set::instructions`.
+template <typename Inst, typename Set>
+constexpr uint16_t OpCode() {
+  return Set::instructions.reduce([](auto... is) {
+    uint16_t index = 0;
+    static_cast<void>(((is == nth::type<Inst> ? true : (++index, false)) or
+                       ...));
+    return index;
+  });
+}
+
+// The number of times each instruction in `Set` has been executed, indexed by
+// op-code. Only instantiated, and only maintained, when profiling is enabled.
+template <typename Set>
+inline std::atomic<uint64_t> execution_counts[Set::instructions.size()];
+
+// Records an execution of `Inst` in `execution_counts<Set>`, if profiling is
+// enabled, and otherwise does nothing. The count is loaded and stored rather
+// than atomically incremented, so that counting does not serialize threads
+// executing concurrently, at the cost of occasionally losing counts made
+// concurrently.
+template <typename Inst, typename Set>
+void CountExecution() {
+  if constexpr (profile) {
+    auto &count = execution_counts<Set>[OpCode<Inst, Set>()];
+    count.store(count.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+  }
+}
+
+// Records in `latency` that `callee` is being called, if latency measurement
+// is enabled. Otherwise does nothing.
+inline void EnterCall(NoCallTimestamp &, void const *) {}
+inline void EnterCall(CallTimestamp &latency, void const *callee) {
+  latency.callee  = callee;
+  latency.entered = std::chrono::steady_clock::now().time_since_epoch() /
+                    std::chrono::nanoseconds(1);
+}
+
+// Records the latency of the call whose entry was recorded in `latency`, if
+// latency measurement is enabled. Otherwise does nothing. Frames not entered
+// by a call, such as that of the outermost function, are ignored.
+inline void ExitCall(NoCallTimestamp &) {}
+inline void ExitCall(CallTimestamp &latency) {
+  if (latency.callee == nullptr) { return; }
+  uint64_t now = std::chrono::steady_clock::now().time_since_epoch() /
+                 std::chrono::nanoseconds(1);
+  RecordCallLatency(latency.callee,
+                    std::chrono::nanoseconds(now - latency.entered));
+}
+
+// Moves the cached value into memory, so that the entire value stack is held
+// in memory. Does nothing if the top-of-stack cache is disabled.
+inline void SpillCachedValue(Value *&, NoCachedValue) {}
+inline void SpillCachedValue(Value *&value_stack_head, Value top) {
+  *value_stack_head++ = top;
+}
+
+// Moves the value on top of the stack in memory into the cache. Does nothing
+// if the top-of-stack cache is disabled.
+inline void ReloadCachedValue(Value *&, NoCachedValue &) {}
+inline void ReloadCachedValue(Value *&value_stack_head, Value &top) {
+  top = *--value_stack_head;
+}
+
+// Copies the top `max(Inputs, 1)` values of the value stack into a local
+// window with room for `Growth` more values, and invokes `f` with a pointer
+// one past the last value in the window. `f` must return a pointer one past the
+// last value in the window after it has executed. The contents of the window
+// are then written back to the value stack, and the new head of the value
+// stack is returned. Because the window is local, instructions with few inputs
+// and outputs can be executed entirely in registers.
+template <size_t Inputs, size_t Growth>
+Value *ExecuteInWindow(Value *value_stack_head, Value &top, auto f) {
+  constexpr size_t Loaded = (Inputs == 0 ? 1 : Inputs);
+  Value window[Loaded + Growth];
+  Value *base = value_stack_head - (Loaded - 1);
+  std::memcpy(window, base, sizeof(Value) * (Loaded - 1));
+  window[Loaded - 1] = top;
+
+  size_t count = f(window + Loaded) - window;
+  if (count == 0) {
+    top = *--base;
+    return base;
+  }
+  std::memcpy(base, window, sizeof(Value) * (count - 1));
+  top = window[count - 1];
+  return base + (count - 1);
+}
+
+// Executes the body of the user-defined instruction `Inst`, whose number of
+// parameters and returns are statically known, reading its immediate values
+// starting at `immediates`. Returns the new head of the value stack. Callers
+// are responsible for ensuring that the value stack has sufficient capacity.
+template <typename Inst, typename Set>
+Value *ExecuteBody(Value *value_stack_head, Value const *immediates,
+                   FrameBase *call_stack) {
+  using frame_type = Frame<FunctionState<Set>>;
+  constexpr auto inst      = InstructionFunctionPointer<Inst>();
+  constexpr auto inst_type = InstructionFunctionType<Inst>();
+  constexpr bool HasFunctionState =
+      (::hop::FunctionState<Inst>() != nth::type<void>);
+  using input_type =
+      nth::type_t<inst_type.parameters().template get<HasFunctionState>()>;
+  using output_type =
+      nth::type_t<inst_type.parameters().template get<1 + HasFunctionState>()>;
+  constexpr size_t InputCount  = ::hop::ParameterCount<Inst>();
+  constexpr size_t OutputCount = ::hop::ReturnCount<Inst>();
+  constexpr bool Consumes      = ::hop::ConsumesInput<Inst>();
+
+  constexpr auto parameter_types =
+      inst_type.parameters().template drop<2 + HasFunctionState>();
+
+#define JASMIN_CORE_INTERNAL_GET(p, Ns)                                        \
+  (p + Ns)->template as<nth::type_t<parameter_types.template get<Ns>()>>()
+
+  if constexpr (HasFunctionState) {
+    auto &fn_state = (static_cast<frame_type *>(call_stack) - 1)
+                         ->state.template get<typename Inst::function_state>();
+
+    [&]<size_t... Ns>(std::index_sequence<Ns...>) {
+      if constexpr (Consumes) {
+        auto *out_start = value_stack_head - InputCount;
+        Value input[InputCount];
+        std::memcpy(input, value_stack_head - InputCount,
+                    sizeof(Value) * InputCount);
+        inst(fn_state, input_type(input), output_type(out_start),
+             JASMIN_CORE_INTERNAL_GET(immediates, Ns)...);
+      } else {
+        inst(fn_state, input_type(value_stack_head - InputCount),
+             output_type(value_stack_head),
+             JASMIN_CORE_INTERNAL_GET(immediates, Ns)...);
+      }
+    }
+    (std::make_index_sequence<::hop::ImmediateValueCount<Inst>()>{});
+  } else {
+    [&]<size_t... Ns>(std::index_sequence<Ns...>) {
+      if constexpr (Consumes) {
+        auto *out_start = value_stack_head - InputCount;
+        Value input[InputCount];
+        std::memcpy(input, value_stack_head - InputCount,
+                    sizeof(Value) * InputCount);
+        inst(input_type(input), output_type(out_start),
+             JASMIN_CORE_INTERNAL_GET(immediates, Ns)...);
+      } else {
+        inst(input_type(value_stack_head - InputCount),
+             output_type(value_stack_head),
+             JASMIN_CORE_INTERNAL_GET(immediates, Ns)...);
+      }
+    }
+    (std::make_index_sequence<::hop::ImmediateValueCount<Inst>()>{});
+  }
+#undef JASMIN_CORE_INTERNAL_GET
+
+  constexpr ptrdiff_t UpdateAmount =
+      OutputCount - (Consumes ? InputCount : 0);
+  if constexpr (UpdateAmount < 0) {
+    return value_stack_head - -UpdateAmount;
+  } else {
+    return value_stack_head + UpdateAmount;
+  }
+}
+
+// Executes the body of the immediate-value-determined instruction `Inst`. The
+// `InstructionSpecification` for the instruction must be stored at
+// `immediates`, followed by the remaining immediate values. Returns the new
+// head of the value stack. Callers are responsible for ensuring that the value
+// stack has sufficient capacity.
+template <typename Inst, typename Set>
+Value *ExecuteDeterminedBody(Value *value_stack_head, Value const *immediates,
+                             FrameBase *call_stack) {
+  using frame_type = Frame<FunctionState<Set>>;
+  constexpr auto inst      = InstructionFunctionPointer<Inst>();
+  constexpr auto inst_type = InstructionFunctionType<Inst>();
+  constexpr bool HasFunctionState =
+      (::hop::FunctionState<Inst>() != nth::type<void>);
+  auto [ins, outs] = immediates->as<InstructionSpecification>();
+
+  Value *input;
+  Value *output;
+  if constexpr (::hop::ConsumesInput<Inst>()) {
+    output = value_stack_head - ins;
+    input  = value_stack_head - ins + outs;
+    std::memmove(input, output, sizeof(Value) * ins);
+  } else {
+    input  = value_stack_head - ins;
+    output = value_stack_head;
+  }
+
+#define JASMIN_CORE_INTERNAL_GET(p, Ns)                                        \
+  (p + Ns)->template as<nth::type_t<parameter_types.template get<Ns>()>>()
+
+  constexpr auto parameter_types =
+      inst_type.parameters().template drop<2 + HasFunctionState>();
+  [&]<size_t... Ns>(std::index_sequence<Ns...>) {
+    if constexpr (HasFunctionState) {
+      auto &fn_state =
+          (static_cast<frame_type *>(call_stack) - 1)
+              ->state.template get<typename Inst::function_state>();
+
+      inst(fn_state, std::span(input, ins), std::span(output, outs),
+           JASMIN_CORE_INTERNAL_GET((immediates + 1), Ns)...);
+    } else {
+      inst(std::span(input, ins), std::span(output, outs),
+           JASMIN_CORE_INTERNAL_GET((immediates + 1), Ns)...);
+    }
+  }
+  (std::make_index_sequence<::hop::ImmediateValueCount<Inst>() - 1>{});
+  // Note: We subtract one above because we do not need to pass the
+  // `InstructionSpecification`. We don't want this reflected in the return
+  // of `ImmediateValueCount` since it is technically still an immediate
+  // value.
+#undef JASMIN_CORE_INTERNAL_GET
+
+  if constexpr (::hop::ConsumesInput<Inst>()) {
+    return value_stack_head - ins + outs;
+  } else {
+    return value_stack_head + outs;
+  }
 }
 
 // Constructs an InstructionSet type from a list of instructions. Does no
@@ -237,7 +756,8 @@ template <typename... Is>
 using MakeInstructionSet = nth::type_t<
     internal::FlattenInstructionList(
         /*unprocessed=*/nth::type_sequence<Is...>,
-        /*processed=*/nth::type_sequence<Call, Jump, JumpIf, JumpIfNot, Return>)
+        /*processed=*/nth::type_sequence<Call, Jump, JumpIf, JumpIfNot, Return,
+                                         CallDirect, TailCall, Yield, Switch>)
         .reduce([](auto... vs) {
           return nth::type<internal::MakeInstructionSet<nth::type_t<vs>...>>;
         })>;
@@ -245,198 +765,295 @@ using MakeInstructionSet = nth::type_t<
 // Implementation details.
 
 template <typename Inst>
-template <typename Set>
+template <typename Set, bool CheckCapacity>
 void Instruction<Inst>::ExecuteImpl(Value *value_stack_head, size_t vs_left,
                                     Value const *ip,
                                     internal::FrameBase *call_stack,
-                                    uint64_t cs_left) {
+                                    uint64_t cs_left,
+                                    internal::CachedValue top) {
   using frame_type = internal::Frame<typename internal::FunctionState<Set>>;
   constexpr auto inst_type = nth::type<Inst>;
+  internal::CountExecution<Inst, Set>();
+  internal::PublishExecution(ip, call_stack);
   if constexpr (inst_type == nth::type<Call>) {
+    if (internal::ExhaustFuel()) [[unlikely]] {
+      return internal::Suspend(value_stack_head, vs_left, ip, call_stack,
+                               cs_left, top, /*out_of_fuel=*/true);
+    }
     if (cs_left == 0) [[unlikely]] {
       NTH_ATTRIBUTE(tailcall)
       return internal::ReallocateCallStack<frame_type>(
-          value_stack_head, vs_left, ip, call_stack, cs_left);
+          value_stack_head, vs_left, ip, call_stack, cs_left, top);
+    } else if (not internal::HasEntryCapacity(
+                   internal::PeekValue(value_stack_head, top)
+                       .as<internal::FunctionBase const *>(),
+                   vs_left + 1)) [[unlikely]] {
+      NTH_ATTRIBUTE(tailcall)
+      return internal::ReallocateValueStack(value_stack_head, vs_left, ip,
+                                            call_stack, cs_left, top);
     } else {
-      --value_stack_head;
+      auto const *f = internal::PopValue(value_stack_head, top)
+                          .as<internal::FunctionBase const *>();
       auto *p    = new (static_cast<frame_type *>(call_stack)) frame_type;
-      p->ip      = ip;
+      p->ip      = ip + 1 + ImmediateValueCount<Call>();
       call_stack = p + 1;
-      ip = value_stack_head->as<internal::FunctionBase const *>()->entry();
+      internal::RecordCallSite(p->call_site, ip);
+      ip = f->entry();
+      internal::EnterCall(p->latency, f);
       NTH_ATTRIBUTE(tailcall)
       return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left + 1, ip,
-                                              call_stack, cs_left - 1);
+                                              call_stack, cs_left - 1, top);
+    }
+  } else if constexpr (inst_type == nth::type<CallDirect>) {
+    if (internal::ExhaustFuel()) [[unlikely]] {
+      return internal::Suspend(value_stack_head, vs_left, ip, call_stack,
+                               cs_left, top, /*out_of_fuel=*/true);
     }
+    if (cs_left == 0) [[unlikely]] {
+      NTH_ATTRIBUTE(tailcall)
+      return internal::ReallocateCallStack<frame_type>(
+          value_stack_head, vs_left, ip, call_stack, cs_left, top);
+    } else if (not internal::HasEntryCapacity(
+                   (ip + 2)->as<internal::FunctionBase const *>(), vs_left))
+        [[unlikely]] {
+      NTH_ATTRIBUTE(tailcall)
+      return internal::ReallocateValueStack(value_stack_head, vs_left, ip,
+                                            call_stack, cs_left, top);
+    } else {
+      auto *p       = new (static_cast<frame_type *>(call_stack)) frame_type;
+      auto const *f = (ip + 2)->as<internal::FunctionBase const *>();
+      p->ip         = ip + 1 + ImmediateValueCount<CallDirect>();
+      call_stack    = p + 1;
+      internal::RecordCallSite(p->call_site, ip);
+      ip = f->entry();
+      internal::EnterCall(p->latency, f);
+      NTH_ATTRIBUTE(tailcall)
+      return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left, ip,
+                                              call_stack, cs_left - 1, top);
+    }
+  } else if constexpr (inst_type == nth::type<TailCall>) {
+    if (internal::ExhaustFuel()) [[unlikely]] {
+      return internal::Suspend(value_stack_head, vs_left, ip, call_stack,
+                               cs_left, top, /*out_of_fuel=*/true);
+    }
+    if (not internal::HasEntryCapacity(
+            internal::PeekValue(value_stack_head, top)
+                .as<internal::FunctionBase const *>(),
+            vs_left + 1)) [[unlikely]] {
+      NTH_ATTRIBUTE(tailcall)
+      return internal::ReallocateValueStack(value_stack_head, vs_left, ip,
+                                            call_stack, cs_left, top);
+    }
+    auto const *f = internal::PopValue(value_stack_head, top)
+                        .as<internal::FunctionBase const *>();
+    auto *frame = static_cast<frame_type *>(call_stack) - 1;
+    internal::ExitCall(frame->latency);
+    internal::ResetState(*frame);
+    internal::EnterCall(frame->latency, f);
+    ip = f->entry();
+    NTH_ATTRIBUTE(tailcall)
+    return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left + 1, ip,
+                                            call_stack, cs_left, top);
   } else if constexpr (inst_type == nth::type<Jump>) {
+    if ((ip + 1)->as<ptrdiff_t>() <= 0 and internal::ExhaustFuel())
+        [[unlikely]] {
+      return internal::Suspend(value_stack_head, vs_left, ip, call_stack,
+                               cs_left, top, /*out_of_fuel=*/true);
+    }
     ip += (ip + 1)->as<ptrdiff_t>();
     NTH_ATTRIBUTE(tailcall)
     return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left, ip,
-                                            call_stack, cs_left);
+                                            call_stack, cs_left, top);
   } else if constexpr (inst_type == nth::type<JumpIf>) {
-    --value_stack_head;
-    if (value_stack_head->as<bool>()) {
+    if ((ip + 1)->as<ptrdiff_t>() <= 0 and internal::ExhaustFuel())
+        [[unlikely]] {
+      return internal::Suspend(value_stack_head, vs_left, ip, call_stack,
+                               cs_left, top, /*out_of_fuel=*/true);
+    }
+    if (internal::PopValue(value_stack_head, top).as<bool>()) {
       ip += (ip + 1)->as<ptrdiff_t>();
       NTH_ATTRIBUTE(tailcall)
       return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left + 1, ip,
-                                              call_stack, cs_left);
+                                              call_stack, cs_left, top);
     } else {
       ip += 2;
       NTH_ATTRIBUTE(tailcall)
       return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left + 1, ip,
-                                              call_stack, cs_left);
+                                              call_stack, cs_left, top);
     }
   } else if constexpr (inst_type == nth::type<JumpIfNot>) {
-    --value_stack_head;
-    if (not value_stack_head->as<bool>()) {
+    if ((ip + 1)->as<ptrdiff_t>() <= 0 and internal::ExhaustFuel())
+        [[unlikely]] {
+      return internal::Suspend(value_stack_head, vs_left, ip, call_stack,
+                               cs_left, top, /*out_of_fuel=*/true);
+    }
+    if (not internal::PopValue(value_stack_head, top).as<bool>()) {
       ip += (ip + 1)->as<ptrdiff_t>();
       NTH_ATTRIBUTE(tailcall)
       return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left + 1, ip,
-                                              call_stack, cs_left);
+                                              call_stack, cs_left, top);
     } else {
       ip += 2;
       NTH_ATTRIBUTE(tailcall)
       return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left + 1, ip,
-                                              call_stack, cs_left);
+                                              call_stack, cs_left, top);
+    }
+  } else if constexpr (inst_type == nth::type<Switch>) {
+    Value const *entry = internal::SwitchEntry(
+        ip, internal::PopValue(value_stack_head, top).raw_value());
+    Value const *target = entry + (entry + 1)->as<ptrdiff_t>();
+    if (target <= ip and internal::ExhaustFuel()) [[unlikely]] {
+      // The key has already been popped, so execution resumes at the chosen
+      // entry of the jump table, which jumps to the same target.
+      return internal::Suspend(value_stack_head, vs_left + 1, entry,
+                               call_stack, cs_left, top, /*out_of_fuel=*/true);
     }
+    ip = target;
+    NTH_ATTRIBUTE(tailcall)
+    return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left + 1, ip,
+                                            call_stack, cs_left, top);
+  } else if constexpr (inst_type == nth::type<Yield>) {
+    if (internal::active_suspension == nullptr) [[unlikely]] {
+      // Only executions run by `Continuation` may be suspended. `Yield` is
+      // cold, so this is checked regardless of build mode rather than left to
+      // the hardened check in `Suspend`.
+      std::fprintf(stderr, "Yield requires Continuation.\n");
+      std::abort();
+    }
+    internal::Suspend(value_stack_head, vs_left, ip + 1, call_stack, cs_left,
+                      top, /*out_of_fuel=*/false);
+    // Returning rather than dispatching the next instruction unwinds the
+    // entire chain of tail-calls back to `Continuation::resume`.
+    return;
   } else if constexpr (inst_type == nth::type<Return>) {
     call_stack = static_cast<frame_type *>(call_stack) - 1;
-    ip         = call_stack->ip + 2;
+    ip         = call_stack->ip;
+    internal::ExitCall(call_stack->latency);
     static_cast<frame_type *>(call_stack)->~frame_type();
     NTH_ATTRIBUTE(tailcall)
     return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left, ip,
-                                            call_stack, cs_left + 1);
+                                            call_stack, cs_left + 1, top);
+  } else if constexpr (internal::FusedInstruction<Inst>()) {
+    constexpr internal::StackEffect effect = internal::FusedStackEffect<Inst>();
+    if (CheckCapacity and vs_left < static_cast<size_t>(effect.max_growth))
+        [[unlikely]] {
+      NTH_ATTRIBUTE(tailcall)
+      return internal::ReallocateValueStack(value_stack_head, vs_left, ip,
+                                            call_stack, cs_left, top);
+    }
+
+    constexpr auto fused    = Inst::fused_instructions;
+    constexpr auto last     = fused.template get<fused.size() - 1>();
+    constexpr bool Branches = nth::any_of<nth::type_t<last>, Jump, JumpIf,
+                                          JumpIfNot>;
+    if constexpr (Branches) {
+      if ((ip + ImmediateValueCount<Inst>())->as<ptrdiff_t>() <= 0 and
+          internal::ExhaustFuel()) [[unlikely]] {
+        return internal::Suspend(value_stack_head, vs_left, ip, call_stack,
+                                 cs_left, top, /*out_of_fuel=*/true);
+      }
+    }
+    Value const *immediates = ip + 1;
+    bool condition          = false;
+    auto execute            = [&](Value *head) {
+      [&]<size_t... Ns>(std::index_sequence<Ns...>) {
+        ((head =
+              internal::ExecuteBody<nth::type_t<fused.template get<Ns>()>, Set>(
+                  head, immediates, call_stack),
+          immediates +=
+          ImmediateValueCount<nth::type_t<fused.template get<Ns>()>>()),
+         ...);
+      }
+      (std::make_index_sequence<fused.size() - Branches>{});
+      if constexpr (nth::any_of<nth::type_t<last>, JumpIf, JumpIfNot>) {
+        condition = (--head)->as<bool>();
+      }
+      return head;
+    };
+    if constexpr (internal::cache_top_of_stack) {
+      value_stack_head =
+          internal::ExecuteInWindow<effect.required, effect.max_growth>(
+              value_stack_head, top, execute);
+    } else {
+      value_stack_head = execute(value_stack_head);
+    }
+    vs_left -= effect.net;
+
+    if constexpr (last == nth::type<Jump>) {
+      ip += immediates->as<ptrdiff_t>();
+    } else if constexpr (last == nth::type<JumpIf>) {
+      ip += condition ? immediates->as<ptrdiff_t>()
+                      : 1 + ImmediateValueCount<Inst>();
+    } else if constexpr (last == nth::type<JumpIfNot>) {
+      ip += condition ? 1 + ImmediateValueCount<Inst>()
+                      : immediates->as<ptrdiff_t>();
+    } else {
+      ip += 1 + ImmediateValueCount<Inst>();
+    }
+    NTH_ATTRIBUTE(tailcall)
+    return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left, ip,
+                                            call_stack, cs_left, top);
   } else {
-    constexpr auto inst      = internal::InstructionFunctionPointer<Inst>();
-    constexpr auto inst_type = internal::InstructionFunctionType<Inst>();
-    constexpr bool HasFunctionState =
-        (FunctionState<Inst>() != nth::type<void>);
     if constexpr (ImmediateValueDetermined<Inst>()) {
       auto [ins, outs] = (ip + 1)->as<InstructionSpecification>();
       // If we consume, we still need a place to move the inputs during
       // execution. If not, we might need extra space to push return values. In
       // either, we use the stack so the allocation check doesn't have to be
-      // guarded by `ConsumesInput`.
-      if (vs_left < outs) [[unlikely]] {
+      // guarded by `ConsumesInput`. With the top-of-stack cache enabled, we
+      // also need space to spill the cached value.
+      if (CheckCapacity and vs_left < outs + internal::cache_top_of_stack)
+          [[unlikely]] {
         NTH_ATTRIBUTE(tailcall)
         return internal::ReallocateValueStack(value_stack_head, vs_left, ip,
-                                              call_stack, cs_left);
+                                              call_stack, cs_left, top);
       }
 
-      Value *input;
-      Value *output;
-      if constexpr (ConsumesInput<Inst>()) {
-        output = value_stack_head - ins;
-        input  = value_stack_head - ins + outs;
-        std::memmove(input, output, sizeof(Value) * ins);
-      } else {
-        input  = value_stack_head - ins;
-        output = value_stack_head;
-      }
-
-#define JASMIN_CORE_INTERNAL_GET(p, Ns)                                        \
-  (p + Ns)->template as<nth::type_t<parameter_types.template get<Ns>()>>()
-
-      constexpr auto parameter_types =
-          inst_type.parameters().template drop<2 + HasFunctionState>();
-      [&]<size_t... Ns>(std::index_sequence<Ns...>) {
-        if constexpr (HasFunctionState) {
-          auto &fn_state = std::get<typename Inst::function_state>(
-              (static_cast<frame_type *>(call_stack) - 1)->state);
-
-          inst(fn_state, std::span(input, ins), std::span(output, outs),
-               JASMIN_CORE_INTERNAL_GET((ip + 2), Ns)...);
-        } else {
-          inst(std::span(input, ins), std::span(output, outs),
-               JASMIN_CORE_INTERNAL_GET((ip + 2), Ns)...);
-        }
-      }
-      (std::make_index_sequence<ImmediateValueCount<Inst>() - 1>{});
-      // Note: We subtract one above because we do not need to pass the
-      // `InstructionSpecification`. We don't want this reflected in the return
-      // of `ImmediateValueCount` since it is technically still an immediate
-      // value.
+      internal::SpillCachedValue(value_stack_head, top);
+      value_stack_head = internal::ExecuteDeterminedBody<Inst, Set>(
+          value_stack_head, ip + 1, call_stack);
+      internal::ReloadCachedValue(value_stack_head, top);
 
       if constexpr (ConsumesInput<Inst>()) {
-        value_stack_head -= ins;
-        value_stack_head += outs;
         vs_left += ins;
         vs_left -= outs;
       } else {
-        value_stack_head += outs;
         vs_left -= outs;
       }
       ip += 1 + ImmediateValueCount<Inst>();
       NTH_ATTRIBUTE(tailcall)
       return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left, ip,
-                                              call_stack, cs_left);
+                                              call_stack, cs_left, top);
     } else {
-      using input_type =
-          nth::type_t<inst_type.parameters().template get<HasFunctionState>()>;
-      using output_type = nth::type_t<
-          inst_type.parameters().template get<1 + HasFunctionState>()>;
       constexpr size_t InputCount  = ParameterCount<Inst>();
       constexpr size_t OutputCount = ReturnCount<Inst>();
-      if (vs_left + (ConsumesInput<Inst>() ? InputCount : 0) < OutputCount)
+      if (CheckCapacity and
+          vs_left + (ConsumesInput<Inst>() ? InputCount : 0) < OutputCount)
           [[unlikely]] {
         NTH_ATTRIBUTE(tailcall)
         return internal::ReallocateValueStack(value_stack_head, vs_left, ip,
-                                              call_stack, cs_left);
+                                              call_stack, cs_left, top);
       }
 
-      constexpr auto parameter_types =
-          inst_type.parameters().template drop<2 + HasFunctionState>();
-
-      if constexpr (HasFunctionState) {
-        auto &fn_state = std::get<typename Inst::function_state>(
-            (static_cast<frame_type *>(call_stack) - 1)->state);
-
-        [&]<size_t... Ns>(std::index_sequence<Ns...>) {
-          if constexpr (ConsumesInput<Inst>()) {
-            auto *out_start = value_stack_head - InputCount;
-            Value input[InputCount];
-            std::memcpy(input, value_stack_head - InputCount,
-                        sizeof(Value) * InputCount);
-            inst(fn_state, input_type(input), output_type(out_start),
-                 JASMIN_CORE_INTERNAL_GET((ip + 1), Ns)...);
-          } else {
-            inst(fn_state, input_type(value_stack_head - InputCount),
-                 output_type(value_stack_head),
-                 JASMIN_CORE_INTERNAL_GET((ip + 1), Ns)...);
-          }
-        }
-        (std::make_index_sequence<ImmediateValueCount<Inst>()>{});
+      if constexpr (internal::cache_top_of_stack) {
+        value_stack_head =
+            internal::ExecuteInWindow<InputCount, OutputCount>(
+                value_stack_head, top, [&](Value *head) {
+                  return internal::ExecuteBody<Inst, Set>(head, ip + 1,
+                                                          call_stack);
+                });
       } else {
-        [&]<size_t... Ns>(std::index_sequence<Ns...>) {
-          if constexpr (ConsumesInput<Inst>()) {
-            auto *out_start = value_stack_head - InputCount;
-            Value input[InputCount];
-            std::memcpy(input, value_stack_head - InputCount,
-                        sizeof(Value) * InputCount);
-            inst(input_type(input), output_type(out_start),
-                 JASMIN_CORE_INTERNAL_GET((ip + 1), Ns)...);
-          } else {
-            inst(input_type(value_stack_head - InputCount),
-                 output_type(value_stack_head),
-                 JASMIN_CORE_INTERNAL_GET((ip + 1), Ns)...);
-          }
-        }
-        (std::make_index_sequence<ImmediateValueCount<Inst>()>{});
+        value_stack_head = internal::ExecuteBody<Inst, Set>(
+            value_stack_head, ip + 1, call_stack);
       }
-#undef JASMIN_CORE_INTERNAL_GET
 
       constexpr ptrdiff_t UpdateAmount =
           OutputCount - (ConsumesInput<Inst>() ? InputCount : 0);
-      if constexpr (UpdateAmount < 0) {
-        value_stack_head -= -UpdateAmount;
-      } else {
-        value_stack_head += UpdateAmount;
-      }
       vs_left -= UpdateAmount;
 
       ip += ImmediateValueCount<Inst>() + 1;
       NTH_ATTRIBUTE(tailcall)
       return ip->as<internal::exec_fn_type>()(value_stack_head, vs_left, ip,
-                                              call_stack, cs_left);
+                                              call_stack, cs_left, top);
     }
   }
 }
@@ -452,23 +1069,35 @@ constexpr nth::Type auto FunctionState() {
 
 template <typename I>
 constexpr bool ImmediateValueDetermined() {
-  return nth::type<I> != nth::type<hop::Jump> and
-         nth::type<I> != nth::type<hop::JumpIf> and
-         nth::type<I> != nth::type<hop::JumpIfNot> and
-         not std::derived_from<
-             nth::type_t<
-                 internal::InstructionFunctionType<I>()
-                     .parameters()
-                     .template get<FunctionState<I>() != nth::type<void>>()>,
-             internal::InputBase>;
+  if constexpr (internal::FusedInstruction<I>()) {
+    return false;
+  } else {
+    return nth::type<I> != nth::type<hop::Jump> and
+           nth::type<I> != nth::type<hop::JumpIf> and
+           nth::type<I> != nth::type<hop::JumpIfNot> and
+           nth::type<I> != nth::type<hop::Switch> and
+           not std::derived_from<
+               nth::type_t<
+                   internal::InstructionFunctionType<I>()
+                       .parameters()
+                       .template get<FunctionState<I>() != nth::type<void>>()>,
+               internal::InputBase>;
+  }
 }
 
 template <typename I>
 constexpr size_t ImmediateValueCount() {
-  if constexpr (nth::any_of<I, Return>) {
+  if constexpr (nth::any_of<I, Return, Yield>) {
     return 0;
-  } else if constexpr (nth::any_of<I, Call, Jump, JumpIf, JumpIfNot>) {
+  } else if constexpr (nth::any_of<I, Call, Jump, JumpIf, JumpIfNot,
+                                   TailCall>) {
     return 1;
+  } else if constexpr (nth::any_of<I, CallDirect, Switch>) {
+    return 2;
+  } else if constexpr (internal::FusedInstruction<I>()) {
+    return I::fused_instructions.reduce([](auto... ts) {
+      return (size_t{0} + ... + ImmediateValueCount<nth::type_t<ts>>());
+    });
   } else {
     return internal::InstructionFunctionType<I>().parameters().size() -
            (FunctionState<I>() == nth::type<void> ? 2 : 3) +
@@ -478,10 +1107,13 @@ constexpr size_t ImmediateValueCount() {
 
 template <typename I>
 constexpr size_t ParameterCount() {
-  if constexpr (nth::any_of<I, Jump, Return>) {
+  if constexpr (nth::any_of<I, Jump, Return, CallDirect, Yield>) {
     return 0;
-  } else if constexpr (nth::any_of<I, Call, JumpIf, JumpIfNot>) {
+  } else if constexpr (nth::any_of<I, Call, JumpIf, JumpIfNot, Switch,
+                                   TailCall>) {
     return 1;
+  } else if constexpr (internal::FusedInstruction<I>()) {
+    return internal::FusedStackEffect<I>().required;
   } else {
     constexpr auto parameters =
         internal::InstructionFunctionType<I>().parameters();
@@ -496,19 +1128,42 @@ constexpr size_t ParameterCount() {
 
 template <typename I>
 constexpr bool ConsumesInput() {
-  if constexpr (nth::any_of<I, JumpIf, JumpIfNot, Call>) {
+  if constexpr (nth::any_of<I, JumpIf, JumpIfNot, Switch, Call, TailCall>) {
+    return true;
+  } else if constexpr (internal::FusedInstruction<I>()) {
     return true;
   } else {
     return requires { &I::consume; };
   }
 }
 
+template <typename I>
+constexpr bool PureInstruction() {
+  if constexpr (internal::BuiltinInstruction<I>() or
+                internal::FusedInstruction<I>()) {
+    return false;
+  } else if constexpr (ImmediateValueDetermined<I>() or
+                       FunctionState<I>() != nth::type<void>) {
+    return false;
+  } else if constexpr (requires {
+                         { I::pure } -> std::convertible_to<bool>;
+                       }) {
+    return I::pure;
+  } else {
+    return false;
+  }
+}
+
 template <typename I>
 constexpr size_t ReturnCount() {
-  if constexpr (nth::any_of<I, Jump, Return, JumpIf, JumpIfNot>) {
+  if constexpr (nth::any_of<I, Jump, Return, JumpIf, JumpIfNot, Switch,
+                            Yield>) {
     return 0;
-  } else if constexpr (nth::type<I> == nth::type<Call>) {
+  } else if constexpr (nth::any_of<I, Call, CallDirect, TailCall>) {
     return -1;
+  } else if constexpr (internal::FusedInstruction<I>()) {
+    constexpr internal::StackEffect effect = internal::FusedStackEffect<I>();
+    return effect.required + effect.net;
   } else {
     constexpr auto parameters =
         internal::InstructionFunctionType<I>().parameters();
@@ -526,6 +1181,69 @@ std::string_view InstructionName() {
   return nth::type<I>.name();
 }
 
+namespace internal {
+
+template <typename I>
+constexpr void AccumulateStackEffect(StackEffect &effect) {
+  ptrdiff_t in    = ParameterCount<I>();
+  ptrdiff_t out   = ReturnCount<I>();
+  effect.required = std::max(effect.required, in - effect.net);
+  effect.net += out - (ConsumesInput<I>() ? in : 0);
+  effect.max_growth = std::max(effect.max_growth, effect.net);
+}
+
+template <typename I>
+constexpr StackEffect FusedStackEffect() {
+  return I::fused_instructions.reduce([](auto... ts) {
+    StackEffect effect{.required = 0, .max_growth = 0, .net = 0};
+    (AccumulateStackEffect<nth::type_t<ts>>(effect), ...);
+    return effect;
+  });
+}
+
+template <typename I>
+constexpr nth::Sequence auto ImmediateValueTypes() {
+  if constexpr (nth::any_of<I, Jump, JumpIf, JumpIfNot>) {
+    return nth::type_sequence<ptrdiff_t>;
+  } else if constexpr (nth::type<I> == nth::type<Switch>) {
+    return nth::type_sequence<uint64_t, size_t>;
+  } else if constexpr (FusedInstruction<I>()) {
+    return I::fused_instructions.reduce([](auto... ts) {
+      return (nth::type_sequence<> + ... +
+              ImmediateValueTypes<nth::type_t<ts>>());
+    });
+  } else {
+    return InstructionFunctionType<I>().parameters().template drop<
+        (::hop::FunctionState<I>() != nth::type<void>) + 2>();
+  }
+}
+
+template <typename I>
+constexpr bool FusableBody() {
+  if constexpr (BuiltinInstruction<I>() or FusedInstruction<I>()) {
+    return false;
+  } else {
+    return not ::hop::ImmediateValueDetermined<I>();
+  }
+}
+
+template <typename... Is>
+constexpr bool FusableSequence() {
+  if constexpr (sizeof...(Is) < 2) {
+    return false;
+  } else {
+    constexpr bool fusable[] = {FusableBody<Is>()...};
+    using last = nth::type_t<
+        nth::type_sequence<Is...>.template get<sizeof...(Is) - 1>()>;
+    return std::all_of(std::begin(fusable), std::end(fusable) - 1,
+                       [](bool b) { return b; }) and
+           (fusable[sizeof...(Is) - 1] or
+            nth::any_of<last, Jump, JumpIf, JumpIfNot>);
+  }
+}
+
+}  // namespace internal
+
 }  // namespace hop
 
 #endif  // JASMIN_CORE_INSTRUCTION_H
@@ -35,8 +35,12 @@ struct ReturnsMultiple : Instruction<ReturnsMultiple> {
 NTH_TEST("immediate-value-count") {
   NTH_EXPECT(ImmediateValueCount<Return>() == size_t{0});
   NTH_EXPECT(ImmediateValueCount<Call>() == size_t{1});
+  NTH_EXPECT(ImmediateValueCount<CallDirect>() == size_t{2});
+  NTH_EXPECT(ImmediateValueCount<TailCall>() == size_t{1});
+  NTH_EXPECT(ImmediateValueCount<Yield>() == size_t{0});
   NTH_EXPECT(ImmediateValueCount<Jump>() == size_t{1});
   NTH_EXPECT(ImmediateValueCount<JumpIf>() == size_t{1});
+  NTH_EXPECT(ImmediateValueCount<Switch>() == size_t{2});
   NTH_EXPECT(ImmediateValueCount<Count>() == size_t{0});
   NTH_EXPECT(ImmediateValueCount<NoImmediates>() == size_t{0});
   NTH_EXPECT(ImmediateValueCount<NoImmediatesOrValues>() == size_t{0});
@@ -46,8 +50,12 @@ NTH_TEST("immediate-value-count") {
 NTH_TEST("consumes-input") {
   NTH_EXPECT(not ConsumesInput<Return>());
   NTH_EXPECT(ConsumesInput<Call>());
+  NTH_EXPECT(not ConsumesInput<CallDirect>());
+  NTH_EXPECT(ConsumesInput<TailCall>());
+  NTH_EXPECT(not ConsumesInput<Yield>());
   NTH_EXPECT(not ConsumesInput<Jump>());
   NTH_EXPECT(ConsumesInput<JumpIf>());
+  NTH_EXPECT(ConsumesInput<Switch>());
   NTH_EXPECT(not ConsumesInput<Count>());
   NTH_EXPECT(not ConsumesInput<NoImmediates>());
   NTH_EXPECT(not ConsumesInput<NoImmediatesOrValues>());
@@ -58,6 +66,7 @@ NTH_TEST("return-count") {
   NTH_EXPECT(ReturnCount<Return>() == size_t{0});
   NTH_EXPECT(ReturnCount<Jump>() == size_t{0});
   NTH_EXPECT(ReturnCount<JumpIf>() == size_t{0});
+  NTH_EXPECT(ReturnCount<Switch>() == size_t{0});
   NTH_EXPECT(ReturnCount<Count>() == size_t{1});
   NTH_EXPECT(ReturnCount<NoImmediates>() == size_t{1});
   NTH_EXPECT(ReturnCount<NoImmediatesOrValues>() == size_t{0});
@@ -65,5 +74,19 @@ NTH_TEST("return-count") {
   NTH_EXPECT(ReturnCount<ReturnsMultiple>() == size_t{2});
 }
 
+NTH_TEST("fused") {
+  using F = Fused<SomeImmediates, NoImmediates, JumpIf>;
+  NTH_EXPECT(ImmediateValueCount<F>() == size_t{3});
+  NTH_EXPECT(ParameterCount<F>() == size_t{2});
+  NTH_EXPECT(ReturnCount<F>() == size_t{2});
+  NTH_EXPECT(ConsumesInput<F>());
+  NTH_EXPECT(not ImmediateValueDetermined<F>());
+
+  using G = Fused<ReturnsMultiple, NoImmediates>;
+  NTH_EXPECT(ImmediateValueCount<G>() == size_t{0});
+  NTH_EXPECT(ParameterCount<G>() == size_t{0});
+  NTH_EXPECT(ReturnCount<G>() == size_t{3});
+}
+
 }  // namespace
 }  // namespace hop
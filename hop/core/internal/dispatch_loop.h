@@ -0,0 +1,327 @@
+#ifndef JASMIN_CORE_INTERNAL_DISPATCH_LOOP_H
+#define JASMIN_CORE_INTERNAL_DISPATCH_LOOP_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "hop/core/instruction.h"
+#include "hop/core/internal/frame.h"
+#include "hop/core/internal/function_base.h"
+#include "hop/core/internal/function_state.h"
+#include "hop/core/internal/instruction_traits.h"
+#include "hop/core/value.h"
+#include "nth/base/indestructible.h"
+#include "nth/container/stack.h"
+#include "nth/debug/debug.h"
+#include "nth/meta/type.h"
+
+// An alternative to the tail-call threaded interpreter implemented by
+// `Instruction<Inst>::ExecuteImpl`. Rather than each instruction tail-calling
+// the next, a single function containing the body of every instruction in the
+// instruction set dispatches between them with computed gotos. The bytecode is
+// identical: op-codes remain pointers to `ExecuteImpl` instantiations, which
+// are decoded into indices in the instruction set with a perfect hash.
+//
+// The dispatch loop is used by `Function<Set>::invoke` when the
+// `//hop/configuration:dispatch` flag is set to "computed_goto". Resumable
+// executions (see "hop/core/continuation.h") and batched invocations are
+// always executed by the tail-call threaded interpreter.
+
+namespace hop::internal {
+
+// The maximum number of instructions in an instruction set executable by the
+// dispatch loop.
+inline constexpr size_t DispatchLoopCapacity = 128;
+
+#define JASMIN_INTERNAL_DISPATCH_LOOP_REPEAT(M)                               \
+  M(0) M(1) M(2) M(3) M(4) M(5) M(6) M(7) M(8) M(9) M(10) M(11) M(12) M(13)    \
+  M(14) M(15) M(16) M(17) M(18) M(19) M(20) M(21) M(22) M(23) M(24) M(25)      \
+  M(26) M(27) M(28) M(29) M(30) M(31) M(32) M(33) M(34) M(35) M(36) M(37)      \
+  M(38) M(39) M(40) M(41) M(42) M(43) M(44) M(45) M(46) M(47) M(48) M(49)      \
+  M(50) M(51) M(52) M(53) M(54) M(55) M(56) M(57) M(58) M(59) M(60) M(61)      \
+  M(62) M(63) M(64) M(65) M(66) M(67) M(68) M(69) M(70) M(71) M(72) M(73)      \
+  M(74) M(75) M(76) M(77) M(78) M(79) M(80) M(81) M(82) M(83) M(84) M(85)      \
+  M(86) M(87) M(88) M(89) M(90) M(91) M(92) M(93) M(94) M(95) M(96) M(97)      \
+  M(98) M(99) M(100) M(101) M(102) M(103) M(104) M(105) M(106) M(107) M(108)   \
+  M(109) M(110) M(111) M(112) M(113) M(114) M(115) M(116) M(117) M(118)        \
+  M(119) M(120) M(121) M(122) M(123) M(124) M(125) M(126) M(127)
+
+// Maps op-codes of the instruction set `Set` to the index of the corresponding
+// instruction in `Set::instructions`. Both the checked and unchecked variants
+// of each instruction (see `Instruction::ExecuteImpl`) map to the same index.
+// The handler addresses are only known at run-time, so the multiplier is
+// chosen on first use such that no two handlers collide.
+template <typename Set>
+struct OpCodeDecoder {
+  uint8_t operator()(Value const *ip) const {
+    return indices[(reinterpret_cast<uintptr_t>(ip->as<exec_fn_type>()) *
+                    multiplier) >>
+                   shift];
+  }
+
+  uint64_t multiplier;
+  int shift;
+  std::vector<uint8_t> indices;
+};
+
+template <typename Set>
+OpCodeDecoder<Set> const &Decoder() {
+  static nth::indestructible<OpCodeDecoder<Set>> decoder = [] {
+    std::vector<std::pair<uintptr_t, uint8_t>> handlers;
+    Set::instructions.reduce([&](auto... is) {
+      uint8_t index = 0;
+      ((handlers.emplace_back(
+            reinterpret_cast<uintptr_t>(
+                &nth::type_t<is>::template ExecuteImpl<Set>),
+            index),
+        handlers.emplace_back(
+            reinterpret_cast<uintptr_t>(
+                &nth::type_t<is>::template ExecuteImpl<Set, false>),
+            index++)),
+       ...);
+      return 0;
+    });
+
+    OpCodeDecoder<Set> d;
+    size_t table_size = std::bit_ceil(4 * handlers.size());
+    // A sequence of odd multipliers generated by a SplitMix64 generator, so
+    // that decoders are reproducible for a given set of handler addresses.
+    uint64_t state = 0;
+    while (true) {
+      for (int attempt = 0; attempt < 64; ++attempt) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15);
+        z          = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z          = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        d.multiplier = (z ^ (z >> 31)) | 1;
+        d.shift      = 64 - std::countr_zero(table_size);
+
+        std::vector<uintptr_t> keys(table_size, 0);
+        d.indices.assign(table_size, 0);
+        bool collision = false;
+        for (auto [handler, index] : handlers) {
+          size_t slot = (handler * d.multiplier) >> d.shift;
+          if (keys[slot] != 0 and keys[slot] != handler) {
+            collision = true;
+            break;
+          }
+          keys[slot]      = handler;
+          d.indices[slot] = index;
+        }
+        if (not collision) { return d; }
+      }
+      table_size *= 2;
+    }
+  }();
+  return *decoder;
+}
+
+// Ensures that at least `n` more values fit on the value stack whose head is
+// `value_stack_head`, growing it if necessary.
+inline void ReserveValues(Value *&value_stack_head, size_t &vs_left,
+                          size_t n) {
+  if (vs_left >= n) [[likely]] { return; }
+  auto v = nth::stack<Value>::reconstitute_from(value_stack_head, vs_left);
+  v.reserve(std::max(v.capacity() * 2, v.size() + n));
+  std::tie(value_stack_head, vs_left) = std::move(v).release();
+}
+
+// The state of an execution by the dispatch loop. As with the tail-call
+// threaded interpreter, frames on the call stack store the address of the
+// instruction to which `Return` resumes.
+template <typename Set>
+struct DispatchLoopState {
+  using frame_type = Frame<FunctionState<Set>>;
+
+  FrameBase *frame_end() { return &call_stack.top() + 1; }
+
+  // Pushes a frame for `callee`, called by the instruction at `ip`, onto the
+  // call stack from which `Return` will resume execution at `return_address`.
+  void push_frame(FunctionBase const *callee, Value const *return_address) {
+    UnpublishExecution();
+    call_stack.emplace();
+    call_stack.top().ip = return_address;
+    RecordCallSite(call_stack.top().call_site, ip);
+    EnterCall(call_stack.top().latency, callee);
+    PublishFramesBegin(&call_stack.top() + 1 - call_stack.size());
+  }
+
+  Value *value_stack_head;
+  size_t vs_left;
+  Value const *ip;
+  nth::stack<frame_type> &call_stack;
+};
+
+// Executes the instruction `Inst` at `s.ip` and advances `s.ip` to the next
+// instruction to be executed. Returns `false` if `Inst` returned from the
+// outermost function, and `true` otherwise.
+template <typename Inst, typename Set>
+bool DispatchLoopExecute(DispatchLoopState<Set> &s) {
+  constexpr auto inst_type = nth::type<Inst>;
+  CountExecution<Inst, Set>();
+  PublishExecution(s.ip, s.frame_end());
+  if constexpr (inst_type == nth::type<Call>) {
+    auto const *f = (--s.value_stack_head)->as<FunctionBase const *>();
+    ++s.vs_left;
+    s.push_frame(f, s.ip + 1 + ImmediateValueCount<Call>());
+    s.ip = f->entry();
+  } else if constexpr (inst_type == nth::type<CallDirect>) {
+    auto const *f = (s.ip + 2)->as<FunctionBase const *>();
+    s.push_frame(f, s.ip + 1 + ImmediateValueCount<CallDirect>());
+    s.ip = f->entry();
+  } else if constexpr (inst_type == nth::type<TailCall>) {
+    auto const *f = (--s.value_stack_head)->as<FunctionBase const *>();
+    ++s.vs_left;
+    ExitCall(s.call_stack.top().latency);
+    ResetState(s.call_stack.top());
+    EnterCall(s.call_stack.top().latency, f);
+    s.ip = f->entry();
+  } else if constexpr (inst_type == nth::type<Jump>) {
+    s.ip += (s.ip + 1)->as<ptrdiff_t>();
+  } else if constexpr (nth::any_of<Inst, JumpIf, JumpIfNot>) {
+    constexpr bool JumpWhen = (inst_type == nth::type<JumpIf>);
+    ++s.vs_left;
+    if ((--s.value_stack_head)->as<bool>() == JumpWhen) {
+      s.ip += (s.ip + 1)->as<ptrdiff_t>();
+    } else {
+      s.ip += 2;
+    }
+  } else if constexpr (inst_type == nth::type<Switch>) {
+    ++s.vs_left;
+    Value const *entry =
+        SwitchEntry(s.ip, (--s.value_stack_head)->raw_value());
+    s.ip = entry + (entry + 1)->as<ptrdiff_t>();
+  } else if constexpr (inst_type == nth::type<Return>) {
+    s.ip = s.call_stack.top().ip;
+    ExitCall(s.call_stack.top().latency);
+    s.call_stack.pop();
+    return not s.call_stack.empty();
+  } else if constexpr (inst_type == nth::type<Yield>) {
+    // Executions which may yield must be run by `Continuation`, which always
+    // uses the tail-call threaded interpreter, so reaching `Yield` here means
+    // that a function containing it was invoked directly. There is no way to
+    // continue, and this must not depend on checks which may be compiled out,
+    // so we abort unconditionally.
+    std::fprintf(stderr, "Yield requires Continuation.\n");
+    std::abort();
+  } else if constexpr (FusedInstruction<Inst>()) {
+    constexpr StackEffect effect = FusedStackEffect<Inst>();
+    ReserveValues(s.value_stack_head, s.vs_left,
+                  static_cast<size_t>(effect.max_growth));
+
+    constexpr auto fused    = Inst::fused_instructions;
+    constexpr auto last     = fused.template get<fused.size() - 1>();
+    constexpr bool Branches = nth::any_of<nth::type_t<last>, Jump, JumpIf,
+                                          JumpIfNot>;
+    Value const *immediates = s.ip + 1;
+    FrameBase *frame_end    = s.frame_end();
+    [&]<size_t... Ns>(std::index_sequence<Ns...>) {
+      ((s.value_stack_head =
+            ExecuteBody<nth::type_t<fused.template get<Ns>()>, Set>(
+                s.value_stack_head, immediates, frame_end),
+        immediates +=
+        ImmediateValueCount<nth::type_t<fused.template get<Ns>()>>()),
+       ...);
+    }
+    (std::make_index_sequence<fused.size() - Branches>{});
+    s.vs_left -= effect.net;
+
+    if constexpr (last == nth::type<Jump>) {
+      s.ip += immediates->as<ptrdiff_t>();
+    } else if constexpr (nth::any_of<nth::type_t<last>, JumpIf, JumpIfNot>) {
+      constexpr bool JumpWhen = (last == nth::type<JumpIf>);
+      if ((--s.value_stack_head)->as<bool>() == JumpWhen) {
+        s.ip += immediates->as<ptrdiff_t>();
+      } else {
+        s.ip += 1 + ImmediateValueCount<Inst>();
+      }
+    } else {
+      s.ip += 1 + ImmediateValueCount<Inst>();
+    }
+  } else if constexpr (ImmediateValueDetermined<Inst>()) {
+    auto [ins, outs] = (s.ip + 1)->as<InstructionSpecification>();
+    ReserveValues(s.value_stack_head, s.vs_left, outs);
+    s.value_stack_head = ExecuteDeterminedBody<Inst, Set>(
+        s.value_stack_head, s.ip + 1, s.frame_end());
+    if constexpr (ConsumesInput<Inst>()) { s.vs_left += ins; }
+    s.vs_left -= outs;
+    s.ip += 1 + ImmediateValueCount<Inst>();
+  } else {
+    constexpr size_t InputCount  = ParameterCount<Inst>();
+    constexpr size_t OutputCount = ReturnCount<Inst>();
+    constexpr size_t Consumed    = ConsumesInput<Inst>() ? InputCount : 0;
+    if constexpr (OutputCount > Consumed) {
+      ReserveValues(s.value_stack_head, s.vs_left, OutputCount - Consumed);
+    }
+    s.value_stack_head =
+        ExecuteBody<Inst, Set>(s.value_stack_head, s.ip + 1, s.frame_end());
+    s.vs_left += Consumed;
+    s.vs_left -= OutputCount;
+    s.ip += 1 + ImmediateValueCount<Inst>();
+  }
+  return true;
+}
+
+// Executes the function whose first instruction is `ip` with the dispatch
+// loop. The value stack is given by a pointer one past its top value and the
+// number of values that fit before it must grow, both of which are updated
+// upon completion. `call_stack` must be empty, and is again empty upon
+// completion.
+template <typename Set>
+void RunDispatchLoop(Value *&value_stack_head, size_t &vs_left,
+                     nth::stack<Frame<FunctionState<Set>>> &call_stack,
+                     Value const *ip) {
+  constexpr size_t Count = Set::instructions.size();
+  static_assert(Count <= DispatchLoopCapacity,
+                "Instruction set too large for the dispatch loop.");
+
+  OpCodeDecoder<Set> const &decoder = Decoder<Set>();
+  DispatchLoopState<Set> s{
+      .value_stack_head = value_stack_head,
+      .vs_left          = vs_left,
+      .ip               = ip,
+      .call_stack       = call_stack,
+  };
+  call_stack.emplace();
+  SampledExecutionScope<Frame<FunctionState<Set>>> sampled(&call_stack.top());
+
+#define JASMIN_INTERNAL_DISPATCH_LOOP_ADDRESS(n) &&instruction_##n,
+  static void *const Labels[] = {
+      JASMIN_INTERNAL_DISPATCH_LOOP_REPEAT(
+          JASMIN_INTERNAL_DISPATCH_LOOP_ADDRESS)};
+#undef JASMIN_INTERNAL_DISPATCH_LOOP_ADDRESS
+
+  goto *Labels[decoder(s.ip)];
+
+  // Each instruction dispatches directly to its successor, so that each
+  // indirect branch is predicted independently.
+#define JASMIN_INTERNAL_DISPATCH_LOOP_LABEL(n)                                 \
+  instruction_##n : if constexpr (n < Count) {                                 \
+    if (DispatchLoopExecute<                                                   \
+            nth::type_t<Set::instructions.template get<n>()>, Set>(s)) {       \
+      goto *Labels[decoder(s.ip)];                                             \
+    }                                                                          \
+    goto finish;                                                               \
+  }                                                                            \
+  else {                                                                       \
+    __builtin_unreachable();                                                   \
+  }
+  JASMIN_INTERNAL_DISPATCH_LOOP_REPEAT(JASMIN_INTERNAL_DISPATCH_LOOP_LABEL)
+#undef JASMIN_INTERNAL_DISPATCH_LOOP_LABEL
+
+finish:
+  value_stack_head = s.value_stack_head;
+  vs_left          = s.vs_left;
+}
+
+#undef JASMIN_INTERNAL_DISPATCH_LOOP_REPEAT
+
+}  // namespace hop::internal
+
+#endif  // JASMIN_CORE_INTERNAL_DISPATCH_LOOP_H
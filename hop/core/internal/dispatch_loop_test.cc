@@ -0,0 +1,83 @@
+#include "hop/core/internal/dispatch_loop.h"
+
+#include "hop/core/function.h"
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "hop/testing/fibonacci.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop::internal {
+namespace {
+
+using PushSubtract = Fused<Push<uint64_t>, Subtract<uint64_t>>;
+
+using Instructions =
+    MakeInstructionSet<Duplicate, Swap, Push<uint64_t>, Push<Function<> *>,
+                       LessThan<uint64_t>, Add<uint64_t>, Subtract<uint64_t>,
+                       PushSubtract>;
+
+template <typename Set>
+void Run(Function<Set> const &f, nth::stack<Value> &value_stack) {
+  nth::stack<Frame<FunctionState<Set>>> call_stack;
+  auto [head, left] = std::move(value_stack).release();
+  RunDispatchLoop<Set>(head, left, call_stack, f.entry());
+  value_stack = nth::stack<Value>::reconstitute_from(head, left);
+}
+
+NTH_TEST("dispatch-loop/decoder") {
+  auto const &decoder = Decoder<Instructions>();
+  Function<Instructions> f(1, 1);
+  f.append<Duplicate>();
+  f.append<Add<uint64_t>>();
+  f.append<Return>();
+  std::span insts = f.raw_instructions();
+  NTH_EXPECT(decoder(&insts[0]) == 8);
+  NTH_EXPECT(decoder(&insts[1]) == 13);
+  NTH_EXPECT(decoder(&insts[2]) == 4);
+
+  f.finalize();
+  insts = f.raw_instructions();
+  NTH_EXPECT(decoder(&insts[0]) == 8);
+  NTH_EXPECT(decoder(&insts[1]) == 13);
+  NTH_EXPECT(decoder(&insts[2]) == 4);
+}
+
+NTH_TEST("dispatch-loop/fibonacci") {
+  for (FibonacciCall call : {FibonacciCall::Indirect, FibonacciCall::Direct}) {
+    Function<Instructions> f(1, 1);
+    BuildFibonacci(f, call);
+
+    for (uint64_t n : {0, 1, 2, 10, 20}) {
+      nth::stack<Value> loop = {n};
+      Run(f, loop);
+      nth::stack<Value> threaded = {n};
+      f.invoke(threaded);
+      NTH_ASSERT(loop.size() == size_t{1});
+      NTH_EXPECT(loop.top().as<uint64_t>() ==
+                 threaded.top().as<uint64_t>());
+    }
+  }
+}
+
+NTH_TEST("dispatch-loop/tail-call") {
+  Function<Instructions> f(1, 1);
+  f.append<Duplicate>();
+  f.append<Push<uint64_t>>(1);
+  f.append<LessThan<uint64_t>>();
+  auto jump = f.append_with_placeholders<JumpIf>();
+  f.append<PushSubtract>(1);
+  f.append<Push<Function<> *>>(&f);
+  f.append<TailCall>({.parameters = 1, .returns = 1});
+  auto ret = f.append<Return>();
+  f.set_value(jump, 0, ret.lower_bound() - jump.lower_bound());
+
+  nth::stack<Value> stack = {uint64_t{1'000'000}};
+  Run(f, stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{0});
+}
+
+}  // namespace
+}  // namespace hop::internal
@@ -3,12 +3,48 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <type_traits>
 
+#include "hop/configuration/configuration.h"
 #include "hop/core/value.h"
 
 namespace hop::internal {
+
+// The function called and the time at which it was called, held in the
+// callee's frame so that the latency of the call may be recorded when it
+// returns. Only present when latency measurement is enabled.
+struct CallTimestamp {
+  void const *callee = nullptr;
+  uint64_t entered;
+};
+struct NoCallTimestamp {};
+using CallLatency =
+    std::conditional_t<measure_latency, CallTimestamp, NoCallTimestamp>;
+
+// The call instruction which pushed a frame, held in the frame so that the
+// sampling profiler may attribute samples to call sites. Only present when
+// sampling is enabled.
+struct CallSite {
+  Value const *call = nullptr;
+};
+struct NoCallSite {};
+using SampledCallSite = std::conditional_t<sampling, CallSite, NoCallSite>;
+
+inline void RecordCallSite(CallSite &site, Value const *call) {
+  site.call = call;
+}
+inline void RecordCallSite(NoCallSite &, Value const *) {}
+
+// Returns the call instruction recorded in `site`, or null if call sites are
+// not recorded.
+inline Value const *RecordedCallSite(CallSite const &site) { return site.call; }
+inline Value const *RecordedCallSite(NoCallSite const &) { return nullptr; }
+
 struct FrameBase {
+  // The instruction at which `Return` resumes execution of the caller.
   Value const *ip;
+  [[no_unique_address]] CallLatency latency;
+  [[no_unique_address]] SampledCallSite call_site;
 };
 
 template <typename StateType>
@@ -19,8 +55,24 @@ struct Frame : FrameBase {
 template <>
 struct Frame<void> : FrameBase {};
 
+// Restores the state held in `frame` to that of a newly constructed frame.
+// Because function state is constructed lazily, only state which has been
+// used is destroyed.
+template <typename StateType>
+void ResetState(Frame<StateType> &frame) {
+  if constexpr (not std::is_void_v<StateType>) { frame.state.reset(); }
+}
+
+struct NoCachedValue {};
+
+// The type of the value on top of the value stack as passed between
+// instructions. If the top-of-stack cache is disabled, the top of the stack is
+// held in memory along with the rest of the stack, and this type is empty.
+using CachedValue =
+    std::conditional_t<cache_top_of_stack, Value, NoCachedValue>;
+
 using exec_fn_type = void (*)(Value *, size_t, Value const *, FrameBase *,
-                              uint64_t);
+                              uint64_t, CachedValue);
 
 }  // namespace hop::internal
 
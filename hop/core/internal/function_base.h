@@ -1,9 +1,14 @@
 #ifndef JASMIN_CORE_INTERNAL_FUNCTION_BASE_H
 #define JASMIN_CORE_INTERNAL_FUNCTION_BASE_H
 
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
 #include <span>
+#include <utility>
 #include <vector>
 
+#include "hop/core/guarded_value_stack.h"
 #include "hop/core/instruction_index.h"
 #include "hop/core/internal/frame.h"
 #include "hop/core/internal/function_state.h"
@@ -14,6 +19,84 @@
 
 namespace hop::internal {
 
+// Holds the instructions of a function. Ordinarily the instructions are owned,
+// but they may instead be relocated into storage owned elsewhere (see
+// `ProgramFragment::freeze`). Any operation changing the number of
+// instructions first copies relocated instructions back into owned storage.
+// Copies always own their instructions.
+struct RelocatableInstructions {
+  explicit RelocatableInstructions(Value v) : owned_{v}, code_(owned_) {}
+  // Takes ownership of `values` without copying them. The first element of
+  // `values` is a placeholder, which is replaced by `v`.
+  explicit RelocatableInstructions(Value v, std::vector<Value> values)
+      : owned_(std::move(values)), code_(owned_) {
+    NTH_REQUIRE((harden), not owned_.empty());
+    owned_[0] = v;
+  }
+
+  RelocatableInstructions(RelocatableInstructions const &r)
+      : owned_(r.code_.begin(), r.code_.end()), code_(owned_) {}
+  RelocatableInstructions(RelocatableInstructions &&r)
+      : owned_(std::move(r.owned_)), code_(std::exchange(r.code_, {})) {}
+
+  RelocatableInstructions &operator=(RelocatableInstructions const &r) {
+    if (this != &r) {
+      owned_.assign(r.code_.begin(), r.code_.end());
+      code_ = owned_;
+    }
+    return *this;
+  }
+  RelocatableInstructions &operator=(RelocatableInstructions &&r) {
+    owned_ = std::move(r.owned_);
+    code_  = std::exchange(r.code_, {});
+    return *this;
+  }
+
+  constexpr std::span<Value> span() const { return code_; }
+  bool relocated() const { return code_.data() != owned_.data(); }
+
+  // Copies the instructions into `storage`, which must be of the same size,
+  // and releases any owned storage.
+  void relocate(std::span<Value> storage) {
+    NTH_REQUIRE((harden), storage.size() == code_.size());
+    std::copy(code_.begin(), code_.end(), storage.begin());
+    std::vector<Value>().swap(owned_);
+    code_ = storage;
+  }
+
+  void reserve(size_t capacity) {
+    own();
+    owned_.reserve(capacity);
+    code_ = owned_;
+  }
+
+  void push_back(Value v) {
+    own();
+    owned_.push_back(v);
+    code_ = owned_;
+  }
+
+  void append(std::span<Value const> range) {
+    own();
+    owned_.insert(owned_.end(), range.begin(), range.end());
+    code_ = owned_;
+  }
+
+  void append_uninitialized(size_t count) {
+    own();
+    owned_.resize(owned_.size() + count, Value::Uninitialized());
+    code_ = owned_;
+  }
+
+ private:
+  void own() {
+    if (relocated()) { owned_.assign(code_.begin(), code_.end()); }
+  }
+
+  std::vector<Value> owned_;
+  std::span<Value> code_;
+};
+
 // `FunctionBase` is the base class for any function-type defined via Hop's
 // infrastructure. Op-codes are only meaningful in the presence of an
 // instruction table (they indicate which instruction in the table is intended),
@@ -23,9 +106,25 @@ namespace hop::internal {
 struct FunctionBase {
   // Constructs a `FunctionBase` representing a function that accepts
   // `parameter_count` parameters and returns `return_count` values.
-  explicit FunctionBase(uint32_t parameter_count, uint32_t return_count,
-                        void (*invoke)(nth::stack<Value> &, Value const *))
+  explicit FunctionBase(
+      uint32_t parameter_count, uint32_t return_count,
+      void (*invoke)(nth::stack<Value> &, Value const *, bool),
+      void (*guarded_invoke)(GuardedValueStack &, Value const *, bool))
       : instructions_{invoke},
+        guarded_invoke_(guarded_invoke),
+        parameter_count_(parameter_count),
+        return_count_(return_count) {}
+
+  // Constructs a `FunctionBase` as above whose instructions are those in
+  // `instructions` after the first, which is a placeholder for internal use.
+  // The instructions are adopted rather than copied.
+  explicit FunctionBase(
+      uint32_t parameter_count, uint32_t return_count,
+      void (*invoke)(nth::stack<Value> &, Value const *, bool),
+      void (*guarded_invoke)(GuardedValueStack &, Value const *, bool),
+      std::vector<Value> instructions)
+      : instructions_(invoke, std::move(instructions)),
+        guarded_invoke_(guarded_invoke),
         parameter_count_(parameter_count),
         return_count_(return_count) {}
 
@@ -35,25 +134,97 @@ struct FunctionBase {
   // Returns the number of values this function returns.
   constexpr uint32_t return_count() const { return return_count_; }
 
+  // Returns the maximum number of values, including its parameters, that this
+  // function may hold on the value stack at once. Only finalized functions
+  // (see `Function<Set>::finalize`) know their maximum stack depth; for all
+  // others, this is zero.
+  constexpr uint32_t max_stack_depth() const { return max_stack_depth_; }
+
   // Returns a pointer to the first instruction in this function.
-  constexpr Value const *entry() const { return instructions_.data() + 1; }
+  constexpr Value const *entry() const {
+    return instructions_.span().data() + 1;
+  }
 
-  // Invoke the function with arguments provided via `value_stack`.
+  // Invoke the function with arguments provided via `value_stack`. If the
+  // function has a compact encoding (see "hop/core/compact.h"), the compact
+  // encoding is executed.
   constexpr void invoke(nth::stack<Value> &value_stack) const {
-    instructions_.data()->as<void (*)(nth::stack<Value> &, Value const *)>()(
-        value_stack, entry());
+    if (max_stack_depth_ > parameter_count_) {
+      // One more value than is needed by the function itself may be placed on
+      // the stack when the top-of-stack cache is enabled.
+      value_stack.reserve(value_stack.size() + 1 + max_stack_depth_ -
+                          parameter_count_);
+    }
+    if (compact_invoke_) {
+      compact_invoke_(value_stack, compact_entry());
+    } else {
+      // Any value beneath the arguments can serve as the value beneath the
+      // top-of-stack cache, sparing the need to move the stack's contents.
+      instructions_.span()[0]
+          .as<void (*)(nth::stack<Value> &, Value const *, bool)>()(
+              value_stack, entry(), value_stack.size() > parameter_count_);
+    }
+  }
+
+  // Invoke the function with arguments provided via `value_stack`. Because a
+  // `GuardedValueStack` never needs to grow, no instruction executed this way
+  // reallocates the value stack. Instructions of a function which has not been
+  // finalized (see `Function<Set>::finalize`) still check the stack's capacity,
+  // though the check always succeeds; only finalized functions execute without
+  // per-instruction checks. The compact encoding, if any, is not used.
+  void invoke(GuardedValueStack &value_stack) const {
+    guarded_invoke_(value_stack, entry(),
+                    value_stack.size() > parameter_count_);
+  }
+
+  // Returns a pointer to the first instruction in the compact encoding of this
+  // function, or a null pointer if the function has no compact encoding.
+  std::byte const *compact_entry() const {
+    return compact_instructions_.empty() ? nullptr
+                                         : compact_instructions_.data();
+  }
+
+  // Returns a span over the bytes of the compact encoding of this function,
+  // which is empty if the function has no compact encoding.
+  std::span<std::byte const> compact_instructions() const {
+    return compact_instructions_;
+  }
+
+  // Replaces the compact encoding of this function with `encoding`, which is
+  // to be executed by `invoke`.
+  void set_compact_encoding(std::vector<std::byte> encoding,
+                            void (*invoke)(nth::stack<Value> &,
+                                           std::byte const *)) {
+    compact_instructions_ = std::move(encoding);
+    compact_invoke_       = invoke;
   }
 
   // Returns a span over all values representing instructions in the function.
   // Values in the span are not distinguished separately as op-codes or
   // immediate values.
   std::span<Value const> raw_instructions() const {
-    return std::span<Value const>(instructions_).subspan(1);
+    return instructions_.span().subspan(1);
   }
+  // Modifications made through the returned span are not reflected in the
+  // compact encoding of the function, if any.
   std::span<Value> raw_instructions() {
-    return std::span<Value>(instructions_).subspan(1);
+    return instructions_.span().subspan(1);
   }
 
+  // Returns the number of `Value`s which must be available to `relocate`.
+  size_t relocation_size() const { return instructions_.span().size(); }
+
+  // Copies the instructions of this function into `storage`, whose size must
+  // be `relocation_size()`, from which they are executed thereafter. Unless
+  // the function is modified so as to change its size, at which point the
+  // instructions are copied back into storage owned by the function,
+  // `storage` must outlive the function.
+  void relocate(std::span<Value> storage) { instructions_.relocate(storage); }
+
+  // Returns whether the instructions of this function have been relocated
+  // into storage it does not own.
+  bool relocated() const { return instructions_.relocated(); }
+
   // Given the index `index` into the immediate values of `range`, sets the
   // corresponding `Value` to `value`. Behavior is undefined if `range` is not a
   // valid range in `*this` function. This is typically used in conjunction with
@@ -62,7 +233,8 @@ struct FunctionBase {
   void set_value(nth::interval<InstructionIndex> range,
                  InstructionIndex::difference_type index, Value value) {
     NTH_REQUIRE((harden), index + 1 < range.length());
-    instructions_[range.lower_bound().value() + index + 1] = value;
+    Modified();
+    instructions_.span()[range.lower_bound().value() + index + 1] = value;
   }
 
   // Reserves space for up to `capacity` op-codes or immediate values before
@@ -71,16 +243,31 @@ struct FunctionBase {
 
   // Appends a value directly without regards to whether it is an op-code or
   // immediate value.
-  void raw_append(Value v) { instructions_.push_back(v); }
+  void raw_append(Value v) {
+    Modified();
+    instructions_.push_back(v);
+  }
+
+  // Appends each of `values` directly without regards to whether they are
+  // op-codes or immediate values, allocating no more space than is needed to
+  // hold them.
+  void raw_append(std::span<Value const> values) {
+    Modified();
+    instructions_.reserve(instructions_.span().size() + values.size());
+    instructions_.append(values);
+  }
 
  protected:
+  void set_max_stack_depth(uint32_t depth) { max_stack_depth_ = depth; }
+
   // Appends the sequence of `Value`s. To the instructions. The first must
   // represent an op-code and the remainder must represent immediate values.
   // Returns an `nth::interval<InstructionIndex>` representing the appended
   // sequence.
   nth::interval<InstructionIndex> append(std::initializer_list<Value> range) {
-    size_t size = instructions_.size();
-    instructions_.insert(instructions_.end(), range.begin(), range.end());
+    Modified();
+    size_t size = instructions_.span().size();
+    instructions_.append(std::span(range.begin(), range.size()));
     return nth::interval(InstructionIndex(size),
                          InstructionIndex(size + range.size()));
   }
@@ -90,18 +277,29 @@ struct FunctionBase {
   // Returns an `nth::interval<InstructionIndex>` representing the appended
   // sequence.
   nth::interval<InstructionIndex> append(Value fn, size_t placeholders) {
-    size_t size = instructions_.size();
+    Modified();
+    size_t size = instructions_.span().size();
     instructions_.push_back(fn);
-    instructions_.resize(instructions_.size() + placeholders,
-                         Value::Uninitialized());
+    instructions_.append_uninitialized(placeholders);
     return nth::interval(InstructionIndex(size),
                          InstructionIndex(size + placeholders + 1));
   }
 
  private:
-  std::vector<Value> instructions_;
+  // Discards the compact encoding of this function, which no longer reflects
+  // its instructions once they are modified.
+  void Modified() {
+    compact_instructions_.clear();
+    compact_invoke_ = nullptr;
+  }
+
+  RelocatableInstructions instructions_;
+  std::vector<std::byte> compact_instructions_;
+  void (*compact_invoke_)(nth::stack<Value> &, std::byte const *) = nullptr;
+  void (*guarded_invoke_)(GuardedValueStack &, Value const *, bool);
   uint32_t parameter_count_;
   uint32_t return_count_;
+  uint32_t max_stack_depth_ = 0;
 };
 
 }  // namespace hop::internal
@@ -1,5 +1,7 @@
 #include "hop/core/internal/function_base.h"
 
+#include <vector>
+
 #include "nth/test/test.h"
 
 namespace hop::internal {
@@ -21,5 +23,29 @@ NTH_TEST("function-base/raw-append") {
   NTH_EXPECT(f.raw_instructions()[1].as<bool>());
 }
 
+NTH_TEST("function-base/relocate") {
+  FunctionBase f(0, 0, nullptr, nullptr);
+  f.raw_append(3);
+  f.raw_append(true);
+  NTH_EXPECT(not f.relocated());
+
+  std::vector<Value> storage(f.relocation_size());
+  f.relocate(storage);
+  NTH_EXPECT(f.relocated());
+  NTH_EXPECT(f.entry() == storage.data() + 1);
+  NTH_ASSERT(f.raw_instructions().size() == size_t{2});
+  NTH_EXPECT(f.raw_instructions()[0].as<int>() == 3);
+
+  FunctionBase g = f;
+  NTH_EXPECT(not g.relocated());
+  NTH_EXPECT(g.raw_instructions()[1].as<bool>());
+
+  f.raw_append(4);
+  NTH_EXPECT(not f.relocated());
+  NTH_ASSERT(f.raw_instructions().size() == size_t{3});
+  NTH_EXPECT(f.raw_instructions()[0].as<int>() == 3);
+  NTH_EXPECT(f.raw_instructions()[2].as<int>() == 4);
+}
+
 }  // namespace
 }  // namespace hop::internal
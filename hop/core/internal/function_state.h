@@ -1,6 +1,15 @@
 #ifndef JASMIN_CORE_INTERNAL_FUNCTION_STATE_H
 #define JASMIN_CORE_INTERNAL_FUNCTION_STATE_H
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
 #include "nth/meta/type.h"
 
 namespace hop::internal {
@@ -13,9 +22,96 @@ concept HasFunctionState = requires {
   typename T::function_state;
 };
 
+// Holds one object of each of the types `Ts...`. Each object is constructed
+// only when it is first accessed, so that frames for functions which do not
+// use a particular state type never pay for its construction.
+template <typename... Ts>
+struct LazyFunctionState {
+  static_assert(sizeof...(Ts) <= 64);
+
+  LazyFunctionState() = default;
+  LazyFunctionState(LazyFunctionState &&s) : constructed_(s.constructed_) {
+    (move_from<Ts>(s), ...);
+  }
+  LazyFunctionState &operator=(LazyFunctionState &&) = delete;
+  ~LazyFunctionState() { reset(); }
+
+  // Returns a reference to the held object of type `T`, constructing it if it
+  // has not yet been constructed.
+  template <typename T>
+  T &get() {
+    if (not is_constructed<T>()) [[unlikely]] {
+      new (storage<T>()) T();
+      constructed_ |= Bit<T>;
+    }
+    return *std::launder(reinterpret_cast<T *>(storage<T>()));
+  }
+
+  // Destroys each held object that has been constructed.
+  void reset() {
+    if (constructed_ == 0) { return; }
+    (destroy<Ts>(), ...);
+    constructed_ = 0;
+  }
+
+ private:
+  template <typename T>
+  static constexpr size_t Index = [] {
+    constexpr bool matches[] = {std::is_same_v<T, Ts>...};
+    return std::find(std::begin(matches), std::end(matches), true) -
+           std::begin(matches);
+  }();
+
+  template <typename T>
+  static constexpr uint64_t Bit = uint64_t{1} << Index<T>;
+
+  static constexpr std::array<size_t, sizeof...(Ts) + 1> Offsets = [] {
+    constexpr size_t sizes[]      = {sizeof(Ts)...};
+    constexpr size_t alignments[] = {alignof(Ts)...};
+    std::array<size_t, sizeof...(Ts) + 1> offsets;
+    size_t offset = 0;
+    for (size_t i = 0; i < sizeof...(Ts); ++i) {
+      offset = (offset + alignments[i] - 1) / alignments[i] * alignments[i];
+      offsets[i] = offset;
+      offset += sizes[i];
+    }
+    offsets.back() = offset;
+    return offsets;
+  }();
+
+  template <typename T>
+  bool is_constructed() const {
+    return constructed_ & Bit<T>;
+  }
+
+  template <typename T>
+  std::byte *storage() {
+    return storage_ + Offsets[Index<T>];
+  }
+
+  template <typename T>
+  void destroy() {
+    if (is_constructed<T>()) {
+      std::destroy_at(std::launder(reinterpret_cast<T *>(storage<T>())));
+    }
+  }
+
+  template <typename T>
+  void move_from(LazyFunctionState &s) {
+    if (is_constructed<T>()) {
+      new (storage<T>())
+          T(std::move(*std::launder(reinterpret_cast<T *>(s.storage<T>()))));
+    }
+  }
+
+  uint64_t constructed_ = 0;
+  alignas(Ts...) std::byte storage_[Offsets.back()];
+};
+
 // A type-function accepting an instruction set and returning a type
 // sufficient to hold all state required by all instructions in `Set`, or
-// `void` if all instructions in `Set` are stateless.
+// `void` if all instructions in `Set` are stateless. Each state is constructed
+// lazily on first use (see `LazyFunctionState`).
 template <typename Set>
 using FunctionState = nth::type_t<
     Set::instructions
@@ -33,7 +129,7 @@ using FunctionState = nth::type_t<
           if constexpr (sizeof...(ts) == 0) {
             return nth::type<void>;
           } else {
-            return nth::type<std::tuple<nth::type_t<ts>...>>;
+            return nth::type<LazyFunctionState<nth::type_t<ts>...>>;
           }
         })>;
 
@@ -0,0 +1,65 @@
+#include "hop/core/internal/function_state.h"
+
+#include <utility>
+
+#include "nth/test/test.h"
+
+namespace hop::internal {
+namespace {
+
+int constructions = 0;
+int destructions  = 0;
+
+struct Counted {
+  Counted() { ++constructions; }
+  Counted(Counted &&) { ++constructions; }
+  ~Counted() { ++destructions; }
+  int value = 3;
+};
+
+NTH_TEST("lazy-function-state/construct-on-access") {
+  constructions = 0;
+  destructions  = 0;
+  {
+    LazyFunctionState<int, Counted> state;
+    NTH_EXPECT(constructions == 0);
+    NTH_EXPECT(state.get<int>() == 0);
+    NTH_EXPECT(constructions == 0);
+
+    NTH_EXPECT(state.get<Counted>().value == 3);
+    state.get<Counted>().value = 4;
+    NTH_EXPECT(state.get<Counted>().value == 4);
+    NTH_EXPECT(constructions == 1);
+  }
+  NTH_EXPECT(destructions == 1);
+}
+
+NTH_TEST("lazy-function-state/reset") {
+  constructions = 0;
+  destructions  = 0;
+  LazyFunctionState<int, Counted> state;
+  state.reset();
+  NTH_EXPECT(destructions == 0);
+
+  state.get<int>()           = 5;
+  state.get<Counted>().value = 4;
+  state.reset();
+  NTH_EXPECT(destructions == 1);
+  NTH_EXPECT(state.get<int>() == 0);
+  NTH_EXPECT(state.get<Counted>().value == 3);
+  NTH_EXPECT(constructions == 2);
+}
+
+NTH_TEST("lazy-function-state/move") {
+  constructions = 0;
+  destructions  = 0;
+  LazyFunctionState<int, Counted> state;
+  state.get<int>() = 5;
+
+  LazyFunctionState<int, Counted> moved(std::move(state));
+  NTH_EXPECT(moved.get<int>() == 5);
+  NTH_EXPECT(constructions == 0);
+}
+
+}  // namespace
+}  // namespace hop::internal
@@ -2,6 +2,7 @@
 #define JASMIN_CORE_INTERNAL_INSTRUCTION_TRAITS_H
 
 #include "hop/core/input.h"
+#include "hop/core/internal/function_forward.h"
 #include "hop/core/internal/function_state.h"
 #include "hop/core/output.h"
 #include "hop/core/value.h"
@@ -16,10 +17,17 @@ namespace hop {
 // Forward declarations for instructions that need special treatement in
 // Hop's interpreter and are built-in to every instruction set.
 struct Call;
+struct CallDirect;
 struct Jump;
 struct JumpIf;
 struct JumpIfNot;
 struct Return;
+struct Switch;
+struct TailCall;
+struct Yield;
+
+template <typename... Is>
+struct Fused;
 
 struct InstructionSpecification {
   uint32_t parameters;
@@ -54,7 +62,20 @@ struct InstructionSetBase {};
 // be noise than to be valuable for most users.
 template <typename I>
 constexpr bool BuiltinInstruction() {
-  return nth::any_of<I, Call, Jump, JumpIf, JumpIfNot, Return>;
+  return nth::any_of<I, Call, CallDirect, Jump, JumpIf, JumpIfNot, Return,
+                     Switch, TailCall, Yield>;
+}
+
+template <typename>
+inline constexpr bool IsFused = false;
+template <typename... Is>
+inline constexpr bool IsFused<Fused<Is...>> = true;
+
+// Returns true if and only if `I` is a superinstruction formed by fusing a
+// sequence of instructions via `hop::Fused`.
+template <typename I>
+constexpr bool FusedInstruction() {
+  return IsFused<I>;
 }
 
 template <typename I>
@@ -100,15 +121,20 @@ constexpr bool ValidParameterSequence(nth::Sequence auto seq) {
 
 template <typename I>
 constexpr auto InstructionFunctionType() {
-  if constexpr (nth::type<I> == nth::type<Call>) {
+  if constexpr (nth::any_of<I, Call, TailCall>) {
     return nth::type<void(std::span<Value, 1>, InstructionSpecification)>;
+  } else if constexpr (nth::type<I> == nth::type<CallDirect>) {
+    return nth::type<void(std::span<Value, 0>, InstructionSpecification,
+                          Function<> const *)>;
   } else if constexpr (nth::type<I> == nth::type<Jump>) {
     return nth::type<void(std::span<Value, 0>, ptrdiff_t)>;
   } else if constexpr (nth::type<I> == nth::type<JumpIf>) {
     return nth::type<void(std::span<Value, 1>, ptrdiff_t)>;
   } else if constexpr (nth::type<I> == nth::type<JumpIfNot>) {
     return nth::type<void(std::span<Value, 1>, ptrdiff_t)>;
-  } else if constexpr (nth::type<I> == nth::type<Return>) {
+  } else if constexpr (nth::type<I> == nth::type<Switch>) {
+    return nth::type<void(std::span<Value, 1>, uint64_t, size_t)>;
+  } else if constexpr (nth::any_of<I, Return, Yield>) {
     return nth::type<void(std::span<Value, 0>)>;
   } else {
     if constexpr (requires { &I::consume; }) {
@@ -164,12 +190,26 @@ template <typename I>
 constexpr size_t ImmediateValueBytes() {
   return InstructionFunctionType<I>()
       .parameters()
-      .template drop<(HasFunctionState<I> ? 2 : 3)>()
+      .template drop<(HasFunctionState<I> ? 3 : 2)>()
       .reduce([](auto... ts) {
         return (0 + ... + RoundUp(ts.size(), sizeof(Value)));
       });
 }
 
+// Returns the number of bytes required to store the immediate values of the
+// user-defined instruction `I` when each is packed to the size of its type.
+// For immediate-value-determined instructions, this does not include the
+// `InstructionSpecification`.
+template <typename I>
+constexpr size_t PackedImmediateValueBytes() {
+  return InstructionFunctionType<I>()
+      .parameters()
+      .template drop<(HasFunctionState<I> ? 3 : 2)>()
+      .reduce([](auto... ts) {
+        return (size_t{0} + ... + sizeof(std::remove_cvref_t<nth::type_t<ts>>));
+      });
+}
+
 }  // namespace internal
 }  // namespace hop
 
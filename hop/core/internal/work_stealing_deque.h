@@ -0,0 +1,135 @@
+#ifndef JASMIN_CORE_INTERNAL_WORK_STEALING_DEQUE_H
+#define JASMIN_CORE_INTERNAL_WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace hop::internal {
+
+// A lock-free double-ended queue of pointers, as described by Chase and Lev in
+// "Dynamic Circular Work-Stealing Deque" with the memory orderings of Lê et al.
+// in "Correct and Efficient Work-Stealing for Weak Memory Models". A single
+// thread, the owner, pushes and pops pointers at the bottom of the deque, while
+// any thread may steal pointers from its top. Neither operation blocks, and the
+// owner only contends with thieves when a single pointer remains.
+template <typename T>
+struct WorkStealingDeque {
+  WorkStealingDeque() : array_(nullptr) {
+    arrays_.push_back(std::make_unique<Array>(InitialCapacity));
+    array_.store(arrays_.back().get(), std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(WorkStealingDeque const &)            = delete;
+  WorkStealingDeque &operator=(WorkStealingDeque const &) = delete;
+
+  // Pushes `p`, which must not be null, onto the bottom of the deque. May only
+  // be called by the owner.
+  void push(T *p) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top    = top_.load(std::memory_order_acquire);
+    Array *array   = array_.load(std::memory_order_relaxed);
+    if (bottom - top >= static_cast<int64_t>(array->capacity())) {
+      array = Grow(array, top, bottom);
+    }
+    array->store(bottom, p);
+    bottom_.store(bottom + 1, std::memory_order_release);
+  }
+
+  // Pops a pointer from the bottom of the deque, returning null if the deque is
+  // empty. May only be called by the owner.
+  T *pop() {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    Array *array   = array_.load(std::memory_order_relaxed);
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T *p = array->load(bottom);
+    if (top == bottom) {
+      // This is the last pointer, for which thieves may be competing.
+      if (not top_.compare_exchange_strong(top, top + 1,
+                                           std::memory_order_seq_cst,
+                                           std::memory_order_relaxed)) {
+        p = nullptr;
+      }
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return p;
+  }
+
+  // Steals a pointer from the top of the deque, returning null if the deque is
+  // empty or another thread took the pointer first. May be called by any
+  // thread.
+  T *steal() {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) { return nullptr; }
+    T *p = array_.load(std::memory_order_acquire)->load(top);
+    if (not top_.compare_exchange_strong(top, top + 1,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return p;
+  }
+
+  // Returns whether the deque appeared empty at some point during the call.
+  bool empty() const {
+    return top_.load(std::memory_order_acquire) >=
+           bottom_.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr size_t InitialCapacity = 64;
+
+  // A circular buffer whose capacity is a power of two.
+  struct Array {
+    explicit Array(size_t capacity)
+        : mask(capacity - 1), slots(new std::atomic<T *>[capacity]) {}
+
+    size_t capacity() const { return mask + 1; }
+
+    T *load(int64_t index) const {
+      return slots[static_cast<size_t>(index) & mask].load(
+          std::memory_order_relaxed);
+    }
+    void store(int64_t index, T *p) {
+      slots[static_cast<size_t>(index) & mask].store(p,
+                                                     std::memory_order_relaxed);
+    }
+
+    size_t mask;
+    std::unique_ptr<std::atomic<T *>[]> slots;
+  };
+
+  // Replaces `array` with one of twice the capacity holding the same pointers.
+  // Thieves may still be reading from `array`, so it is retained until the
+  // deque is destroyed.
+  Array *Grow(Array *array, int64_t top, int64_t bottom) {
+    arrays_.push_back(std::make_unique<Array>(2 * array->capacity()));
+    Array *grown = arrays_.back().get();
+    for (int64_t i = top; i < bottom; ++i) { grown->store(i, array->load(i)); }
+    array_.store(grown, std::memory_order_release);
+    return grown;
+  }
+
+  // `top_` and `bottom_` are written by different threads, so they are kept on
+  // separate cache lines.
+  alignas(64) std::atomic<int64_t> top_ = 0;
+  alignas(64) std::atomic<int64_t> bottom_ = 0;
+  std::atomic<Array *> array_;
+  // Every array ever used by the deque, the last of which is current. Only
+  // accessed by the owner.
+  std::vector<std::unique_ptr<Array>> arrays_;
+};
+
+}  // namespace hop::internal
+
+#endif  // JASMIN_CORE_INTERNAL_WORK_STEALING_DEQUE_H
@@ -0,0 +1,61 @@
+#include "hop/core/internal/work_stealing_deque.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "nth/test/test.h"
+
+namespace hop::internal {
+namespace {
+
+NTH_TEST("work-stealing-deque/owner") {
+  std::vector<int> values(1000);
+  WorkStealingDeque<int> deque;
+  NTH_EXPECT(deque.empty());
+  NTH_EXPECT(deque.pop() == nullptr);
+  // More values than the initial capacity, so that the deque grows.
+  for (int &v : values) { deque.push(&v); }
+  NTH_EXPECT(not deque.empty());
+  // The owner pops the most recently pushed value, and thieves steal the least
+  // recently pushed.
+  NTH_EXPECT(deque.pop() == &values.back());
+  NTH_EXPECT(deque.steal() == &values.front());
+  for (size_t i = values.size() - 1; i > 1; --i) {
+    NTH_EXPECT(deque.pop() == &values[i - 1]);
+  }
+  NTH_EXPECT(deque.pop() == nullptr);
+  NTH_EXPECT(deque.steal() == nullptr);
+}
+
+NTH_TEST("work-stealing-deque/concurrent") {
+  // Each value is taken exactly once, whether by the owner or by a thief.
+  std::vector<int> values(100'000);
+  std::vector<std::atomic<int>> taken(values.size());
+  auto take = [&](int *p) { ++taken[p - values.data()]; };
+
+  WorkStealingDeque<int> deque;
+  std::atomic<bool> done = false;
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < 3; ++i) {
+    thieves.emplace_back([&] {
+      while (not done.load() or not deque.empty()) {
+        if (int *p = deque.steal()) { take(p); }
+      }
+    });
+  }
+  for (size_t i = 0; i < values.size(); ++i) {
+    deque.push(&values[i]);
+    if (i % 3 == 0) {
+      if (int *p = deque.pop()) { take(p); }
+    }
+  }
+  while (int *p = deque.pop()) { take(p); }
+  done = true;
+  for (auto &thief : thieves) { thief.join(); }
+
+  for (auto const &t : taken) { NTH_EXPECT(t.load() == 1); }
+}
+
+}  // namespace
+}  // namespace hop::internal
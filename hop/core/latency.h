@@ -0,0 +1,42 @@
+#ifndef JASMIN_CORE_LATENCY_H
+#define JASMIN_CORE_LATENCY_H
+
+#include <map>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "hop/core/instruction.h"
+#include "hop/core/internal/function_base.h"
+#include "hop/core/latency_histogram.h"
+#include "hop/core/program_fragment.h"
+
+namespace hop {
+
+// Returns a histogram of the time spent in each function of `fragment` which
+// has been called, keyed by the function's name, aggregated across all
+// threads since the program began or since `ResetLatencyHistograms` was last
+// called. Durations are only recorded when the `//hop/configuration:latency`
+// flag is set to "enabled"; otherwise the result is empty. The time spent in a
+// callee includes the time spent in the functions it calls. A function
+// entered via `TailCall` is measured from the tail call rather than from the
+// call which created its frame.
+template <InstructionSetType Set>
+std::map<std::string, LatencyHistogram> LatencySnapshot(
+    ProgramFragment<Set> const &fragment) {
+  std::map<std::string, LatencyHistogram> snapshot;
+  if constexpr (internal::measure_latency) {
+    absl::flat_hash_map<void const *, LatencyHistogram> histograms =
+        LatencyHistograms();
+    for (auto const &[name, f] : fragment.functions()) {
+      auto iter =
+          histograms.find(static_cast<internal::FunctionBase const *>(&f));
+      if (iter == histograms.end()) { continue; }
+      snapshot.emplace(name, iter->second);
+    }
+  }
+  return snapshot;
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_CORE_LATENCY_H
@@ -0,0 +1,157 @@
+#include "hop/core/latency_histogram.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "nth/base/indestructible.h"
+#include "nth/debug/debug.h"
+
+namespace hop {
+namespace {
+
+// A histogram written only by the thread which owns it, but which may be read
+// or reset by any thread. Buckets are loaded and stored rather than atomically
+// incremented, as the owning thread is the only writer.
+struct ThreadHistogram {
+  void record(size_t bucket) {
+    auto &b = buckets[bucket];
+    b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  void add_to(LatencyHistogram &h) const {
+    for (size_t i = 0; i < LatencyHistogram::BucketCount; ++i) {
+      h.buckets[i] += buckets[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  std::array<std::atomic<uint64_t>, LatencyHistogram::BucketCount> buckets = {};
+};
+
+struct ThreadLatencies;
+
+struct Registry {
+  absl::Mutex mutex;
+  std::vector<ThreadLatencies *> threads ABSL_GUARDED_BY(mutex);
+  // Durations recorded by threads which have since exited.
+  absl::flat_hash_map<void const *, LatencyHistogram> retired
+      ABSL_GUARDED_BY(mutex);
+};
+
+Registry &GetRegistry() {
+  static nth::indestructible<Registry> registry;
+  return *registry;
+}
+
+// The histograms recorded by a single thread. Only the owning thread inserts
+// into `histograms`, and it does so while holding `mutex`, so that the owning
+// thread may look up histograms without synchronization.
+struct ThreadLatencies {
+  ThreadLatencies() {
+    Registry &registry = GetRegistry();
+    absl::MutexLock lock(&registry.mutex);
+    registry.threads.push_back(this);
+  }
+
+  ~ThreadLatencies() {
+    Registry &registry = GetRegistry();
+    absl::MutexLock lock(&registry.mutex);
+    for (auto const &[callee, histogram] : histograms) {
+      histogram->add_to(registry.retired[callee]);
+    }
+    registry.threads.erase(
+        std::find(registry.threads.begin(), registry.threads.end(), this));
+  }
+
+  ThreadHistogram &histogram(void const *callee) {
+    auto iter = histograms.find(callee);
+    if (iter != histograms.end()) [[likely]] { return *iter->second; }
+    absl::MutexLock lock(&mutex);
+    return *histograms.emplace(callee, std::make_unique<ThreadHistogram>())
+                .first->second;
+  }
+
+  absl::Mutex mutex;
+  absl::flat_hash_map<void const *, std::unique_ptr<ThreadHistogram>>
+      histograms;
+};
+
+}  // namespace
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration) {
+  ++buckets[Bucket(
+      static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0)))];
+}
+
+uint64_t LatencyHistogram::count() const {
+  uint64_t n = 0;
+  for (uint64_t b : buckets) { n += b; }
+  return n;
+}
+
+std::chrono::nanoseconds LatencyHistogram::quantile(double q) const {
+  NTH_REQUIRE((harden), q >= 0);
+  NTH_REQUIRE((harden), q <= 1);
+  uint64_t total = count();
+  if (total == 0) { return std::chrono::nanoseconds(0); }
+  // The number of durations at or below the requested quantile, rounded up so
+  // that `quantile(1)` reports the bucket holding the largest duration.
+  uint64_t rank =
+      std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * total)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BucketCount; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      uint64_t upper = i + 1 == BucketCount ? LowerBound(i) : LowerBound(i + 1);
+      return std::chrono::nanoseconds(upper);
+    }
+  }
+  return std::chrono::nanoseconds(LowerBound(BucketCount - 1));
+}
+
+LatencyHistogram &LatencyHistogram::operator+=(LatencyHistogram const &h) {
+  for (size_t i = 0; i < BucketCount; ++i) { buckets[i] += h.buckets[i]; }
+  return *this;
+}
+
+absl::flat_hash_map<void const *, LatencyHistogram> LatencyHistograms() {
+  Registry &registry = GetRegistry();
+  absl::MutexLock lock(&registry.mutex);
+  absl::flat_hash_map<void const *, LatencyHistogram> result = registry.retired;
+  for (ThreadLatencies *thread : registry.threads) {
+    absl::MutexLock thread_lock(&thread->mutex);
+    for (auto const &[callee, histogram] : thread->histograms) {
+      histogram->add_to(result[callee]);
+    }
+  }
+  return result;
+}
+
+void ResetLatencyHistograms() {
+  Registry &registry = GetRegistry();
+  absl::MutexLock lock(&registry.mutex);
+  registry.retired.clear();
+  for (ThreadLatencies *thread : registry.threads) {
+    absl::MutexLock thread_lock(&thread->mutex);
+    for (auto const &[callee, histogram] : thread->histograms) {
+      for (auto &b : histogram->buckets) {
+        b.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+namespace internal {
+
+void RecordCallLatency(void const *callee, std::chrono::nanoseconds duration) {
+  thread_local ThreadLatencies latencies;
+  latencies.histogram(callee).record(LatencyHistogram::Bucket(
+      static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0))));
+}
+
+}  // namespace internal
+}  // namespace hop
@@ -0,0 +1,72 @@
+#ifndef JASMIN_CORE_LATENCY_HISTOGRAM_H
+#define JASMIN_CORE_LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace hop {
+
+// A histogram of durations with logarithmically sized buckets. Each power of
+// two is divided into four buckets, so that any quantile is reported within
+// 25% of its true value.
+struct LatencyHistogram {
+  static constexpr size_t SubBuckets  = 4;
+  static constexpr size_t BucketCount = SubBuckets * 63;
+
+  // Returns the index of the bucket holding durations of `nanoseconds`.
+  static constexpr size_t Bucket(uint64_t nanoseconds) {
+    if (nanoseconds < SubBuckets) { return nanoseconds; }
+    size_t exponent = std::bit_width(nanoseconds) - 1;
+    size_t sub      = (nanoseconds >> (exponent - 2)) & (SubBuckets - 1);
+    return SubBuckets * (exponent - 1) + sub;
+  }
+
+  // Returns the smallest duration, in nanoseconds, held in `bucket`.
+  static constexpr uint64_t LowerBound(size_t bucket) {
+    if (bucket < SubBuckets) { return bucket; }
+    size_t exponent = bucket / SubBuckets + 1;
+    return (SubBuckets + bucket % SubBuckets) << (exponent - 2);
+  }
+
+  // Records a single duration.
+  void record(std::chrono::nanoseconds duration);
+
+  // Returns the number of durations recorded.
+  uint64_t count() const;
+
+  // Returns an upper bound on the duration below which a fraction `q` of all
+  // recorded durations lie. Requires `0 <= q <= 1`. Returns zero if no
+  // durations have been recorded.
+  std::chrono::nanoseconds quantile(double q) const;
+
+  // Adds the durations recorded in `h` to `*this`.
+  LatencyHistogram &operator+=(LatencyHistogram const &h);
+
+  std::array<uint64_t, BucketCount> buckets = {};
+};
+
+// Returns histograms of the time spent in each function called by the `Call`,
+// `CallDirect`, or `TailCall` instructions, keyed by the callee, aggregated
+// across all threads. Durations are only recorded when the
+// `//hop/configuration:latency` flag is set to "enabled". To obtain histograms
+// keyed by function name, see `LatencySnapshot` in "hop/core/latency.h".
+absl::flat_hash_map<void const *, LatencyHistogram> LatencyHistograms();
+
+// Discards all durations recorded by every thread.
+void ResetLatencyHistograms();
+
+namespace internal {
+
+// Records that a call to `callee` took `duration` in the histograms of the
+// calling thread.
+void RecordCallLatency(void const *callee, std::chrono::nanoseconds duration);
+
+}  // namespace internal
+}  // namespace hop
+
+#endif  // JASMIN_CORE_LATENCY_HISTOGRAM_H
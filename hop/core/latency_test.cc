@@ -0,0 +1,76 @@
+#include "hop/core/latency.h"
+
+#include <chrono>
+
+#include "hop/core/program_fragment.h"
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "hop/testing/fibonacci.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+using Instructions =
+    MakeInstructionSet<Duplicate, Swap, Push<uint64_t>, LessThan<uint64_t>,
+                       Add<uint64_t>, Subtract<uint64_t>>;
+
+NTH_TEST("latency-histogram/bucket") {
+  for (uint64_t ns : {0, 1, 3, 4, 5, 7, 8, 100, 1'000'000, 123'456'789}) {
+    size_t bucket = LatencyHistogram::Bucket(ns);
+    NTH_EXPECT(LatencyHistogram::LowerBound(bucket) <= ns);
+    NTH_EXPECT(ns < LatencyHistogram::LowerBound(bucket + 1));
+  }
+  NTH_EXPECT(LatencyHistogram::Bucket(~uint64_t{0}) <
+             LatencyHistogram::BucketCount);
+}
+
+NTH_TEST("latency-histogram/quantile") {
+  LatencyHistogram h;
+  NTH_EXPECT(h.quantile(0.5) == std::chrono::nanoseconds(0));
+  for (int i = 0; i < 90; ++i) { h.record(std::chrono::nanoseconds(100)); }
+  for (int i = 0; i < 10; ++i) { h.record(std::chrono::microseconds(100)); }
+  NTH_EXPECT(h.count() == 100u);
+  NTH_EXPECT(h.quantile(0.5) > std::chrono::nanoseconds(100));
+  NTH_EXPECT(h.quantile(0.5) <= std::chrono::nanoseconds(125));
+  NTH_EXPECT(h.quantile(0.9) <= std::chrono::nanoseconds(125));
+  // Slightly more than 90 durations are at or below this quantile, so it must
+  // include one of the longer ones.
+  NTH_EXPECT(h.quantile(0.901) > std::chrono::microseconds(100));
+  NTH_EXPECT(h.quantile(0.99) > std::chrono::microseconds(100));
+  NTH_EXPECT(h.quantile(0.99) <= std::chrono::microseconds(125));
+
+  LatencyHistogram sum;
+  sum += h;
+  sum += h;
+  NTH_EXPECT(sum.count() == 200u);
+}
+
+NTH_TEST("latency/snapshot") {
+  ProgramFragment<Instructions> fragment;
+  BuildFibonacci(fragment.declare("fib", 1, 1).function,
+                 FibonacciCall::Direct);
+  Function<Instructions> const &fib = fragment.function("fib");
+
+  ResetLatencyHistograms();
+  nth::stack<Value> stack = {uint64_t{10}};
+  fib.invoke(stack);
+
+  auto snapshot = LatencySnapshot(fragment);
+  if constexpr (not internal::measure_latency) {
+    NTH_EXPECT(snapshot.empty());
+    return;
+  }
+  NTH_ASSERT(snapshot.size() == 1u);
+  // Computing the tenth Fibonacci number recursively makes 177 invocations,
+  // all but the outermost of which are calls.
+  NTH_EXPECT(snapshot["fib"].count() == 176u);
+
+  ResetLatencyHistograms();
+  NTH_EXPECT(LatencySnapshot(fragment)["fib"].count() == 0u);
+}
+
+}  // namespace
+}  // namespace hop
@@ -30,9 +30,13 @@ uint16_t InstructionSetMetadata::opcode(Value f) const {
 
 InstructionSetMetadata::InstructionSetMetadata(
     std::vector<InstructionMetadata> metadata,
-    std::vector<internal::exec_fn_type> fns)
+    std::vector<internal::exec_fn_type> fns,
+    std::vector<internal::exec_fn_type> const& unchecked_fns)
     : metadata_(std::move(metadata)), functions_(std::move(fns)) {
-  for (auto const& f : functions_) { opcode_.emplace(f, opcode_.size()); }
+  for (size_t i = 0; i < functions_.size(); ++i) {
+    opcode_.emplace(functions_[i], i);
+    opcode_.emplace(unchecked_fns[i], i);
+  }
 }
 
 }  // namespace hop
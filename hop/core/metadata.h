@@ -51,15 +51,19 @@ struct InstructionSetMetadata {
 
   // Returns the opcode associated with function `f` used by the interpreter
   // when evaluating the associated instruction. Functionally, this is the
-  // inverse of the member function named `function`)
+  // inverse of the member function named `function`). Both the checked and
+  // unchecked variants of an instruction (see `Instruction::ExecuteImpl`) are
+  // associated with the same op-code.
   uint16_t opcode(Value f) const;
 
  private:
   template <InstructionSetType Set>
   friend InstructionSetMetadata const& Metadata();
 
-  explicit InstructionSetMetadata(std::vector<InstructionMetadata> metadata,
-                                  std::vector<internal::exec_fn_type> fns);
+  explicit InstructionSetMetadata(
+      std::vector<InstructionMetadata> metadata,
+      std::vector<internal::exec_fn_type> fns,
+      std::vector<internal::exec_fn_type> const& unchecked_fns);
 
   std::vector<InstructionMetadata> metadata_;
   absl::flat_hash_map<internal::exec_fn_type, size_t> opcode_;
@@ -81,7 +85,8 @@ InstructionSetMetadata const& Metadata() {
                 .return_count          = ReturnCount<nth::type_t<is>>(),
                 .consumes_input        = ConsumesInput<nth::type_t<is>>(),
             }...},
-            {&nth::type_t<is>::template ExecuteImpl<Set>...});
+            {&nth::type_t<is>::template ExecuteImpl<Set>...},
+            {&nth::type_t<is>::template ExecuteImpl<Set, false>...});
       });
   return *metadata;
 }
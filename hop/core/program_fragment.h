@@ -1,13 +1,19 @@
 #ifndef JASMIN_CORE_PROGRAM_FRAGMENT_H
 #define JASMIN_CORE_PROGRAM_FRAGMENT_H
 
+#include <algorithm>
 #include <cstdint>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "hop/core/function.h"
 #include "hop/core/instruction.h"
 #include "hop/core/internal/function_forward.h"
+#include "hop/core/latency_histogram.h"
+#include "hop/core/metadata.h"
 #include "nth/container/flyweight_map.h"
 #include "nth/debug/debug.h"
 #include "nth/format/format.h"
@@ -74,8 +80,19 @@ struct ProgramFragment : internal::ProgramFragmentBase {
     return nth::iterator_range(functions_.begin(), functions_.end());
   }
 
+  // Relocates the instructions of every function in this `ProgramFragment`
+  // into a single contiguous arena owned by the `ProgramFragment`. Functions
+  // are laid out in depth-first order of the call graph formed by their
+  // `CallDirect` instructions, so that each function is placed near the
+  // functions it calls. When call latencies are recorded (see
+  // "hop/core/latency_histogram.h"), more frequently called functions are
+  // visited first. A function modified so as to change its size afterwards
+  // moves back out of the arena, and `freeze` may be called again.
+  void freeze();
+
  private:
   nth::flyweight_map<std::string, Function<Set>> functions_;
+  std::vector<Value> arena_;
 };
 
 template <InstructionSetType Set>
@@ -114,6 +131,77 @@ Function<Set> const& ProgramFragment<Set>::function(
   return functions_.from_index(id.value()).second;
 }
 
+template <InstructionSetType Set>
+void ProgramFragment<Set>::freeze() {
+  size_t count = functions_.size();
+  std::vector<Function<Set>*> fns;
+  absl::flat_hash_map<Function<> const*, size_t> indices;
+  for (size_t i = 0; i < count; ++i) {
+    fns.push_back(&functions_.from_index(i).second);
+    indices.emplace(fns.back(), i);
+  }
+
+  std::vector<uint64_t> calls(count, 0);
+  if constexpr (internal::measure_latency) {
+    absl::flat_hash_map<void const*, LatencyHistogram> histograms =
+        LatencyHistograms();
+    for (size_t i = 0; i < count; ++i) {
+      auto iter =
+          histograms.find(static_cast<internal::FunctionBase const*>(fns[i]));
+      if (iter != histograms.end()) { calls[i] = iter->second.count(); }
+    }
+  }
+  auto more_calls = [&](size_t l, size_t r) { return calls[l] > calls[r]; };
+
+  auto const& metadata      = Metadata<Set>();
+  constexpr uint16_t Direct = internal::OpCode<CallDirect, Set>();
+  std::vector<std::vector<size_t>> callees(count);
+  for (size_t i = 0; i < count; ++i) {
+    std::span insts = fns[i]->raw_instructions();
+    for (size_t j = 0; j < insts.size();) {
+      uint16_t op_code = metadata.opcode(insts[j]);
+      if (op_code == Direct) {
+        auto iter = indices.find(insts[j + 2].as<Function<> const*>());
+        if (iter != indices.end()) { callees[i].push_back(iter->second); }
+      }
+      j += 1 + metadata.metadata(op_code).immediate_value_count;
+    }
+    std::stable_sort(callees[i].begin(), callees[i].end(), more_calls);
+  }
+
+  std::vector<size_t> roots(count);
+  for (size_t i = 0; i < count; ++i) { roots[i] = i; }
+  std::stable_sort(roots.begin(), roots.end(), more_calls);
+
+  std::vector<size_t> order;
+  std::vector<bool> visited(count, false);
+  std::vector<size_t> stack;
+  size_t size = 0;
+  for (size_t root : roots) {
+    stack.push_back(root);
+    while (not stack.empty()) {
+      size_t i = stack.back();
+      stack.pop_back();
+      if (visited[i]) { continue; }
+      visited[i] = true;
+      order.push_back(i);
+      size += fns[i]->relocation_size();
+      stack.insert(stack.end(), callees[i].rbegin(), callees[i].rend());
+    }
+  }
+
+  // Functions already frozen are copied out of the previous arena, so it must
+  // remain alive until every function has been relocated.
+  std::vector<Value> arena(size, Value::Uninitialized());
+  std::span<Value> remaining(arena);
+  for (size_t i : order) {
+    size_t n = fns[i]->relocation_size();
+    fns[i]->relocate(remaining.subspan(0, n));
+    remaining = remaining.subspan(n);
+  }
+  arena_ = std::move(arena);
+}
+
 }  // namespace hop
 
 #endif  // JASMIN_CORE_PROGRAM_FRAGMENT_H
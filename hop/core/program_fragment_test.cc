@@ -0,0 +1,66 @@
+#include "hop/core/program_fragment.h"
+
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+using Instructions = MakeInstructionSet<Push<uint64_t>, Add<uint64_t>>;
+
+NTH_TEST("program-fragment/declare") {
+  ProgramFragment<Instructions> p;
+  auto [id, f] = p.declare("f", 1, 1);
+  NTH_EXPECT(p.function_count() == size_t{1});
+  NTH_EXPECT(&p.function("f") == &f);
+  NTH_EXPECT(&p.function(id) == &f);
+}
+
+NTH_TEST("program-fragment/freeze") {
+  // Calls recorded by other tests must not affect the layout.
+  ResetLatencyHistograms();
+  ProgramFragment<Instructions> p;
+  auto& caller = p.declare("caller", 1, 1).function;
+  auto& other  = p.declare("other", 0, 1).function;
+  auto& callee = p.declare("callee", 1, 1).function;
+
+  other.append<Push<uint64_t>>(7);
+  other.append<Return>();
+  callee.append<Push<uint64_t>>(1);
+  callee.append<Add<uint64_t>>();
+  callee.append<Return>();
+  caller.append<CallDirect>({.parameters = 1, .returns = 1}, &callee);
+  caller.append<CallDirect>({.parameters = 1, .returns = 1}, &callee);
+  caller.append<Return>();
+
+  p.freeze();
+  NTH_EXPECT(caller.relocated());
+  NTH_EXPECT(other.relocated());
+  NTH_EXPECT(callee.relocated());
+
+  // Callees are placed immediately after their callers.
+  NTH_EXPECT(callee.entry() == caller.entry() + caller.relocation_size());
+  NTH_EXPECT(other.entry() == callee.entry() + callee.relocation_size());
+
+  nth::stack<Value> stack = {uint64_t{3}};
+  caller.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{5});
+
+  // Modifying a function moves it out of the arena.
+  other.append<Push<uint64_t>>(8);
+  NTH_EXPECT(not other.relocated());
+  NTH_EXPECT(callee.relocated());
+
+  p.freeze();
+  NTH_EXPECT(other.relocated());
+  stack = {uint64_t{3}};
+  caller.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{5});
+}
+
+}  // namespace
+}  // namespace hop
@@ -0,0 +1,141 @@
+#include "hop/core/sampling_profiler.h"
+
+#include <signal.h>
+#include <sys/time.h>
+
+#include <cerrno>
+
+#include "hop/core/internal/frame.h"
+#include "nth/debug/debug.h"
+
+namespace hop {
+namespace internal {
+
+size_t InstructionContaining(std::span<Value const> instructions, size_t index,
+                             InstructionSetMetadata const &metadata) {
+  size_t start = 0;
+  while (true) {
+    size_t next =
+        start + 1 +
+        metadata.metadata(metadata.opcode(instructions[start]))
+            .immediate_value_count;
+    if (index < next) { return start; }
+    start = next;
+  }
+}
+
+}  // namespace internal
+
+namespace {
+
+// The buffer of the running profiler, if any.
+constinit std::atomic<internal::SampleBuffer *> active_buffer = nullptr;
+
+struct sigaction previous_action;
+
+void RecordSample(int, siginfo_t *, void *) {
+  int saved_errno = errno;
+  internal::SampleBuffer *buffer =
+      active_buffer.load(std::memory_order_acquire);
+  internal::SampledExecution const *execution = internal::sampled_execution;
+  if (buffer == nullptr or execution == nullptr) {
+    errno = saved_errno;
+    return;
+  }
+
+  // Instruction pointers are gathered innermost first.
+  Value const *ips[SamplingProfiler::MaxDepth];
+  size_t depth = 0;
+  for (; execution != nullptr and depth < SamplingProfiler::MaxDepth;
+       execution = execution->previous) {
+    Value const *ip = execution->ip;
+    // The call stack may be moving, so it cannot be inspected.
+    if (ip == nullptr) {
+      errno = saved_errno;
+      return;
+    }
+    ips[depth++] = ip;
+
+    std::byte const *frames_begin = execution->frames_begin;
+    std::byte const *frame =
+        reinterpret_cast<std::byte const *>(execution->frame_end);
+    // The first frame belongs to the outermost function and holds no call
+    // site.
+    while ((frame -= execution->frame_size) > frames_begin and
+           depth < SamplingProfiler::MaxDepth) {
+      ips[depth++] = internal::RecordedCallSite(
+          reinterpret_cast<internal::FrameBase const *>(frame)->call_site);
+    }
+  }
+
+  size_t start = buffer->used.fetch_add(depth + 1, std::memory_order_relaxed);
+  if (start + depth + 1 > buffer->capacity) {
+    buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    uintptr_t *slot = &buffer->slots[start];
+    *slot++         = depth;
+    while (depth != 0) { *slot++ = reinterpret_cast<uintptr_t>(ips[--depth]); }
+    buffer->samples.fetch_add(1, std::memory_order_relaxed);
+  }
+  errno = saved_errno;
+}
+
+void SetTimer(std::chrono::microseconds period) {
+  struct itimerval timer = {};
+  timer.it_interval.tv_sec  = period.count() / 1'000'000;
+  timer.it_interval.tv_usec = period.count() % 1'000'000;
+  timer.it_value            = timer.it_interval;
+  int result = ::setitimer(ITIMER_PROF, &timer, nullptr);
+  NTH_REQUIRE(result == 0);
+}
+
+}  // namespace
+
+SamplingProfiler::SamplingProfiler(std::chrono::microseconds period,
+                                   size_t capacity)
+    : period_(period), buffer_(capacity) {
+  NTH_REQUIRE(period.count() > 0);
+}
+
+SamplingProfiler::~SamplingProfiler() {
+  if (running_) { stop(); }
+}
+
+void SamplingProfiler::start() {
+  NTH_REQUIRE(not running_);
+  // Only one profiler may be running at a time.
+  internal::SampleBuffer *expected = nullptr;
+  // On failure, `expected` is replaced by the running profiler's buffer.
+  active_buffer.compare_exchange_strong(expected, &buffer_);
+  NTH_REQUIRE(expected == nullptr);
+  running_ = true;
+
+  struct sigaction action = {};
+  action.sa_sigaction     = RecordSample;
+  action.sa_flags         = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  ::sigaction(SIGPROF, &action, &previous_action);
+  SetTimer(period_);
+}
+
+void SamplingProfiler::stop() {
+  NTH_REQUIRE(running_);
+  SetTimer(std::chrono::microseconds(0));
+  ::sigaction(SIGPROF, &previous_action, nullptr);
+  active_buffer.store(nullptr, std::memory_order_release);
+  running_ = false;
+}
+
+void SamplingProfiler::for_each_sample(
+    absl::FunctionRef<void(std::span<Value const *const>)> f) const {
+  NTH_REQUIRE(not running_);
+  size_t end = std::min(buffer_.used.load(), buffer_.capacity);
+  for (size_t i = 0, n = 0; i < end and n < sample_count(); ++n) {
+    size_t depth = buffer_.slots[i];
+    f(std::span(reinterpret_cast<Value const *const *>(&buffer_.slots[i + 1]),
+                depth));
+    i += depth + 1;
+  }
+}
+
+}  // namespace hop
@@ -0,0 +1,162 @@
+#ifndef JASMIN_CORE_SAMPLING_PROFILER_H
+#define JASMIN_CORE_SAMPLING_PROFILER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "hop/core/instruction.h"
+#include "hop/core/metadata.h"
+#include "hop/core/program_fragment.h"
+#include "hop/core/value.h"
+
+namespace hop {
+namespace internal {
+
+// Storage for samples shared between a `SamplingProfiler` and the signal
+// handler recording samples. Each sample occupies one slot holding its depth
+// followed by one slot per instruction pointer, outermost first.
+struct SampleBuffer {
+  explicit SampleBuffer(size_t capacity)
+      : slots(new uintptr_t[capacity]), capacity(capacity) {}
+
+  std::unique_ptr<uintptr_t[]> slots;
+  size_t capacity;
+  std::atomic<size_t> used    = 0;
+  std::atomic<size_t> samples = 0;
+  std::atomic<size_t> dropped = 0;
+};
+
+// Returns the index of the first value of the instruction in `instructions`
+// which contains the value at `index`.
+size_t InstructionContaining(std::span<Value const> instructions, size_t index,
+                             InstructionSetMetadata const &metadata);
+
+}  // namespace internal
+
+// A `SamplingProfiler` periodically interrupts the process with `SIGPROF`,
+// according to the CPU time it consumes. If the interrupted thread is executing
+// a Hop function, whether invoked directly, in a batch, or by resuming a
+// `Continuation`, the profiler records the instruction being executed along
+// with the call site of each function on the call stack, including those of
+// executions which invoked the current one. Samples are only recorded when the
+// `//hop/configuration:sampling` flag is set to "enabled". At most one
+// profiler may be running at a time.
+struct SamplingProfiler {
+  // The maximum number of instructions recorded per sample. The outermost
+  // frames of deeper call stacks are dropped.
+  static constexpr size_t MaxDepth = 256;
+
+  // Constructs a profiler which, when running, samples once per `period` of
+  // CPU time, with room for `capacity` instruction pointers across all
+  // samples. Samples taken after the space is exhausted are dropped.
+  explicit SamplingProfiler(
+      std::chrono::microseconds period = std::chrono::milliseconds(1),
+      size_t capacity                  = size_t{1} << 20);
+
+  SamplingProfiler(SamplingProfiler const &)            = delete;
+  SamplingProfiler &operator=(SamplingProfiler const &) = delete;
+
+  ~SamplingProfiler();
+
+  // Begins or stops sampling. Samples recorded previously are retained.
+  void start();
+  void stop();
+
+  // Returns the number of samples recorded.
+  size_t sample_count() const { return buffer_.samples.load(); }
+
+  // Returns the number of samples dropped for lack of space.
+  size_t dropped_count() const { return buffer_.dropped.load(); }
+
+  // Invokes `f` on the instruction pointers of each recorded sample, outermost
+  // first. The last is the instruction being executed; each other is the call
+  // site of the following function. Must not be called while running.
+  void for_each_sample(
+      absl::FunctionRef<void(std::span<Value const *const>)> f) const;
+
+  // Writes the recorded samples to `file` as folded stacks, one line per
+  // distinct stack followed by the number of samples of that stack, suitable
+  // for producing flame graphs. Each frame is the name of a function in
+  // `fragment`, and the last frame of each stack is the offset and name of
+  // the instruction being executed. Frames in functions not belonging to
+  // `fragment` are written as "[unknown]". Must not be called while running.
+  template <InstructionSetType Set>
+  void write_folded_stacks(ProgramFragment<Set> const &fragment,
+                           std::FILE *file) const;
+
+ private:
+  std::chrono::microseconds period_;
+  internal::SampleBuffer buffer_;
+  bool running_ = false;
+};
+
+template <InstructionSetType Set>
+void SamplingProfiler::write_folded_stacks(ProgramFragment<Set> const &fragment,
+                                           std::FILE *file) const {
+  struct Range {
+    std::span<Value const> instructions;
+    std::string_view name;
+  };
+  std::vector<Range> ranges;
+  for (auto const &[name, f] : fragment.functions()) {
+    ranges.push_back({.instructions = f.raw_instructions(), .name = name});
+  }
+  std::sort(ranges.begin(), ranges.end(), [](Range const &l, Range const &r) {
+    return l.instructions.data() < r.instructions.data();
+  });
+  auto find = [&](Value const *ip) -> Range const * {
+    auto iter = std::upper_bound(
+        ranges.begin(), ranges.end(), ip, [](Value const *p, Range const &r) {
+          return p < r.instructions.data();
+        });
+    if (iter == ranges.begin()) { return nullptr; }
+    --iter;
+    if (ip >= iter->instructions.data() + iter->instructions.size()) {
+      return nullptr;
+    }
+    return &*iter;
+  };
+
+  auto const &metadata = Metadata<Set>();
+  std::map<std::string, uint64_t> stacks;
+  for_each_sample([&](std::span<Value const *const> ips) {
+    std::string stack;
+    for (Value const *ip : ips) {
+      Range const *range = find(ip);
+      if (not stack.empty()) { stack.push_back(';'); }
+      stack.append(range ? range->name : "[unknown]");
+    }
+    if (Range const *range = find(ips.back())) {
+      size_t offset = internal::InstructionContaining(
+          range->instructions, ips.back() - range->instructions.data(),
+          metadata);
+      auto const &instruction =
+          metadata.metadata(metadata.opcode(range->instructions[offset]));
+      stack.push_back(';');
+      stack.append(std::to_string(offset));
+      stack.push_back(':');
+      stack.append(instruction.name);
+    }
+    ++stacks[std::move(stack)];
+  });
+
+  for (auto const &[stack, count] : stacks) {
+    std::fprintf(file, "%s %" PRIu64 "\n", stack.c_str(), count);
+  }
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_CORE_SAMPLING_PROFILER_H
@@ -0,0 +1,133 @@
+#include "hop/core/sampling_profiler.h"
+
+#include <cstdio>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "hop/core/continuation.h"
+#include "hop/core/program_fragment.h"
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "hop/testing/fibonacci.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+using Instructions =
+    MakeInstructionSet<Duplicate, Swap, Push<uint64_t>, LessThan<uint64_t>,
+                       Add<uint64_t>, Subtract<uint64_t>>;
+
+NTH_TEST("sampling-profiler/instruction-containing") {
+  Function<Instructions> f(1, 1);
+  BuildFibonacci(f, FibonacciCall::Direct);
+  auto const &metadata = Metadata<Instructions>();
+  std::span insts      = f.raw_instructions();
+  NTH_EXPECT(internal::InstructionContaining(insts, 0, metadata) == 0u);
+  NTH_EXPECT(internal::InstructionContaining(insts, 1, metadata) == 1u);
+  NTH_EXPECT(internal::InstructionContaining(insts, 2, metadata) == 1u);
+  NTH_EXPECT(internal::InstructionContaining(insts, 3, metadata) == 3u);
+  NTH_EXPECT(internal::InstructionContaining(insts, 5, metadata) == 4u);
+}
+
+NTH_TEST("sampling-profiler/folded-stacks") {
+  ProgramFragment<Instructions> fragment;
+  BuildFibonacci(fragment.declare("fib", 1, 1).function,
+                 FibonacciCall::Direct);
+  Function<Instructions> const &fib = fragment.function("fib");
+
+  SamplingProfiler profiler(std::chrono::microseconds(100));
+  profiler.start();
+  for (int i = 0; i < 20; ++i) {
+    nth::stack<Value> stack = {uint64_t{25}};
+    fib.invoke(stack);
+  }
+  profiler.stop();
+
+  if constexpr (not internal::sampling) {
+    NTH_EXPECT(profiler.sample_count() == 0u);
+    return;
+  }
+  NTH_ASSERT(profiler.sample_count() != 0u);
+
+  std::FILE *file = std::tmpfile();
+  profiler.write_folded_stacks(fragment, file);
+  std::rewind(file);
+  char line[4096];
+  size_t lines = 0;
+  while (std::fgets(line, sizeof(line), file)) {
+    ++lines;
+    NTH_EXPECT(std::string(line).starts_with("fib;"));
+  }
+  std::fclose(file);
+  NTH_EXPECT(lines != 0u);
+}
+
+NTH_TEST("sampling-profiler/call-sites") {
+  Function<Instructions> fib(1, 1);
+  BuildFibonacci(fib, FibonacciCall::Direct);
+
+  SamplingProfiler profiler(std::chrono::microseconds(100));
+  profiler.start();
+  for (int i = 0; i < 20; ++i) {
+    nth::stack<Value> stack = {uint64_t{25}};
+    fib.invoke(stack);
+  }
+  profiler.stop();
+
+  // Every instruction pointer but the last is that of a `CallDirect` in `fib`.
+  std::span insts = fib.raw_instructions();
+  profiler.for_each_sample([&](std::span<Value const *const> ips) {
+    for (Value const *ip : ips.first(ips.size() - 1)) {
+      bool in_fib = insts.data() <= ip and ip < insts.data() + insts.size();
+      NTH_EXPECT(in_fib);
+      if (not in_fib) { continue; }
+      auto op = ip->as<internal::exec_fn_type>();
+      NTH_EXPECT(op == &CallDirect::ExecuteImpl<Instructions> or
+                 op == &CallDirect::ExecuteImpl<Instructions, false>);
+    }
+  });
+}
+
+NTH_TEST("sampling-profiler/continuation") {
+  Function<Instructions> fib(1, 1);
+  BuildFibonacci(fib, FibonacciCall::Direct);
+
+  SamplingProfiler profiler(std::chrono::microseconds(100));
+  profiler.start();
+  for (int i = 0; i < 20; ++i) {
+    Continuation<Instructions> c(fib, {uint64_t{25}});
+    c.resume();
+  }
+  profiler.stop();
+
+  if constexpr (internal::sampling) {
+    NTH_EXPECT(profiler.sample_count() != 0u);
+  } else {
+    NTH_EXPECT(profiler.sample_count() == 0u);
+  }
+}
+
+NTH_TEST("sampling-profiler/batch") {
+  Function<Instructions> fib(1, 1);
+  BuildFibonacci(fib, FibonacciCall::Direct);
+
+  std::vector<Value> arguments(20, uint64_t{25});
+  std::vector<Value> results(arguments.size(), Value::Uninitialized());
+  SamplingProfiler profiler(std::chrono::microseconds(100));
+  profiler.start();
+  fib.invoke_batch(arguments, results);
+  profiler.stop();
+
+  if constexpr (internal::sampling) {
+    NTH_EXPECT(profiler.sample_count() != 0u);
+  } else {
+    NTH_EXPECT(profiler.sample_count() == 0u);
+  }
+}
+
+}  // namespace
+}  // namespace hop
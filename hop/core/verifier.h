@@ -0,0 +1,264 @@
+#ifndef JASMIN_CORE_VERIFIER_H
+#define JASMIN_CORE_VERIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "hop/core/function.h"
+#include "hop/core/instruction.h"
+#include "hop/core/internal/function_base.h"
+#include "hop/core/internal/instruction_traits.h"
+#include "hop/core/value.h"
+
+namespace hop {
+
+// Describes the first violation found by `Verify`.
+struct VerificationError {
+  enum Kind : uint8_t {
+    // An op-code is not an instruction in the function's instruction set.
+    UnknownInstruction,
+    // An instruction's immediate values extend past the end of the function.
+    TruncatedInstruction,
+    // A jump targets a position outside the function or one which is not the
+    // op-code of an instruction.
+    InvalidJumpTarget,
+    // The jump table following a `Switch` extends past the end of the function
+    // or holds an instruction other than `Jump`.
+    MalformedJumpTable,
+    // An instruction requires more values than are present on the stack.
+    StackUnderflow,
+    // Two paths reach the same instruction with different stack heights.
+    InconsistentStackHeight,
+    // A `Return` or `TailCall` leaves a number of values on the stack other
+    // than the function's return count.
+    IncorrectReturnCount,
+    // Execution may continue past the last instruction of the function.
+    FallsOffEnd,
+    // The `InstructionSpecification` of a `CallDirect` disagrees with the
+    // parameter or return count of its callee, or the callee is null.
+    CalleeMismatch,
+  } kind;
+
+  // The index, within `raw_instructions()`, of the op-code of the offending
+  // instruction.
+  size_t offset;
+
+  std::string_view description() const {
+    switch (kind) {
+      case UnknownInstruction: return "unknown instruction";
+      case TruncatedInstruction: return "truncated instruction";
+      case InvalidJumpTarget: return "invalid jump target";
+      case MalformedJumpTable: return "malformed jump table";
+      case StackUnderflow: return "stack underflow";
+      case InconsistentStackHeight: return "inconsistent stack height";
+      case IncorrectReturnCount: return "incorrect return count";
+      case FallsOffEnd: return "falls off end";
+      case CalleeMismatch: return "callee mismatch";
+    }
+    return "unknown error";
+  }
+
+  friend bool operator==(VerificationError, VerificationError) = default;
+};
+
+// Checks, without executing it, that `f` is well-formed: Every op-code belongs
+// to `Set` and is followed by all of its immediate values, every jump targets
+// the op-code of an instruction within `f`, every path reaching an instruction
+// does so with the same stack height and with at least as many values as the
+// instruction consumes, and every `Return` or `TailCall` leaves exactly
+// `f.return_count()` values. Returns the first violation found, or
+// `std::nullopt` if there are none.
+//
+// Unlike `Function<Set>::finalize`, which requires these properties, `Verify`
+// never aborts, and so may be applied to untrusted bytecode (e.g., as produced
+// by deserialization). A function which verifies successfully may be finalized,
+// after which it runs without checking value stack capacity per instruction.
+// The `InstructionSpecification` of each `CallDirect` is checked against the
+// parameter and return counts of its callee, which must therefore point to a
+// live function (deserialization resolves callees through a registry). The
+// callees of `Call` and `TailCall` are only known at run time and are not
+// inspected. Each `Yield` is assumed to leave the stack unchanged, so functions
+// which consume values pushed by the host while suspended are rejected.
+template <InstructionSetType Set>
+std::optional<VerificationError> Verify(Function<Set> const &f);
+
+// Finalizes `f` if it verifies successfully (see `Verify`), and otherwise
+// leaves `f` unmodified and returns the violation found.
+template <InstructionSetType Set>
+std::optional<VerificationError> VerifyAndFinalize(Function<Set> &f);
+
+namespace internal {
+
+// Reads the immediate value `v` as a `T` without consulting the type recorded
+// in debug builds, as untrusted bytecode may hold values of any type.
+template <typename T>
+T ReadImmediate(Value v) {
+  T result;
+  Value::Store(v, &result, sizeof(T));
+  return result;
+}
+
+template <typename Set>
+std::optional<VerificationError> Verify(std::span<Value const> insts,
+                                        uint32_t parameter_count,
+                                        uint32_t return_count) {
+  using enum VerificationError::Kind;
+  auto const &effects = DepthEffects<Set>();
+  auto effect_at      = [&](size_t index) -> DepthEffect const * {
+    auto iter = effects.find(ReadImmediate<exec_fn_type>(insts[index]));
+    return iter == effects.end() ? nullptr : &iter->second;
+  };
+
+  // Decode the instructions in order, so that jump targets can be checked
+  // against instruction boundaries.
+  std::vector<bool> boundaries(insts.size(), false);
+  for (size_t index = 0; index < insts.size();) {
+    DepthEffect const *effect = effect_at(index);
+    if (not effect) { return VerificationError{UnknownInstruction, index}; }
+    if (effect->immediate_value_count >= insts.size() - index) {
+      return VerificationError{TruncatedInstruction, index};
+    }
+    boundaries[index] = true;
+    index += 1 + effect->immediate_value_count;
+  }
+
+  // The stack height on entry to each instruction, or -1 if the instruction
+  // has not yet been reached.
+  std::vector<ptrdiff_t> heights(insts.size(), -1);
+  std::vector<size_t> worklist;
+  auto reach = [&](size_t index,
+                   ptrdiff_t height) -> std::optional<VerificationError> {
+    if (heights[index] == -1) {
+      heights[index] = height;
+      worklist.push_back(index);
+    } else if (heights[index] != height) {
+      return VerificationError{InconsistentStackHeight, index};
+    }
+    return std::nullopt;
+  };
+  auto jump = [&](size_t index, size_t immediate,
+                  ptrdiff_t height) -> std::optional<VerificationError> {
+    auto offset = ReadImmediate<ptrdiff_t>(insts[index + immediate]);
+    if (offset < -static_cast<ptrdiff_t>(index) or
+        offset >= static_cast<ptrdiff_t>(insts.size() - index) or
+        not boundaries[index + offset]) {
+      return VerificationError{InvalidJumpTarget, index};
+    }
+    return reach(index + offset, height);
+  };
+
+  if (insts.empty()) { return VerificationError{FallsOffEnd, 0}; }
+  heights[0] = parameter_count;
+  worklist.push_back(0);
+
+  while (not worklist.empty()) {
+    size_t index = worklist.back();
+    worklist.pop_back();
+    ptrdiff_t height          = heights[index];
+    DepthEffect const &effect = *effect_at(index);
+
+    ptrdiff_t required = effect.required;
+    ptrdiff_t next     = height + effect.net;
+    switch (effect.kind) {
+      case DepthEffect::Static: break;
+      case DepthEffect::Determined: {
+        auto spec = ReadImmediate<InstructionSpecification>(insts[index + 1]);
+        required  = spec.parameters;
+        next      = height + spec.returns -
+               (effect.consumes_input ? spec.parameters : 0);
+      } break;
+      case DepthEffect::Call: {
+        auto spec = ReadImmediate<InstructionSpecification>(insts[index + 1]);
+        required  = ptrdiff_t{1} + spec.parameters;
+        next      = height - required + spec.returns;
+      } break;
+      case DepthEffect::CallDirect: {
+        auto spec = ReadImmediate<InstructionSpecification>(insts[index + 1]);
+        auto const *callee =
+            ReadImmediate<FunctionBase const *>(insts[index + 2]);
+        if (callee == nullptr or
+            spec.parameters != callee->parameter_count() or
+            spec.returns != callee->return_count()) {
+          return VerificationError{CalleeMismatch, index};
+        }
+        required = spec.parameters;
+        next      = height - required + spec.returns;
+      } break;
+      case DepthEffect::Switch: break;
+      case DepthEffect::Terminal: {
+        if (effect.immediate_value_count == 0) {
+          // `Return` hands every value on the stack to the caller.
+          next = height;
+        } else {
+          // `TailCall` leaves the values beneath its arguments in place, to be
+          // returned along with the callee's returns.
+          auto spec =
+              ReadImmediate<InstructionSpecification>(insts[index + 1]);
+          required = ptrdiff_t{1} + spec.parameters;
+          next     = height - required + spec.returns;
+        }
+      } break;
+    }
+    if (height < required) { return VerificationError{StackUnderflow, index}; }
+
+    if (effect.kind == DepthEffect::Terminal) {
+      if (next != return_count) {
+        return VerificationError{IncorrectReturnCount, index};
+      }
+      continue;
+    }
+
+    if (effect.kind == DepthEffect::Switch) {
+      auto count = ReadImmediate<size_t>(insts[index + 2]);
+      // The jump table entries are only reached via the `Switch`, with the
+      // key already popped.
+      if (count >= (insts.size() - index - 3) / 2) {
+        return VerificationError{MalformedJumpTable, index};
+      }
+      for (size_t i = 0; i <= count; ++i) {
+        size_t entry = index + 3 + 2 * i;
+        auto fn      = ReadImmediate<exec_fn_type>(insts[entry]);
+        if (fn != &Jump::ExecuteImpl<Set> and
+            fn != &Jump::ExecuteImpl<Set, false>) {
+          return VerificationError{MalformedJumpTable, index};
+        }
+        if (auto error = reach(entry, next)) { return error; }
+      }
+    }
+
+    if (effect.jump_index != 0) {
+      if (auto error = jump(index, effect.jump_index, next)) { return error; }
+    }
+    if (effect.falls_through) {
+      size_t successor = index + 1 + effect.immediate_value_count;
+      if (successor == insts.size()) {
+        return VerificationError{FallsOffEnd, index};
+      }
+      if (auto error = reach(successor, next)) { return error; }
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace internal
+
+template <InstructionSetType Set>
+std::optional<VerificationError> Verify(Function<Set> const &f) {
+  return internal::Verify<Set>(f.raw_instructions(), f.parameter_count(),
+                               f.return_count());
+}
+
+template <InstructionSetType Set>
+std::optional<VerificationError> VerifyAndFinalize(Function<Set> &f) {
+  if (auto error = Verify(f)) { return error; }
+  f.finalize();
+  return std::nullopt;
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_CORE_VERIFIER_H
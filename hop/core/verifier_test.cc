@@ -0,0 +1,159 @@
+#include "hop/core/verifier.h"
+
+#include "hop/core/function_builder.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+struct IsZero : hop::Instruction<IsZero> {
+  static constexpr void execute(Input<uint64_t> in, Output<bool> out) {
+    out.set<0>(in.get<0>() == 0);
+  }
+};
+
+struct Decrement : hop::Instruction<Decrement> {
+  static constexpr void consume(Input<uint64_t> in, Output<uint64_t> out) {
+    out.set<0>(in.get<0>() - 1);
+  }
+};
+
+struct PushU64 : hop::Instruction<PushU64> {
+  static constexpr void execute(Input<>, Output<uint64_t> out, uint64_t n) {
+    out.set<0>(n);
+  }
+};
+
+using Instructions = hop::MakeInstructionSet<IsZero, Decrement, PushU64>;
+
+using Builder = FunctionBuilder<Instructions>;
+
+NTH_TEST("verifier/loop") {
+  Builder builder(1, 1);
+  auto top  = builder.bound_label();
+  auto done = builder.label();
+  builder.append<IsZero>();
+  builder.append<JumpIf>(done);
+  builder.append<Decrement>();
+  builder.append<Jump>(top);
+  builder.bind(done);
+  builder.append<Return>();
+  Function<Instructions> f = std::move(builder).finalize();
+
+  NTH_EXPECT(Verify(f) == std::nullopt);
+  NTH_ASSERT(VerifyAndFinalize(f) == std::nullopt);
+  nth::stack<Value> stack = {uint64_t{5}};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{0});
+}
+
+NTH_TEST("verifier/switch") {
+  Builder builder(1, 1);
+  Builder::Label cases[] = {builder.label(), builder.label()};
+  auto otherwise         = builder.label();
+  builder.append<Switch>(4, cases, otherwise);
+  for (uint64_t n : {10, 20}) {
+    builder.bind(cases[n / 10 - 1]);
+    builder.append<PushU64>(n);
+    builder.append<Return>();
+  }
+  builder.bind(otherwise);
+  builder.append<PushU64>(0);
+  builder.append<Return>();
+  Function<Instructions> f = std::move(builder).finalize();
+  NTH_EXPECT(Verify(f) == std::nullopt);
+
+  // Truncate the jump table so that its default entry is missing.
+  Function<Instructions> g(1, 1);
+  g.raw_append(f.raw_instructions().first(7));
+  g.append<Return>();
+  NTH_EXPECT(Verify(g) ==
+             VerificationError{VerificationError::MalformedJumpTable, 0});
+}
+
+NTH_TEST("verifier/inconsistent-stack-height") {
+  Builder builder(1, 1);
+  auto join = builder.label();
+  builder.append<IsZero>();
+  builder.append<JumpIf>(join);
+  builder.append<PushU64>(1);
+  builder.bind(join);
+  builder.append<Return>();
+  Function<Instructions> f = std::move(builder).finalize();
+  NTH_EXPECT(Verify(f) ==
+             VerificationError{VerificationError::InconsistentStackHeight, 5});
+}
+
+NTH_TEST("verifier/stack-underflow") {
+  Function<Instructions> f(0, 1);
+  f.append<Decrement>();
+  f.append<Return>();
+  NTH_EXPECT(Verify(f) ==
+             VerificationError{VerificationError::StackUnderflow, 0});
+}
+
+NTH_TEST("verifier/incorrect-return-count") {
+  Function<Instructions> f(1, 1);
+  f.append<PushU64>(3);
+  f.append<Return>();
+  NTH_EXPECT(Verify(f) ==
+             VerificationError{VerificationError::IncorrectReturnCount, 2});
+}
+
+NTH_TEST("verifier/falls-off-end") {
+  Function<Instructions> f(1, 1);
+  NTH_EXPECT(Verify(f) == VerificationError{VerificationError::FallsOffEnd, 0});
+  f.append<Decrement>();
+  NTH_EXPECT(Verify(f) == VerificationError{VerificationError::FallsOffEnd, 0});
+}
+
+NTH_TEST("verifier/callee-mismatch") {
+  Function<Instructions> g(1, 1);
+  g.append<Decrement>();
+  g.append<Return>();
+
+  Function<Instructions> f(1, 1);
+  f.append<CallDirect>({.parameters = 1, .returns = 1}, &g);
+  f.append<Return>();
+  NTH_EXPECT(Verify(f) == std::nullopt);
+
+  Function<Instructions> h(2, 1);
+  h.append<CallDirect>({.parameters = 2, .returns = 1}, &g);
+  h.append<Return>();
+  NTH_EXPECT(Verify(h) ==
+             VerificationError{VerificationError::CalleeMismatch, 0});
+
+  Function<Instructions> k(1, 2);
+  k.append<CallDirect>({.parameters = 1, .returns = 2}, &g);
+  k.append<Return>();
+  NTH_EXPECT(Verify(k) ==
+             VerificationError{VerificationError::CalleeMismatch, 0});
+}
+
+NTH_TEST("verifier/invalid-jump-target") {
+  for (ptrdiff_t offset : {-1, 1, 3}) {
+    Function<Instructions> f(0, 0);
+    f.raw_append(&Jump::ExecuteImpl<Instructions>);
+    f.raw_append(offset);
+    f.append<Return>();
+    NTH_EXPECT(Verify(f) ==
+               VerificationError{VerificationError::InvalidJumpTarget, 0});
+  }
+}
+
+NTH_TEST("verifier/malformed-instructions") {
+  Function<Instructions> f(0, 0);
+  f.raw_append(uint64_t{1});
+  NTH_EXPECT(Verify(f) ==
+             VerificationError{VerificationError::UnknownInstruction, 0});
+
+  Function<Instructions> g(0, 1);
+  g.raw_append(&PushU64::ExecuteImpl<Instructions>);
+  NTH_EXPECT(Verify(g) ==
+             VerificationError{VerificationError::TruncatedInstruction, 0});
+}
+
+}  // namespace
+}  // namespace hop
@@ -39,6 +39,8 @@ concept Negatable = not std::same_as<bool, T> and requires(T t) {
 
 template <Addable T>
 struct Add : Instruction<Add<T>> {
+  static constexpr bool pure = true;
+
   static constexpr void consume(Input<T, T> in, Output<T> out) {
     out.template set<0>(in.template get<0>() + in.template get<1>());
   }
@@ -46,6 +48,8 @@ struct Add : Instruction<Add<T>> {
 
 template <Subtractable T>
 struct Subtract : Instruction<Subtract<T>> {
+  static constexpr bool pure = true;
+
   static constexpr void consume(Input<T, T> in, Output<T> out) {
     out.template set<0>(in.template get<0>() - in.template get<1>());
   }
@@ -53,6 +57,8 @@ struct Subtract : Instruction<Subtract<T>> {
 
 template <Multiplicable T>
 struct Multiply : Instruction<Multiply<T>> {
+  static constexpr bool pure = true;
+
   static constexpr void consume(Input<T, T> in, Output<T> out) {
     out.template set<0>(in.template get<0>() * in.template get<1>());
   }
@@ -74,6 +80,8 @@ struct Mod : Instruction<Mod<T>> {
 
 template <Negatable T>
 struct Negate : Instruction<Negate<T>> {
+  static constexpr bool pure = true;
+
   static constexpr void consume(Input<T> in, Output<T> out) {
     out.template set<0>(-in.template get<0>());
   }
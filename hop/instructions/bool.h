@@ -6,30 +6,40 @@
 namespace hop {
 
 struct Not : Instruction<Not> {
+  static constexpr bool pure = true;
+
   static void consume(Input<bool> in, Output<bool> out) {
     out.set<0>(not in.get<0>());
   }
 };
 
 struct Xor : Instruction<Xor> {
+  static constexpr bool pure = true;
+
   static void consume(Input<bool, bool> in, Output<bool> out) {
     out.set<0>(in.get<0>() xor in.get<1>());
   }
 };
 
 struct Or : Instruction<Or> {
+  static constexpr bool pure = true;
+
   static void consume(Input<bool, bool> in, Output<bool> out) {
     out.set<0>(in.get<0>() or in.get<1>());
   }
 };
 
 struct And : Instruction<And> {
+  static constexpr bool pure = true;
+
   static void consume(Input<bool, bool> in, Output<bool> out) {
     out.set<0>(in.get<0>() and in.get<1>());
   }
 };
 
 struct Nand : Instruction<Nand> {
+  static constexpr bool pure = true;
+
   static void consume(Input<bool, bool> in, Output<bool> out) {
     out.set<0>(not(in.get<0>() and in.get<1>()));
   }
@@ -9,6 +9,8 @@ namespace hop {
 
 template <typename T>
 struct Push : Instruction<Push<T>> {
+  static constexpr bool pure = true;
+
   static constexpr void execute(Input<>, Output<T> out, T v) {
     out.template set<0>(v);
   }
@@ -19,6 +21,8 @@ struct Push : Instruction<Push<T>> {
 };
 
 struct Drop : Instruction<Drop> {
+  static constexpr bool pure = true;
+
   static constexpr void consume(Input<Value>, Output<>) {}
 };
 
@@ -14,6 +14,8 @@ concept Comparable = requires(T t) {
 
 template <Comparable T>
 struct LessThan : Instruction<LessThan<T>> {
+  static constexpr bool pure = true;
+
   static constexpr void consume(Input<T, T> in, Output<bool> out) {
     out.set<0>(in.template get<0>() < in.template get<1>());
   }
@@ -21,6 +23,8 @@ struct LessThan : Instruction<LessThan<T>> {
 
 template <Comparable T>
 struct AppendLessThan : Instruction<AppendLessThan<T>> {
+  static constexpr bool pure = true;
+
   static constexpr void execute(Input<T, T> in, Output<bool> out) {
     out.set<0>(in.template get<0>() < in.template get<1>());
   }
@@ -33,6 +37,8 @@ concept Equatable = requires(T t) {
 
 template <Equatable T>
 struct Equal : Instruction<Equal<T>> {
+  static constexpr bool pure = true;
+
   static constexpr void consume(Input<T, T> in, Output<bool> out) {
     out.set<0>(in.template get<0>() == in.template get<1>());
   }
@@ -40,6 +46,8 @@ struct Equal : Instruction<Equal<T>> {
 
 template <Equatable T>
 struct AppendEqual : Instruction<AppendEqual<T>> {
+  static constexpr bool pure = true;
+
   static constexpr void execute(Input<T, T> in, Output<bool> out) {
     out.set<0>(in.template get<0>() == in.template get<1>());
   }
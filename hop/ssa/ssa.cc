@@ -11,6 +11,9 @@ enum {
   BuiltinJumpIf,
   BuiltinJumpIfNot,
   BuiltinReturn,
+  BuiltinCallDirect,
+  BuiltinTailCall,
+  BuiltinSwitch,
 };
 
 std::vector<uint64_t> BlockBoundaries(
@@ -27,6 +30,20 @@ std::vector<uint64_t> BlockBoundaries(
         p->as<internal::exec_fn_type>() == builtins[BuiltinJumpIfNot]*/) {
       block_boundaries.push_back(p - start + 2);
       block_boundaries.push_back((p - start) + (p + 1)->as<ptrdiff_t>());
+    } else if (p->as<internal::exec_fn_type>() == builtins[BuiltinTailCall]) {
+      block_boundaries.push_back(p - start + 2);
+    } else if (p->as<internal::exec_fn_type>() == builtins[BuiltinSwitch]) {
+      // The jump table following the `Switch` belongs to its block, and each
+      // of its entries begins a block at its target.
+      size_t count       = (p + 2)->as<size_t>();
+      Value const* entry = p + 3;
+      p                  = entry + 2 * (count + 1);
+      block_boundaries.push_back(p - start);
+      for (; entry != p; entry += 2) {
+        block_boundaries.push_back((entry - start) +
+                                   (entry + 1)->as<ptrdiff_t>());
+      }
+      continue;
     }
     p += metadata.immediate_value_count + 1;
   }
@@ -44,9 +61,16 @@ struct BasicBlockRegisterStack {
       : next_(first), registers_(registers) {}
 
   std::vector<SsaValue> AssignCall(InstructionSpecification spec) {
-    std::vector<SsaValue> parameters;
-    parameters.push_back(registers_.back());
+    SsaValue callee = registers_.back();
     registers_.pop_back();
+    return AssignCall(spec, callee);
+  }
+
+  std::vector<SsaValue> AssignCall(InstructionSpecification spec,
+                                   SsaValue callee) {
+    EnsureStackSize(spec.parameters);
+    std::vector<SsaValue> parameters;
+    parameters.push_back(callee);
     parameters.insert(parameters.end(), registers_.end() - spec.parameters,
                       registers_.end());
     registers_.resize(registers_.size() - spec.parameters, SsaRegister());
@@ -130,11 +154,26 @@ struct StackToSsaConverter {
 
       uint64_t output_count;
       std::vector<SsaValue> parameters;
-      if (inst == builtins_[BuiltinCall]) {
-        parameters = bb_reg_stack.AssignCall(
-            instructions[1].as<InstructionSpecification>());
+      if (inst == builtins_[BuiltinCall] or
+          inst == builtins_[BuiltinTailCall]) {
+        auto spec    = instructions[1].as<InstructionSpecification>();
+        parameters   = bb_reg_stack.AssignCall(spec);
         instructions = instructions.subspan(2);
-        output_count = instructions[1].as<InstructionSpecification>().returns;
+        output_count = spec.returns;
+      } else if (inst == builtins_[BuiltinCallDirect]) {
+        auto spec    = instructions[1].as<InstructionSpecification>();
+        parameters   = bb_reg_stack.AssignCall(
+            spec, SsaValue::Immediate(instructions[2]));
+        instructions = instructions.subspan(3);
+        output_count = spec.returns;
+      } else if (inst == builtins_[BuiltinSwitch]) {
+        // The jump table is represented by the branch of the block rather
+        // than by instructions.
+        size_t count = instructions[2].as<size_t>();
+        parameters   = bb_reg_stack.Assign(instructions.subspan(1, 2),
+                                           decode_(inst));
+        instructions = instructions.subspan(3 + 2 * (count + 1));
+        output_count = 0;
       } else if (inst == builtins_[BuiltinReturn]) {
         bb_reg_stack.EnsureStackSize(returns_);
         output_count = 0;
@@ -261,12 +300,41 @@ void SsaFunction::Initialize(InstructionMetadata const& (*decode)(Value),
           span.subspan(span.size() - false_size, false_size), true_block,
           span.subspan(span.size() - true_size, true_size)));
       block.remove_back();
+    } else if (block.instructions().back().op_code() ==
+               builtins[BuiltinSwitch]) {
+      auto const& inst = block.instructions().back();
+      uint64_t minimum = inst.argument(0).immediate().as<uint64_t>();
+      size_t count     = inst.argument(1).immediate().as<size_t>();
+      size_t table     = block_boundaries[i + 1] - 2 * (count + 1);
+      std::span span   = registers_on_exit[i];
+      std::vector<size_t> targets;
+      std::vector<std::span<SsaValue const>> arguments;
+      for (size_t entry = table; entry != block_boundaries[i + 1];
+           entry += 2) {
+        auto boundary_iter = std::lower_bound(
+            block_boundaries.begin(), block_boundaries.end(),
+            entry + instructions[entry + 1].as<ptrdiff_t>());
+        auto target = std::distance(block_boundaries.begin(), boundary_iter);
+        size_t size = blocks_[target].parameters().size();
+        targets.push_back(target);
+        arguments.push_back(span.subspan(span.size() - size, size));
+      }
+      block.set_branch(
+          SsaBranch::Switch(inst.argument(2), minimum, targets, arguments));
+      block.remove_back();
     } else if (block.instructions().back().op_code() ==
                builtins[BuiltinReturn]) {
       block.remove_back();
       std::span span = registers_on_exit[i];
       block.set_branch(SsaBranch::Return(
           span.subspan(span.size() - return_count_, return_count_)));
+    } else if (block.instructions().back().op_code() ==
+               builtins[BuiltinTailCall]) {
+      // A tail call is represented as a call whose results are returned
+      // immediately.
+      std::span span = registers_on_exit[i];
+      block.set_branch(SsaBranch::Return(
+          span.subspan(span.size() - return_count_, return_count_)));
     } else {
       NTH_REQUIRE((harden), not registers_on_exit.empty());
       size_t size    = blocks_[i + 1].parameters().size();
@@ -289,6 +357,13 @@ void SsaBranch::rename(nth::disjoint_set<SsaValue>& set) {
           for (auto& v : b.block_arguments) {
             if (auto h = set.find_representative(v); not h.empty()) { v = *h; }
           }
+        } else if constexpr (t == nth::type<SwitchImpl>) {
+          if (auto h = set.find_representative(b.value); not h.empty()) {
+            b.value = *h;
+          }
+          for (auto& v : b.block_arguments) {
+            if (auto h = set.find_representative(v); not h.empty()) { v = *h; }
+          }
         }
       },
       branch_);
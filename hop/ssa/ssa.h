@@ -19,7 +19,9 @@ namespace internal {
 template <InstructionSetType Set>
 constexpr std::array BuiltinPointers{
     &Call::ExecuteImpl<Set>, &Jump::ExecuteImpl<Set>, &JumpIf::ExecuteImpl<Set>,
-    &JumpIfNot::ExecuteImpl<Set>, &Return::ExecuteImpl<Set>};
+    &JumpIfNot::ExecuteImpl<Set>, &Return::ExecuteImpl<Set>,
+    &CallDirect::ExecuteImpl<Set>, &TailCall::ExecuteImpl<Set>,
+    &Switch::ExecuteImpl<Set>};
 
 void InsertNameDecodings(
     std::span<std::pair<exec_fn_type, std::string_view> const> pairs);
@@ -130,7 +132,13 @@ struct SsaInstruction {
   std::vector<SsaValue> arguments_;
 };
 
-enum class SsaBranchKind { Unreachable, Unconditional, Conditional, Return };
+enum class SsaBranchKind {
+  Unreachable,
+  Unconditional,
+  Conditional,
+  Return,
+  Switch
+};
 
 struct SsaBranch {
   struct ConditionalImpl {
@@ -149,6 +157,23 @@ struct SsaBranch {
     }
   };
 
+  struct SwitchImpl {
+    SsaValue value;
+    uint64_t minimum;
+    // The block to which each entry of the jump table branches. The last entry
+    // is taken when `value - minimum` is not less than `blocks.size() - 1`.
+    std::vector<size_t> blocks;
+    // The arguments passed to `blocks[i]` are those in `block_arguments` from
+    // `splits[i]` up to `splits[i + 1]`.
+    std::vector<size_t> splits;
+    std::vector<SsaValue> block_arguments;
+
+    std::span<SsaValue const> arguments(size_t i) const {
+      return std::span(block_arguments)
+          .subspan(splits[i], splits[i + 1] - splits[i]);
+    }
+  };
+
   SsaBranch() : SsaBranch(UnreachableImpl{}) {}
 
   SsaBranchKind kind() const {
@@ -159,6 +184,8 @@ struct SsaBranch {
     return std::get<ConditionalImpl>(branch_);
   }
 
+  SwitchImpl const &AsSwitch() const { return std::get<SwitchImpl>(branch_); }
+
   static SsaBranch Unreachable() { return SsaBranch(UnreachableImpl{}); }
   static SsaBranch Unconditional(size_t block, std::span<SsaValue const> args) {
     return SsaBranch(UnconditionalImpl{
@@ -191,6 +218,32 @@ struct SsaBranch {
       }
     }
   }
+  // Branches to `blocks[value - minimum]`, or to `blocks.back()` if there is
+  // no such entry, passing `arguments[i]` to `blocks[i]`.
+  static SsaBranch Switch(
+      SsaValue value, uint64_t minimum, std::span<size_t const> blocks,
+      std::span<std::span<SsaValue const> const> arguments) {
+    NTH_REQUIRE((harden), not blocks.empty());
+    NTH_REQUIRE((harden), blocks.size() == arguments.size());
+    if (value.is_register()) {
+      SwitchImpl impl{.value = value, .minimum = minimum};
+      impl.blocks.assign(blocks.begin(), blocks.end());
+      impl.splits.push_back(0);
+      for (std::span args : arguments) {
+        impl.block_arguments.insert(impl.block_arguments.end(), args.begin(),
+                                    args.end());
+        impl.splits.push_back(impl.block_arguments.size());
+      }
+      return SsaBranch(std::move(impl));
+    } else {
+      uint64_t index = value.immediate().raw_value() - minimum;
+      if (index >= blocks.size()) { index = blocks.size() - 1; }
+      return SsaBranch(UnconditionalImpl{
+          .block = blocks[index],
+          .block_arguments =
+              std::vector(arguments[index].begin(), arguments[index].end())});
+    }
+  }
   static SsaBranch Return(std::span<SsaValue const> arguments) {
     return SsaBranch(ReturnImpl{
         .block_arguments = std::vector(arguments.begin(), arguments.end()),
@@ -209,7 +262,7 @@ struct SsaBranch {
     std::vector<SsaValue> block_arguments;
   };
   using variant_type = std::variant<UnreachableImpl, UnconditionalImpl,
-                                    ConditionalImpl, ReturnImpl>;
+                                    ConditionalImpl, ReturnImpl, SwitchImpl>;
 
   explicit SsaBranch(variant_type branch) : branch_(std::move(branch)) {}
 
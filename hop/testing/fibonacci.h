@@ -0,0 +1,64 @@
+#ifndef JASMIN_TESTING_FIBONACCI_H
+#define JASMIN_TESTING_FIBONACCI_H
+
+#include "hop/core/function.h"
+#include "hop/core/instruction.h"
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "nth/debug/debug.h"
+#include "nth/meta/type.h"
+
+namespace hop {
+
+// How the function built by `BuildFibonacci` calls itself.
+enum class FibonacciCall {
+  // Pushes a pointer to the function with `Push<Function<> *>` and then
+  // executes `Call`.
+  Indirect,
+  // Executes `CallDirect`.
+  Direct,
+};
+
+// Appends to `f`, which must accept one parameter and return one value,
+// instructions computing the Fibonacci number indexed by its argument
+// recursively, as in "examples/fibonacci.cc". The instruction set `Set` must
+// contain `Duplicate`, `Swap`, `Push<uint64_t>`, `LessThan<uint64_t>`,
+// `Add<uint64_t>`, and `Subtract<uint64_t>`, as well as `Push<Function<> *>`
+// if `call` is `FibonacciCall::Indirect`. Tests and benchmarks throughout the
+// repository share this function so that their results are comparable.
+template <InstructionSetType Set>
+void BuildFibonacci(Function<Set> &f,
+                    FibonacciCall call = FibonacciCall::Indirect) {
+  auto recurse = [&] {
+    InstructionSpecification spec{.parameters = 1, .returns = 1};
+    if (call == FibonacciCall::Direct) {
+      f.template append<CallDirect>(spec, &f);
+    } else if constexpr (Set::instructions.template contains<
+                             nth::type<Push<Function<> *>>>()) {
+      f.template append<Push<Function<> *>>(&f);
+      f.template append<Call>(spec);
+    } else {
+      NTH_REQUIRE(call == FibonacciCall::Direct);
+    }
+  };
+  f.template append<Duplicate>();
+  f.template append<Push<uint64_t>>(2);
+  f.template append<LessThan<uint64_t>>();
+  auto jump = f.template append_with_placeholders<JumpIf>();
+  f.template append<Duplicate>();
+  f.template append<Push<uint64_t>>(1);
+  f.template append<Subtract<uint64_t>>();
+  recurse();
+  f.template append<Swap>();
+  f.template append<Push<uint64_t>>(2);
+  f.template append<Subtract<uint64_t>>();
+  recurse();
+  f.template append<Add<uint64_t>>();
+  auto ret = f.template append<Return>();
+  f.set_value(jump, 0, ret.lower_bound() - jump.lower_bound());
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_TESTING_FIBONACCI_H
@@ -0,0 +1,121 @@
+#ifndef JASMIN_TRANSFORM_DEAD_CODE_H
+#define JASMIN_TRANSFORM_DEAD_CODE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "hop/core/function.h"
+#include "hop/core/instruction.h"
+#include "hop/core/value.h"
+#include "hop/transform/rewriter.h"
+#include "nth/debug/debug.h"
+
+namespace hop {
+
+// Removes from `f` each basic block which cannot be reached from the entry of
+// the function, such as code following a `Jump` or `Return` that no jump
+// targets. Branches whose condition is constant are only recognized as never
+// taken once they have been removed by `FoldConstants` (see
+// "hop/transform/fold.h"), so that pass is best run first. Every entry of a
+// `Switch` jump table is considered reachable from the `Switch`. Returns the
+// number of bytes by which `f.raw_instructions()` shrank.
+template <InstructionSetType Set>
+size_t EliminateDeadCode(Function<Set> &f);
+
+namespace internal {
+
+// Returns the index into `rewriter.instructions()` of the first instruction of
+// each basic block, in increasing order, followed by the number of
+// instructions. As in the construction of an `SsaFunction`, a block begins at
+// the start of the function, at each jump target, and after each instruction
+// which jumps or does not fall through to its successor.
+template <InstructionSetType Set>
+std::vector<size_t> BasicBlockLeaders(BytecodeRewriter<Set> const &rewriter) {
+  auto const &effects = DepthEffects<Set>();
+  auto insts          = rewriter.instructions();
+  std::vector<size_t> leaders{0, insts.size()};
+  for (size_t i = 0; i < insts.size(); ++i) {
+    auto const &inst = insts[i];
+    if (rewriter.is_jump_target(inst.offset)) { leaders.push_back(i); }
+    DepthEffect const &effect = effects.at(inst.op_code);
+    if (effect.jump_index != 0 or not effect.falls_through or
+        effect.kind == DepthEffect::Terminal) {
+      leaders.push_back(i + 1);
+    }
+  }
+  std::sort(leaders.begin(), leaders.end());
+  leaders.erase(std::unique(leaders.begin(), leaders.end()), leaders.end());
+  return leaders;
+}
+
+}  // namespace internal
+
+template <InstructionSetType Set>
+size_t EliminateDeadCode(Function<Set> &f) {
+  auto const &effects = internal::DepthEffects<Set>();
+  BytecodeRewriter<Set> rewriter(f);
+  auto insts = rewriter.instructions();
+  if (insts.empty()) { return 0; }
+
+  std::vector<size_t> leaders = internal::BasicBlockLeaders(rewriter);
+  size_t block_count          = leaders.size() - 1;
+  // Returns the index of the block beginning with the `i`th instruction.
+  auto block_at = [&](size_t i) {
+    auto iter = std::lower_bound(leaders.begin(), leaders.end(), i);
+    NTH_REQUIRE((harden), iter != leaders.end() and *iter == i);
+    return static_cast<size_t>(iter - leaders.begin());
+  };
+  // Returns the index of the instruction whose op-code is at `offset`.
+  auto instruction_at = [&](size_t offset) {
+    auto iter = std::lower_bound(
+        insts.begin(), insts.end(), offset,
+        [](auto const &inst, size_t o) { return inst.offset < o; });
+    NTH_REQUIRE((harden), iter != insts.end() and iter->offset == offset);
+    return static_cast<size_t>(iter - insts.begin());
+  };
+
+  std::vector<bool> reachable(block_count, false);
+  std::vector<size_t> worklist;
+  auto reach = [&](size_t block) {
+    if (reachable[block]) { return; }
+    reachable[block] = true;
+    worklist.push_back(block);
+  };
+  reach(0);
+  while (not worklist.empty()) {
+    size_t block = worklist.back();
+    worklist.pop_back();
+    size_t last                         = leaders[block + 1] - 1;
+    auto const &inst                    = insts[last];
+    internal::DepthEffect const &effect = effects.at(inst.op_code);
+    if (effect.kind == internal::DepthEffect::Terminal) { continue; }
+    if (effect.kind == internal::DepthEffect::Switch) {
+      // Each entry of the jump table is its own block.
+      size_t count = inst.immediates[1].template as<size_t>();
+      for (size_t i = 0; i <= count; ++i) { reach(block_at(last + 1 + i)); }
+      continue;
+    }
+    if (auto target = rewriter.jump_target(inst)) {
+      reach(block_at(instruction_at(*target)));
+    }
+    if (effect.falls_through and block + 1 < block_count) {
+      reach(block + 1);
+    }
+  }
+
+  for (size_t block = 0; block < block_count; ++block) {
+    if (reachable[block]) {
+      for (size_t i = leaders[block]; i < leaders[block + 1]; ++i) {
+        rewriter.copy(i);
+      }
+    } else {
+      rewriter.remove(leaders[block], leaders[block + 1]);
+    }
+  }
+  return std::move(rewriter).finish(f) * sizeof(Value);
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_TRANSFORM_DEAD_CODE_H
@@ -0,0 +1,89 @@
+#include "hop/transform/dead_code.h"
+
+#include <utility>
+
+#include "hop/instructions/common.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+using Instructions = MakeInstructionSet<Push<uint64_t>>;
+
+NTH_TEST("dead-code/after-return") {
+  Function<Instructions> f(1, 1);
+  f.append<Return>();
+  f.append<Push<uint64_t>>(1);
+  f.append<Return>();
+
+  NTH_EXPECT(EliminateDeadCode(f) == 3 * sizeof(Value));
+  NTH_ASSERT(f.raw_instructions().size() == size_t{1});
+
+  nth::stack<Value> stack{uint64_t{5}};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{5});
+}
+
+NTH_TEST("dead-code/after-jump") {
+  Function<Instructions> f(0, 1);
+  auto jump = f.append_with_placeholders<Jump>();
+  f.append<Push<uint64_t>>(1);
+  f.append<Return>();
+  auto target = f.append<Push<uint64_t>>(2);
+  f.append<Return>();
+  f.set_value(jump, 0, target.lower_bound() - jump.lower_bound());
+
+  NTH_EXPECT(EliminateDeadCode(f) == 3 * sizeof(Value));
+  NTH_ASSERT(f.raw_instructions().size() == size_t{5});
+  NTH_EXPECT(f.raw_instructions()[1].as<ptrdiff_t>() == ptrdiff_t{2});
+
+  nth::stack<Value> stack;
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{2});
+}
+
+NTH_TEST("dead-code/branches") {
+  // Both successors of the conditional jump are reachable.
+  Function<Instructions> f(1, 1);
+  auto jump = f.append_with_placeholders<JumpIf>();
+  f.append<Push<uint64_t>>(10);
+  f.append<Return>();
+  auto target = f.append<Push<uint64_t>>(20);
+  f.append<Return>();
+  f.set_value(jump, 0, target.lower_bound() - jump.lower_bound());
+
+  NTH_EXPECT(EliminateDeadCode(f) == size_t{0});
+  NTH_EXPECT(f.raw_instructions().size() == size_t{8});
+}
+
+NTH_TEST("dead-code/switch") {
+  Function<Instructions> f(1, 1);
+  f.append<Switch>(0, 1);
+  auto entry    = f.append_with_placeholders<Jump>();
+  auto fallback = f.append_with_placeholders<Jump>();
+  f.append<Push<uint64_t>>(99);
+  f.append<Return>();
+  auto zero = f.append<Push<uint64_t>>(10);
+  f.append<Return>();
+  auto other = f.append<Push<uint64_t>>(20);
+  f.append<Return>();
+  f.set_value(entry, 0, zero.lower_bound() - entry.lower_bound());
+  f.set_value(fallback, 0, other.lower_bound() - fallback.lower_bound());
+
+  NTH_EXPECT(EliminateDeadCode(f) == 3 * sizeof(Value));
+  NTH_ASSERT(f.raw_instructions().size() == size_t{13});
+
+  for (auto [key, expected] : {std::pair<uint64_t, uint64_t>{0, 10},
+                               std::pair<uint64_t, uint64_t>{5, 20}}) {
+    nth::stack<Value> stack{key};
+    f.invoke(stack);
+    NTH_ASSERT(stack.size() == size_t{1});
+    NTH_EXPECT(stack.top().as<uint64_t>() == expected);
+  }
+}
+
+}  // namespace
+}  // namespace hop
@@ -0,0 +1,187 @@
+#ifndef JASMIN_TRANSFORM_FOLD_H
+#define JASMIN_TRANSFORM_FOLD_H
+
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "hop/core/function.h"
+#include "hop/core/instruction.h"
+#include "hop/core/output.h"
+#include "hop/core/value.h"
+#include "hop/instructions/common.h"
+#include "hop/transform/rewriter.h"
+
+namespace hop {
+
+// Evaluates ahead of time each pure instruction in `f` (see "PURE
+// INSTRUCTIONS" in "hop/core/instruction.h") whose inputs are all produced by
+// the `Push`es or pure instructions immediately preceding it, replacing them
+// with a `Push` of each value they leave on the stack. Each `JumpIf` or
+// `JumpIfNot` whose condition is computed in this way is replaced by a `Jump`
+// if the branch is always taken and removed otherwise. Folding never proceeds
+// across a jump target, and an instruction is only folded if the instruction
+// set contains `Push<T>` for each type `T` that it outputs. Returns the number
+// of instructions folded, not counting `Push`es.
+template <InstructionSetType Set>
+size_t FoldConstants(Function<Set> &f);
+
+namespace internal {
+
+// Describes how to evaluate a pure instruction ahead of time.
+struct ConstantFolder {
+  Value *(*evaluate)(Value *, Value const *, FrameBase *);
+  size_t parameters;
+  bool consumes_input;
+  // The op-code of the `Push` instruction reproducing each output.
+  std::vector<exec_fn_type> pushes;
+};
+
+template <typename Set, typename O>
+struct PushedOutputs : std::false_type {};
+
+template <typename Set, typename... Ts>
+struct PushedOutputs<Set, Output<Ts...>>
+    : std::bool_constant<(
+          Set::instructions.template contains<nth::type<Push<Ts>>>() and
+          ...)> {
+  static std::vector<exec_fn_type> pushes() {
+    return {&Push<Ts>::template ExecuteImpl<Set>...};
+  }
+};
+
+// Returns a `ConstantFolder` for each pure instruction in `Set` whose outputs
+// can be pushed as immediate values, keyed by its op-code.
+template <InstructionSetType Set>
+absl::flat_hash_map<exec_fn_type, ConstantFolder> ConstantFolders() {
+  absl::flat_hash_map<exec_fn_type, ConstantFolder> folders;
+  Set::instructions.each([&](auto t) {
+    using T = nth::type_t<t>;
+    if constexpr (PureInstruction<T>()) {
+      using output_type = nth::type_t<
+          InstructionFunctionType<T>().parameters().template get<1>()>;
+      using outputs = PushedOutputs<Set, output_type>;
+      if constexpr (outputs::value) {
+        folders.emplace(&T::template ExecuteImpl<Set>,
+                        ConstantFolder{
+                            .evaluate       = &ExecuteBody<T, Set>,
+                            .parameters     = ParameterCount<T>(),
+                            .consumes_input = ConsumesInput<T>(),
+                            .pushes         = outputs::pushes(),
+                        });
+      }
+    }
+  });
+  return folders;
+}
+
+}  // namespace internal
+
+template <InstructionSetType Set>
+size_t FoldConstants(Function<Set> &f) {
+  absl::flat_hash_map folders = internal::ConstantFolders<Set>();
+  if (folders.empty()) { return 0; }
+
+  internal::exec_fn_type jump        = &Jump::ExecuteImpl<Set>;
+  internal::exec_fn_type jump_if     = &JumpIf::ExecuteImpl<Set>;
+  internal::exec_fn_type jump_if_not = &JumpIfNot::ExecuteImpl<Set>;
+
+  struct Constant {
+    internal::exec_fn_type push;
+    Value value;
+  };
+
+  BytecodeRewriter<Set> rewriter(f);
+  auto insts = rewriter.instructions();
+  // The values known to be on top of the stack before the `i`th instruction,
+  // each computed by instructions in `[begin, i)`.
+  std::vector<Constant> constants;
+  std::vector<Value> values;
+  size_t begin  = 0;
+  size_t folded = 0;
+
+  using jump_type = typename BytecodeRewriter<Set>::jump;
+
+  // Replaces the instructions in `[begin, end)` with `Push`es of `constants`,
+  // followed by `extra`, whose relative jump offsets are described by `jumps`.
+  auto flush = [&](size_t end, std::span<Value const> extra = {},
+                   std::span<jump_type const> jumps = {}) {
+    values.clear();
+    for (auto const &[push, value] : constants) {
+      values.push_back(push);
+      values.push_back(value);
+    }
+    std::vector<jump_type> shifted;
+    for (auto j : jumps) {
+      j.origin += values.size();
+      j.index += values.size();
+      shifted.push_back(j);
+    }
+    values.insert(values.end(), extra.begin(), extra.end());
+    rewriter.replace(begin, end, values, shifted);
+    constants.clear();
+    begin = end;
+  };
+
+  std::vector<Value> window;
+  for (size_t i = 0; i < insts.size(); ++i) {
+    auto const &inst = insts[i];
+    if (rewriter.is_jump_target(inst.offset)) { flush(i); }
+
+    if (auto iter = folders.find(inst.op_code); iter != folders.end()) {
+      auto const &folder = iter->second;
+      if (folder.parameters <= constants.size()) {
+        window.clear();
+        for (auto const &c : constants) { window.push_back(c.value); }
+        size_t height = window.size();
+        window.resize(height + folder.pushes.size());
+        Value *head = folder.evaluate(window.data() + height,
+                                      inst.immediates.data(), nullptr);
+        size_t kept =
+            height - (folder.consumes_input ? folder.parameters : 0);
+        constants.erase(constants.begin() + kept, constants.end());
+        for (size_t j = kept; j < static_cast<size_t>(head - window.data());
+             ++j) {
+          constants.push_back({.push  = folder.pushes[j - kept],
+                               .value = window[j]});
+        }
+        if (folder.parameters != 0) { ++folded; }
+        continue;
+      }
+    }
+
+    if ((inst.op_code == jump_if or inst.op_code == jump_if_not) and
+        not constants.empty()) {
+      bool taken = constants.back().value.template as<bool>() ==
+                   (inst.op_code == jump_if);
+      constants.pop_back();
+      if (taken) {
+        Value replacement[] = {jump, Value::Uninitialized()};
+        jump_type jumps[]   = {{
+            .origin = 0,
+            .index  = 1,
+            .target = *rewriter.jump_target(inst),
+        }};
+        flush(i + 1, replacement, jumps);
+      } else {
+        flush(i + 1);
+      }
+      ++folded;
+      continue;
+    }
+
+    flush(i);
+    rewriter.copy(i);
+    begin = i + 1;
+  }
+  flush(insts.size());
+
+  std::move(rewriter).finish(f);
+  return folded;
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_TRANSFORM_FOLD_H
@@ -0,0 +1,118 @@
+#include "hop/transform/fold.h"
+
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+using Instructions =
+    MakeInstructionSet<Push<uint64_t>, Push<bool>, Add<uint64_t>,
+                       Multiply<uint64_t>, LessThan<uint64_t>>;
+
+// Appends a conditional jump `I` on whether 1 < 2, returning 20 if the jump is
+// taken and 10 otherwise.
+template <typename I>
+void BuildBranch(Function<Instructions> &f) {
+  f.append<Push<uint64_t>>(1);
+  f.append<Push<uint64_t>>(2);
+  f.append<LessThan<uint64_t>>();
+  auto jump = f.append_with_placeholders<I>();
+  f.append<Push<uint64_t>>(10);
+  f.append<Return>();
+  auto target = f.append<Push<uint64_t>>(20);
+  f.append<Return>();
+  f.set_value(jump, 0, target.lower_bound() - jump.lower_bound());
+}
+
+NTH_TEST("fold/arithmetic") {
+  Function<Instructions> f(0, 1);
+  f.append<Push<uint64_t>>(2);
+  f.append<Push<uint64_t>>(3);
+  f.append<Add<uint64_t>>();
+  f.append<Push<uint64_t>>(4);
+  f.append<Multiply<uint64_t>>();
+  f.append<Return>();
+
+  NTH_EXPECT(FoldConstants(f) == size_t{2});
+  NTH_ASSERT(f.raw_instructions().size() == size_t{3});
+  NTH_EXPECT(f.raw_instructions()[0].as<internal::exec_fn_type>() ==
+             &Push<uint64_t>::ExecuteImpl<Instructions>);
+  NTH_EXPECT(f.raw_instructions()[1].as<uint64_t>() == uint64_t{20});
+
+  nth::stack<Value> stack;
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{20});
+}
+
+NTH_TEST("fold/partial") {
+  // Only the first `Add` has constant inputs.
+  Function<Instructions> f(1, 1);
+  f.append<Push<uint64_t>>(2);
+  f.append<Push<uint64_t>>(3);
+  f.append<Add<uint64_t>>();
+  f.append<Add<uint64_t>>();
+  f.append<Return>();
+
+  NTH_EXPECT(FoldConstants(f) == size_t{1});
+  NTH_EXPECT(f.raw_instructions().size() == size_t{4});
+
+  nth::stack<Value> stack{uint64_t{1}};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{6});
+}
+
+NTH_TEST("fold/branch-taken") {
+  Function<Instructions> f(0, 1);
+  BuildBranch<JumpIf>(f);
+
+  NTH_EXPECT(FoldConstants(f) == size_t{2});
+  NTH_ASSERT(f.raw_instructions().size() == size_t{8});
+  NTH_EXPECT(f.raw_instructions()[0].as<internal::exec_fn_type>() ==
+             &Jump::ExecuteImpl<Instructions>);
+  NTH_EXPECT(f.raw_instructions()[1].as<ptrdiff_t>() == ptrdiff_t{5});
+
+  nth::stack<Value> stack;
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{20});
+}
+
+NTH_TEST("fold/branch-not-taken") {
+  Function<Instructions> f(0, 1);
+  BuildBranch<JumpIfNot>(f);
+
+  NTH_EXPECT(FoldConstants(f) == size_t{2});
+  NTH_ASSERT(f.raw_instructions().size() == size_t{6});
+
+  nth::stack<Value> stack;
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{10});
+}
+
+NTH_TEST("fold/jump-target") {
+  // The second `Push` is the target of a jump, so the value it pushes must not
+  // be combined with the value pushed before the jump.
+  Function<Instructions> f(0, 1);
+  f.append<Push<uint64_t>>(1);
+  auto jump   = f.append_with_placeholders<Jump>();
+  auto target = f.append<Push<uint64_t>>(2);
+  f.append<Add<uint64_t>>();
+  f.append<Return>();
+  f.set_value(jump, 0, target.lower_bound() - jump.lower_bound());
+
+  NTH_EXPECT(FoldConstants(f) == size_t{0});
+  nth::stack<Value> stack;
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{3});
+}
+
+}  // namespace
+}  // namespace hop
@@ -0,0 +1,156 @@
+#ifndef JASMIN_TRANSFORM_FUSE_H
+#define JASMIN_TRANSFORM_FUSE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "hop/core/function.h"
+#include "hop/core/instruction.h"
+#include "hop/core/metadata.h"
+#include "hop/transform/rewriter.h"
+
+namespace hop {
+
+// Rewrites `f` so that each occurrence of the sequence of instructions `Is...`
+// is replaced with the superinstruction `Fused<Is...>`, for each such
+// superinstruction in `Set`. When several superinstructions match at the same
+// location, the longest one is chosen. Occurrences into whose interior some
+// jump lands are left unfused. Returns the number of dispatches removed from a
+// single straight-line execution of the entire function, i.e., the number of
+// instructions eliminated from `f`.
+template <InstructionSetType Set>
+size_t FuseInstructions(Function<Set> &f);
+
+// Returns a map from each sequence of `length` consecutive op-codes in `f` to
+// the number of times that sequence occurs. Sequences are not counted if a
+// jump lands in their interior, as they would not be fusable. Op-codes are
+// those given by `Metadata<Set>()`, so that candidates for fusion can be
+// reported by name via `InstructionMetadata::name`.
+template <InstructionSetType Set>
+absl::flat_hash_map<std::vector<uint16_t>, size_t> CountInstructionSequences(
+    Function<Set> const &f, size_t length);
+
+namespace internal {
+
+struct FusionPattern {
+  exec_fn_type fused;
+  std::vector<exec_fn_type> sequence;
+  bool branches;
+};
+
+template <InstructionSetType Set>
+std::vector<FusionPattern> FusionPatterns() {
+  std::vector<FusionPattern> patterns;
+  Set::instructions.each([&](auto t) {
+    using T = nth::type_t<t>;
+    if constexpr (FusedInstruction<T>()) {
+      T::fused_instructions.reduce([&](auto... ts) {
+        patterns.push_back({
+            .fused    = &T::template ExecuteImpl<Set>,
+            .sequence = {&nth::type_t<ts>::template ExecuteImpl<Set>...},
+            .branches = JumpImmediateIndex<T>() != 0,
+        });
+        return 0;
+      });
+    }
+  });
+  std::stable_sort(patterns.begin(), patterns.end(),
+                   [](auto const &l, auto const &r) {
+                     return l.sequence.size() > r.sequence.size();
+                   });
+  return patterns;
+}
+
+// Returns whether the `length` instructions starting at index `i` can be
+// fused, because no jump lands in their interior.
+template <InstructionSetType Set>
+bool Fusable(BytecodeRewriter<Set> const &rewriter, size_t i, size_t length) {
+  auto insts = rewriter.instructions();
+  if (i + length > insts.size()) { return false; }
+  for (size_t j = i + 1; j < i + length; ++j) {
+    if (rewriter.is_jump_target(insts[j].offset)) { return false; }
+  }
+  return true;
+}
+
+}  // namespace internal
+
+template <InstructionSetType Set>
+size_t FuseInstructions(Function<Set> &f) {
+  std::vector patterns = internal::FusionPatterns<Set>();
+  if (patterns.empty()) { return 0; }
+
+  BytecodeRewriter<Set> rewriter(f);
+  auto insts                  = rewriter.instructions();
+  size_t instructions_removed = 0;
+  std::vector<Value> values;
+  size_t i = 0;
+  while (i < insts.size()) {
+    auto iter = std::find_if(
+        patterns.begin(), patterns.end(), [&](auto const &pattern) {
+          size_t length = pattern.sequence.size();
+          return internal::Fusable(rewriter, i, length) and
+                 std::equal(pattern.sequence.begin(), pattern.sequence.end(),
+                            insts.begin() + i, insts.begin() + i + length,
+                            [](auto op_code, auto const &inst) {
+                              return op_code == inst.op_code;
+                            });
+        });
+    if (iter == patterns.end()) {
+      rewriter.copy(i++);
+      continue;
+    }
+
+    size_t length = iter->sequence.size();
+    values.clear();
+    values.push_back(iter->fused);
+    for (size_t j = i; j < i + length; ++j) {
+      values.insert(values.end(), insts[j].immediates.begin(),
+                    insts[j].immediates.end());
+    }
+
+    if (iter->branches) {
+      typename BytecodeRewriter<Set>::jump j{
+          .origin = 0,
+          .index  = values.size() - 1,
+          .target = *rewriter.jump_target(insts[i + length - 1]),
+      };
+      rewriter.replace(i, i + length, values, std::span(&j, 1));
+    } else {
+      rewriter.replace(i, i + length, values);
+    }
+    instructions_removed += length - 1;
+    i += length;
+  }
+
+  std::move(rewriter).finish(f);
+  return instructions_removed;
+}
+
+template <InstructionSetType Set>
+absl::flat_hash_map<std::vector<uint16_t>, size_t> CountInstructionSequences(
+    Function<Set> const &f, size_t length) {
+  absl::flat_hash_map<std::vector<uint16_t>, size_t> counts;
+  if (length == 0) { return counts; }
+
+  auto const &metadata = Metadata<Set>();
+  BytecodeRewriter<Set> rewriter(f);
+  auto insts = rewriter.instructions();
+  std::vector<uint16_t> key;
+  for (size_t i = 0; i + length <= insts.size(); ++i) {
+    if (not internal::Fusable(rewriter, i, length)) { continue; }
+    key.clear();
+    for (size_t j = i; j < i + length; ++j) {
+      key.push_back(metadata.opcode(insts[j].op_code));
+    }
+    ++counts[key];
+  }
+  return counts;
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_TRANSFORM_FUSE_H
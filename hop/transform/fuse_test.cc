@@ -0,0 +1,75 @@
+#include "hop/transform/fuse.h"
+
+#include "hop/instructions/common.h"
+#include "hop/instructions/compare.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+using PushLessThanJumpIf = Fused<Push<uint64_t>, LessThan<uint64_t>, JumpIf>;
+
+using Instructions =
+    MakeInstructionSet<Drop, Duplicate, Push<uint64_t>, LessThan<uint64_t>,
+                       PushLessThanJumpIf>;
+
+// Returns a function which returns its argument `n` if `n < 2` and returns 7
+// otherwise.
+Function<Instructions> MakeFunction() {
+  Function<Instructions> f(1, 1);
+  f.append<Duplicate>();
+  f.append<Push<uint64_t>>(2);
+  f.append<LessThan<uint64_t>>();
+  auto jump = f.append_with_placeholders<JumpIf>();
+  f.append<Drop>();
+  f.append<Push<uint64_t>>(7);
+  auto ret = f.append<Return>();
+  f.set_value(jump, 0, ret.lower_bound() - jump.lower_bound());
+  return f;
+}
+
+uint64_t Invoke(Function<Instructions> const &f, uint64_t n) {
+  nth::stack<Value> stack{n};
+  f.invoke(stack);
+  return stack.top().as<uint64_t>();
+}
+
+NTH_TEST("fuse/branch") {
+  Function<Instructions> f = MakeFunction();
+  NTH_ASSERT(f.raw_instructions().size() == size_t{10});
+  NTH_EXPECT(FuseInstructions(f) == size_t{2});
+  NTH_ASSERT(f.raw_instructions().size() == size_t{8});
+  NTH_EXPECT(f.raw_instructions()[1].as<internal::exec_fn_type>() ==
+             &PushLessThanJumpIf::ExecuteImpl<Instructions>);
+  NTH_EXPECT(Invoke(f, 1) == uint64_t{1});
+  NTH_EXPECT(Invoke(f, 5) == uint64_t{7});
+}
+
+NTH_TEST("fuse/interior-jump-target") {
+  Function<Instructions> f(1, 1);
+  f.append<Duplicate>();
+  f.append<Push<uint64_t>>(2);
+  auto target = f.append<LessThan<uint64_t>>();
+  auto jump   = f.append_with_placeholders<JumpIf>();
+  f.append<Return>();
+  f.set_value(jump, 0, target.lower_bound() - jump.lower_bound());
+  NTH_EXPECT(FuseInstructions(f) == size_t{0});
+  NTH_EXPECT(f.raw_instructions().size() == size_t{7});
+}
+
+NTH_TEST("fuse/count-sequences") {
+  Function<Instructions> f = MakeFunction();
+  auto const &metadata     = Metadata<Instructions>();
+  auto counts              = CountInstructionSequences(f, 3);
+  NTH_EXPECT(counts.size() == size_t{5});
+  std::vector<uint16_t> key{
+      metadata.opcode(&Push<uint64_t>::ExecuteImpl<Instructions>),
+      metadata.opcode(&LessThan<uint64_t>::ExecuteImpl<Instructions>),
+      metadata.opcode(&JumpIf::ExecuteImpl<Instructions>),
+  };
+  NTH_EXPECT(counts[key] == size_t{1});
+}
+
+}  // namespace
+}  // namespace hop
@@ -0,0 +1,90 @@
+#ifndef JASMIN_TRANSFORM_QUICKEN_H
+#define JASMIN_TRANSFORM_QUICKEN_H
+
+#include <cstddef>
+#include <type_traits>
+
+#include "absl/container/flat_hash_set.h"
+#include "hop/core/function.h"
+#include "hop/core/instruction.h"
+#include "hop/core/internal/function_base.h"
+#include "hop/core/value.h"
+#include "hop/instructions/common.h"
+#include "hop/transform/rewriter.h"
+
+namespace hop {
+
+// Rewrites each call site in `f` whose callee is pushed as an immediate value
+// immediately before the call, that is, each `Push<Function<>*>` followed by
+// `Call`, into a single `CallDirect`. Such call sites are monomorphic, and
+// `CallDirect` reads its callee from an immediate value rather than popping it
+// from the value stack. Call sites whose `Call` is the target of a jump are
+// left in place, as the callee may be pushed elsewhere; a `Push` which is the
+// target of a jump may still be rewritten, and the jump then targets the
+// resulting `CallDirect`. Returns the number of call sites rewritten. Indirect
+// calls to computed function pointers are not affected.
+template <InstructionSetType Set>
+size_t QuickenCalls(Function<Set> &f);
+
+namespace internal {
+
+template <typename I>
+struct PushesFunction : std::false_type {};
+
+template <typename P>
+struct PushesFunction<Push<P>>
+    : std::bool_constant<
+          std::is_pointer_v<P> and
+          std::is_base_of_v<FunctionBase,
+                            std::remove_cv_t<std::remove_pointer_t<P>>>> {};
+
+// Returns the op-codes of each instruction in `Set` which pushes a pointer to
+// a function held in its immediate value.
+template <InstructionSetType Set>
+absl::flat_hash_set<exec_fn_type> FunctionPushes() {
+  absl::flat_hash_set<exec_fn_type> pushes;
+  Set::instructions.each([&](auto t) {
+    using T = nth::type_t<t>;
+    if constexpr (PushesFunction<T>::value) {
+      pushes.insert(&T::template ExecuteImpl<Set>);
+    }
+  });
+  return pushes;
+}
+
+}  // namespace internal
+
+template <InstructionSetType Set>
+size_t QuickenCalls(Function<Set> &f) {
+  absl::flat_hash_set pushes = internal::FunctionPushes<Set>();
+  if (pushes.empty()) { return 0; }
+
+  internal::exec_fn_type call        = &Call::ExecuteImpl<Set>;
+  internal::exec_fn_type call_direct = &CallDirect::ExecuteImpl<Set>;
+
+  BytecodeRewriter<Set> rewriter(f);
+  auto insts       = rewriter.instructions();
+  size_t quickened = 0;
+  size_t i         = 0;
+  while (i < insts.size()) {
+    if (i + 1 == insts.size() or not pushes.contains(insts[i].op_code) or
+        insts[i + 1].op_code != call or
+        rewriter.is_jump_target(insts[i + 1].offset)) {
+      rewriter.copy(i++);
+      continue;
+    }
+    // `CallDirect` holds the specification of the call followed by the callee.
+    Value values[] = {call_direct, insts[i + 1].immediates[0],
+                      insts[i].immediates[0]};
+    rewriter.replace(i, i + 2, values);
+    ++quickened;
+    i += 2;
+  }
+
+  std::move(rewriter).finish(f);
+  return quickened;
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_TRANSFORM_QUICKEN_H
@@ -0,0 +1,62 @@
+#include "hop/transform/quicken.h"
+
+#include "hop/instructions/arithmetic.h"
+#include "hop/instructions/common.h"
+#include "nth/container/stack.h"
+#include "nth/test/test.h"
+
+namespace hop {
+namespace {
+
+using Instructions =
+    MakeInstructionSet<Push<uint64_t>, Push<Function<> *>, Add<uint64_t>>;
+
+NTH_TEST("quicken/call") {
+  Function<Instructions> increment(1, 1);
+  increment.append<Push<uint64_t>>(1);
+  increment.append<Add<uint64_t>>();
+  increment.append<Return>();
+
+  Function<Instructions> f(1, 1);
+  f.append<Push<Function<> *>>(&increment);
+  f.append<Call>({.parameters = 1, .returns = 1});
+  f.append<Push<Function<> *>>(&increment);
+  f.append<Call>({.parameters = 1, .returns = 1});
+  f.append<Return>();
+  NTH_ASSERT(f.raw_instructions().size() == size_t{9});
+
+  NTH_EXPECT(QuickenCalls(f) == size_t{2});
+  NTH_ASSERT(f.raw_instructions().size() == size_t{7});
+  NTH_EXPECT(f.raw_instructions()[0].as<internal::exec_fn_type>() ==
+             &CallDirect::ExecuteImpl<Instructions>);
+  NTH_EXPECT(f.raw_instructions()[3].as<internal::exec_fn_type>() ==
+             &CallDirect::ExecuteImpl<Instructions>);
+
+  nth::stack<Value> stack{uint64_t{3}};
+  f.invoke(stack);
+  NTH_ASSERT(stack.size() == size_t{1});
+  NTH_EXPECT(stack.top().as<uint64_t>() == uint64_t{5});
+}
+
+NTH_TEST("quicken/jump-target") {
+  Function<Instructions> identity(0, 0);
+  identity.append<Return>();
+
+  // The `Call` is the target of a jump whose callee is pushed elsewhere, so it
+  // must not be fused with the preceding `Push`.
+  Function<Instructions> f(0, 0);
+  f.append<Push<Function<> *>>(&identity);
+  auto jump = f.append_with_placeholders<Jump>();
+  f.append<Push<Function<> *>>(&identity);
+  auto call = f.append<Call>({.parameters = 0, .returns = 0});
+  f.append<Return>();
+  f.set_value(jump, 0, call.lower_bound() - jump.lower_bound());
+
+  NTH_EXPECT(QuickenCalls(f) == size_t{0});
+  nth::stack<Value> stack;
+  f.invoke(stack);
+  NTH_EXPECT(stack.size() == size_t{0});
+}
+
+}  // namespace
+}  // namespace hop
@@ -0,0 +1,219 @@
+#ifndef JASMIN_TRANSFORM_REWRITER_H
+#define JASMIN_TRANSFORM_REWRITER_H
+
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "hop/core/function.h"
+#include "hop/core/instruction.h"
+#include "hop/core/metadata.h"
+#include "hop/core/value.h"
+#include "nth/debug/debug.h"
+
+namespace hop {
+namespace internal {
+
+// Returns the index, relative to the op-code, of the immediate value holding
+// a relative jump offset for the instruction `I`, or zero if `I` does not
+// jump.
+template <typename I>
+constexpr size_t JumpImmediateIndex() {
+  if constexpr (nth::any_of<I, Jump, JumpIf, JumpIfNot>) {
+    return 1;
+  } else if constexpr (FusedInstruction<I>()) {
+    constexpr auto fused = I::fused_instructions;
+    constexpr auto last  = fused.template get<fused.size() - 1>();
+    if constexpr (nth::any_of<nth::type_t<last>, Jump, JumpIf, JumpIfNot>) {
+      return ImmediateValueCount<I>();
+    } else {
+      return 0;
+    }
+  } else {
+    return 0;
+  }
+}
+
+}  // namespace internal
+
+// A `BytecodeRewriter` constructs a new sequence of instructions from those of
+// an existing function. Each instruction of the original function must be
+// visited exactly once, in order, by one of `copy`, `replace`, or `remove`.
+// Relative jump offsets in copied instructions are rewritten automatically so
+// that they continue to land on the same instruction (or, if that instruction
+// was removed, the first instruction emitted after it). All offsets are
+// measured as indices into `Function<Set>::raw_instructions()`. The function
+// must not have been finalized.
+template <InstructionSetType Set>
+struct BytecodeRewriter {
+  struct instruction {
+    // The offset of the op-code in the original function.
+    size_t offset;
+    internal::exec_fn_type op_code;
+    std::span<Value const> immediates;
+  };
+
+  // Describes a relative jump offset in a replacement sequence.
+  struct jump {
+    // The index in the replacement of the op-code from which the jump is
+    // measured.
+    size_t origin;
+    // The index in the replacement of the immediate value holding the offset.
+    size_t index;
+    // The offset of the instruction in the original function being jumped to.
+    size_t target;
+  };
+
+  explicit BytecodeRewriter(Function<Set> const &f);
+
+  // Returns the instructions of the original function.
+  std::span<instruction const> instructions() const { return instructions_; }
+
+  // Returns the offset in the original function to which `inst` may jump, or
+  // `std::nullopt` if `inst` does not jump.
+  std::optional<size_t> jump_target(instruction const &inst) const;
+
+  // Returns whether any instruction in the original function jumps to the
+  // given `offset`.
+  bool is_jump_target(size_t offset) const {
+    return jump_targets_.contains(offset);
+  }
+
+  // Emits the `i`th instruction unchanged, other than its jump offsets.
+  void copy(size_t i);
+
+  // Replaces the instructions with indices in `[begin, end)` with `values`.
+  // Any relative jump offsets in `values` must be described by `jumps`.
+  void replace(size_t begin, size_t end, std::span<Value const> values,
+               std::span<jump const> jumps = {});
+
+  // Removes the instructions with indices in `[begin, end)`.
+  void remove(size_t begin, size_t end) { replace(begin, end, {}); }
+
+  // Overwrites `f` with the rewritten instructions, returning the number of
+  // `Value`s by which the function shrank.
+  size_t finish(Function<Set> &f) &&;
+
+ private:
+  static constexpr size_t Unmapped = std::numeric_limits<size_t>::max();
+
+  void map(size_t begin, size_t end);
+
+  absl::flat_hash_map<internal::exec_fn_type, size_t> jump_indices_;
+  std::vector<instruction> instructions_;
+  absl::flat_hash_set<size_t> jump_targets_;
+  std::vector<size_t> offsets_;
+  std::vector<Value> output_;
+  // Jumps whose `origin` and `index` are positions in `output_`.
+  std::vector<jump> pending_jumps_;
+  size_t next_ = 0;
+};
+
+template <InstructionSetType Set>
+BytecodeRewriter<Set>::BytecodeRewriter(Function<Set> const &f) {
+  // Finalized functions hold op-codes which do not check stack capacity, and
+  // which are not recognized below.
+  NTH_REQUIRE((harden), f.max_stack_depth() == 0);
+  Set::instructions.each([&](auto t) {
+    using T = nth::type_t<t>;
+    if constexpr (internal::JumpImmediateIndex<T>() != 0) {
+      jump_indices_.emplace(&T::template ExecuteImpl<Set>,
+                            internal::JumpImmediateIndex<T>());
+    }
+  });
+
+  auto const &metadata = Metadata<Set>();
+  std::span insts      = f.raw_instructions();
+  size_t offset        = 0;
+  while (offset < insts.size()) {
+    size_t immediate_value_count =
+        metadata.metadata(metadata.opcode(insts[offset]))
+            .immediate_value_count;
+    instructions_.push_back({
+        .offset     = offset,
+        .op_code    = insts[offset].template as<internal::exec_fn_type>(),
+        .immediates = insts.subspan(offset + 1, immediate_value_count),
+    });
+    if (auto target = jump_target(instructions_.back())) {
+      jump_targets_.insert(*target);
+    }
+    offset += immediate_value_count + 1;
+  }
+  offsets_.resize(insts.size() + 1, Unmapped);
+}
+
+template <InstructionSetType Set>
+std::optional<size_t> BytecodeRewriter<Set>::jump_target(
+    instruction const &inst) const {
+  auto iter = jump_indices_.find(inst.op_code);
+  if (iter == jump_indices_.end()) { return std::nullopt; }
+  return inst.offset + inst.immediates[iter->second - 1].as<ptrdiff_t>();
+}
+
+template <InstructionSetType Set>
+void BytecodeRewriter<Set>::map(size_t begin, size_t end) {
+  NTH_REQUIRE((harden), begin == next_);
+  NTH_REQUIRE((harden), begin <= end);
+  NTH_REQUIRE((harden), end <= instructions_.size());
+  for (size_t i = begin; i < end; ++i) {
+    offsets_[instructions_[i].offset] = output_.size();
+  }
+  next_ = end;
+}
+
+template <InstructionSetType Set>
+void BytecodeRewriter<Set>::copy(size_t i) {
+  map(i, i + 1);
+  auto const &inst = instructions_[i];
+  if (auto target = jump_target(inst)) {
+    pending_jumps_.push_back({
+        .origin = output_.size(),
+        .index  = output_.size() + jump_indices_.at(inst.op_code),
+        .target = *target,
+    });
+  }
+  output_.push_back(inst.op_code);
+  output_.insert(output_.end(), inst.immediates.begin(), inst.immediates.end());
+}
+
+template <InstructionSetType Set>
+void BytecodeRewriter<Set>::replace(size_t begin, size_t end,
+                                    std::span<Value const> values,
+                                    std::span<jump const> jumps) {
+  map(begin, end);
+  for (auto const &j : jumps) {
+    pending_jumps_.push_back({
+        .origin = output_.size() + j.origin,
+        .index  = output_.size() + j.index,
+        .target = j.target,
+    });
+  }
+  output_.insert(output_.end(), values.begin(), values.end());
+}
+
+template <InstructionSetType Set>
+size_t BytecodeRewriter<Set>::finish(Function<Set> &f) && {
+  NTH_REQUIRE((harden), next_ == instructions_.size());
+  offsets_.back() = output_.size();
+  for (auto const &j : pending_jumps_) {
+    size_t target = offsets_[j.target];
+    NTH_REQUIRE((harden), target != Unmapped);
+    output_[j.index] =
+        static_cast<ptrdiff_t>(target) - static_cast<ptrdiff_t>(j.origin);
+  }
+
+  size_t original_size = f.raw_instructions().size();
+  Function<Set> result(f.parameter_count(), f.return_count());
+  result.reserve(output_.size() + 1);
+  for (Value v : output_) { result.raw_append(v); }
+  f = std::move(result);
+  return original_size - output_.size();
+}
+
+}  // namespace hop
+
+#endif  // JASMIN_TRANSFORM_REWRITER_H